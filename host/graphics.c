@@ -0,0 +1,920 @@
+/****************************************************************************/
+/**
+* Host stand-in for the Pebble SDK: drawing and resources.
+*
+* Resources are read from the files appinfo.json names, under the resources
+* directory. PNG images are decoded into the same 1-bit format the SDK uses,
+* which is all the app's images need.
+*
+* Drawing goes to a 1-bit frame the size of the screen, so tests can count
+* the pixels each redraw changed and compare a frame with a saved one. Rects,
+* round rects, bitmaps with every compositing mode and the inverter layer are
+* drawn. Text layers draw only their background: there is no font renderer,
+* and the app draws everything that matters from its glyph atlas.
+*
+* @file   graphics.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <zlib.h>
+#include "internal.h"
+
+
+#ifndef HOST_RESOURCES
+#define HOST_RESOURCES  "resources"
+#endif
+
+/* What drawing is taken to cost on the watch, for host_model_time(). These
+* are round guesses for a 64 MHz Cortex-M3 filling a 1-bit frame buffer, not
+* measurements: setting up one call, each pixel it touches, and finding a
+* glyph in a font.
+*/
+#define DRAW_CALL_US    (20)
+#define DRAW_PIXEL_NS   (250)
+#define DRAW_GLYPH_US   (30)
+
+typedef struct _Resource
+{
+    uint32_t id;
+    const char *file;
+    uint8_t *data;              /* loaded on first use */
+    size_t size;
+}
+Resource;
+
+struct GContext
+{
+    GPoint offset;              /* screen position of the layer's origin */
+    GRect clip;                 /* screen coordinates */
+    GColor stroke_color;
+    GColor fill_color;
+    GCompOp compositing_mode;
+};
+
+/* The screen, one byte per pixel, 1 = white. */
+static uint8_t frame[HOST_SCREEN_H][HOST_SCREEN_W];
+static uint32_t draw_ns;        /* modelled drawing time under a us */
+
+static Resource resources[] =
+{
+    { RESOURCE_ID_IMAGE_MENU_ICON, "images/icon.png" },
+    { RESOURCE_ID_IMAGE_STATUS_BAR, "images/status_bar_black.png" },
+    { RESOURCE_ID_FONT_ROBOTO_CONDENSED_14, "fonts/Roboto-Condensed.ttf" },
+    { RESOURCE_ID_IMAGE_GLYPH_ATLAS, "images/glyph_atlas.png" },
+    { RESOURCE_ID_ZONE_TABLE, "data/zones.bin" },
+};
+
+
+/****************************************************************************/
+/* Resources.                                                               */
+/****************************************************************************/
+
+static Resource *resource_find(uint32_t id)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(resources) / sizeof(resources[0]); i++)
+    {
+        if (resources[i].id == id)
+        {
+            return &resources[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+static bool resource_read(Resource *r)
+{
+    char path[256];
+    FILE *f;
+    long size;
+
+    if (r->data)
+    {
+        return true;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s", HOST_RESOURCES, r->file);
+    f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    r->data = malloc(size);
+    r->size = fread(r->data, 1, size, f);
+    fclose(f);
+
+    return true;
+}
+
+
+const uint8_t *resource_data(uint32_t resource_id, size_t *size)
+{
+    Resource *r = resource_find(resource_id);
+
+    if (r == NULL || !resource_read(r))
+    {
+        return NULL;
+    }
+
+    *size = r->size;
+
+    return r->data;
+}
+
+
+ResHandle resource_get_handle(uint32_t resource_id)
+{
+    return resource_find(resource_id);
+}
+
+
+size_t resource_size(ResHandle h)
+{
+    Resource *r = (Resource *)h;
+
+    return r && resource_read(r) ? r->size : 0;
+}
+
+
+size_t resource_load_byte_range(ResHandle h,
+                                uint32_t start_offset,
+                                uint8_t *buffer,
+                                size_t num_bytes)
+{
+    Resource *r = (Resource *)h;
+
+    if (r == NULL || !resource_read(r) || start_offset >= r->size)
+    {
+        return 0;
+    }
+
+    if (num_bytes > r->size - start_offset)
+    {
+        num_bytes = r->size - start_offset;
+    }
+    host_flash_read(HOST_RESOURCE_US, num_bytes);
+    memcpy(buffer, r->data + start_offset, num_bytes);
+
+    return num_bytes;
+}
+
+
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length)
+{
+    return resource_load_byte_range(h, 0, buffer, max_length);
+}
+
+
+/* Fonts are only ever handed back to the stand-in, which doesn't rasterize
+* TrueType, so the handle will do. The watch reads the header now and the
+* glyphs as they are drawn.
+*/
+GFont fonts_load_custom_font(ResHandle handle)
+{
+    host_flash_read(HOST_RESOURCE_US, 0);
+
+    return (GFont)handle;
+}
+
+
+void fonts_unload_custom_font(GFont font)
+{
+}
+
+
+/****************************************************************************/
+/* Bitmaps.                                                                 */
+/****************************************************************************/
+
+static GBitmap *bitmap_create(int w, int h)
+{
+    GBitmap *bitmap = host_zalloc(sizeof(GBitmap));
+
+    if (bitmap)
+    {
+        bitmap->row_size_bytes = ((w + 31) / 32) * 4;
+        bitmap->bounds = GRect(0, 0, w, h);
+        bitmap->addr = host_zalloc(h * bitmap->row_size_bytes);
+        bitmap->info_flags = 1;         /* owns addr */
+    }
+
+    return bitmap;
+}
+
+
+static uint32_t be32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+
+static int paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+}
+
+
+/* Decode a non-interlaced PNG into a 1-bit bitmap, setting pixels whose
+* gray level is at least half. Handles gray, gray with alpha, RGB, RGBA and
+* palette images, which covers what appinfo.json lists.
+*/
+static GBitmap *png_decode(const uint8_t *png, size_t size)
+{
+    const uint8_t *palette = NULL;
+    uint8_t *z = NULL;
+    uint8_t *raw = NULL;
+    GBitmap *bitmap = NULL;
+    size_t zlen = 0;
+    size_t pos = 8;
+    uint32_t w = 0;
+    uint32_t h = 0;
+    int depth = 0;
+    int type = 0;
+    int channels;
+    int bpp;
+    size_t stride;
+    uLongf rawlen;
+    uint32_t x;
+    uint32_t y;
+
+    while (pos + 8 <= size)
+    {
+        uint32_t len = be32(png + pos);
+        const uint8_t *tag = png + pos + 4;
+        const uint8_t *data = png + pos + 8;
+
+        if (memcmp(tag, "IHDR", 4) == 0)
+        {
+            w = be32(data);
+            h = be32(data + 4);
+            depth = data[8];
+            type = data[9];
+        }
+        else if (memcmp(tag, "PLTE", 4) == 0)
+        {
+            palette = data;
+        }
+        else if (memcmp(tag, "IDAT", 4) == 0)
+        {
+            z = realloc(z, zlen + len);
+            memcpy(z + zlen, data, len);
+            zlen += len;
+        }
+
+        pos += 12 + len;
+    }
+
+    channels = type == 2 ? 3 : type == 4 ? 2 : type == 6 ? 4 : 1;
+    bpp = (channels * depth + 7) / 8;
+    stride = (w * channels * depth + 7) / 8;
+    rawlen = (stride + 1) * h;
+    raw = malloc(rawlen);
+    if (z == NULL || uncompress(raw, &rawlen, z, zlen) != Z_OK)
+    {
+        goto error_0;
+    }
+
+    /* Undo the row filters in place.
+    */
+    for (y = 0; y < h; y++)
+    {
+        uint8_t *row = raw + y * (stride + 1) + 1;
+        uint8_t *prev = y ? row - (stride + 1) : NULL;
+        int filter = row[-1];
+        size_t i;
+
+        for (i = 0; i < stride; i++)
+        {
+            int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+            int b = prev ? prev[i] : 0;
+            int c = prev && i >= (size_t)bpp ? prev[i - bpp] : 0;
+
+            row[i] += filter == 1 ? a
+                    : filter == 2 ? b
+                    : filter == 3 ? (a + b) / 2
+                    : filter == 4 ? paeth(a, b, c)
+                    : 0;
+        }
+    }
+
+    bitmap = bitmap_create(w, h);
+    for (y = 0; y < h; y++)
+    {
+        const uint8_t *row = raw + y * (stride + 1) + 1;
+        uint8_t *out = (uint8_t *)bitmap->addr + y * bitmap->row_size_bytes;
+
+        for (x = 0; x < w; x++)
+        {
+            int level;
+
+            if (depth < 8)
+            {
+                int shift = 8 - depth - (x * depth) % 8;
+
+                level = (row[x * depth / 8] >> shift) & ((1 << depth) - 1);
+                level = type == 3 ? level : level * 255 / ((1 << depth) - 1);
+            }
+            else
+            {
+                level = row[x * bpp];
+            }
+
+            if (type == 3 && palette)
+            {
+                level = palette[level * 3];
+            }
+
+            if (level >= 128)
+            {
+                out[x / 8] |= 1 << (x % 8);
+            }
+        }
+    }
+
+error_0:
+    free(raw);
+    free(z);
+    return bitmap;
+}
+
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id)
+{
+    const uint8_t *data;
+    size_t size;
+
+    data = resource_data(resource_id, &size);
+    if (data == NULL)
+    {
+        return NULL;
+    }
+
+    host_flash_read(HOST_RESOURCE_US, size);
+    return png_decode(data, size);
+}
+
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap,
+                                      GRect sub_rect)
+{
+    GBitmap *bitmap = host_malloc(sizeof(GBitmap));
+
+    if (bitmap)
+    {
+        *bitmap = *base_bitmap;
+        bitmap->bounds = sub_rect;
+        bitmap->info_flags = 0;
+    }
+
+    return bitmap;
+}
+
+
+void gbitmap_destroy(GBitmap *bitmap)
+{
+    if (bitmap)
+    {
+        if (bitmap->info_flags & 1)
+        {
+            host_free(bitmap->addr);
+        }
+        host_free(bitmap);
+    }
+}
+
+
+/****************************************************************************/
+/* Drawing.                                                                 */
+/****************************************************************************/
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color)
+{
+    ctx->stroke_color = color;
+}
+
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color)
+{
+    ctx->fill_color = color;
+}
+
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode)
+{
+    ctx->compositing_mode = mode;
+}
+
+
+static GRect intersect(GRect a, GRect b);
+
+
+/* Charge the modelled cost of a drawing call that touched pixels.
+*/
+static void draw_cost(uint32_t us, uint32_t pixels)
+{
+    draw_ns += pixels * DRAW_PIXEL_NS;
+    host_spend_us(HOST_DRAW_US, us + draw_ns / 1000);
+    draw_ns %= 1000;
+}
+
+
+/* Set one pixel, given in the layer's coordinates, if it is in the clip.
+*/
+static void plot(GContext *ctx, int x, int y, GColor color)
+{
+    x += ctx->offset.x;
+    y += ctx->offset.y;
+
+    if (color == GColorClear
+        || x < ctx->clip.origin.x || x >= ctx->clip.origin.x + ctx->clip.size.w
+        || y < ctx->clip.origin.y || y >= ctx->clip.origin.y + ctx->clip.size.h)
+    {
+        return;
+    }
+
+    frame[y][x] = color == GColorWhite;
+}
+
+
+/* True if (x, y) in a w by h box is cut off by a rounded corner.
+*/
+static bool outside_corner(int x, int y, int w, int h, int r, GCornerMask mask)
+{
+    int dx = 0;
+    int dy = 0;
+
+    if (x < r && y < r && (mask & GCornerTopLeft))
+    {
+        dx = r - x;
+        dy = r - y;
+    }
+    else if (x >= w - r && y < r && (mask & GCornerTopRight))
+    {
+        dx = x - (w - r - 1);
+        dy = r - y;
+    }
+    else if (x < r && y >= h - r && (mask & GCornerBottomLeft))
+    {
+        dx = r - x;
+        dy = y - (h - r - 1);
+    }
+    else if (x >= w - r && y >= h - r && (mask & GCornerBottomRight))
+    {
+        dx = x - (w - r - 1);
+        dy = y - (h - r - 1);
+    }
+
+    return dx * dx + dy * dy > r * r;
+}
+
+
+void graphics_fill_rect(GContext *ctx,
+                        GRect rect,
+                        uint16_t corner_radius,
+                        GCornerMask corner_mask)
+{
+    int x;
+    int y;
+
+    /* Square corners are most of them, done a row at a time.
+    */
+    if (corner_radius == 0 || corner_mask == GCornerNone)
+    {
+        GRect r = intersect(ctx->clip,
+                            GRect(rect.origin.x + ctx->offset.x,
+                                  rect.origin.y + ctx->offset.y,
+                                  rect.size.w,
+                                  rect.size.h));
+
+        if (ctx->fill_color == GColorClear)
+        {
+            return;
+        }
+        for (y = r.origin.y; y < r.origin.y + r.size.h; y++)
+        {
+            memset(&frame[y][r.origin.x], ctx->fill_color == GColorWhite,
+                   r.size.w);
+        }
+        draw_cost(DRAW_CALL_US, r.size.w * r.size.h);
+        return;
+    }
+
+    draw_cost(DRAW_CALL_US, rect.size.w * rect.size.h);
+    for (y = 0; y < rect.size.h; y++)
+    {
+        for (x = 0; x < rect.size.w; x++)
+        {
+            if (!outside_corner(x, y, rect.size.w, rect.size.h,
+                                corner_radius, corner_mask))
+            {
+                plot(ctx, rect.origin.x + x, rect.origin.y + y,
+                     ctx->fill_color);
+            }
+        }
+    }
+}
+
+
+void graphics_draw_rect(GContext *ctx, GRect rect)
+{
+    graphics_draw_round_rect(ctx, rect, 0);
+}
+
+
+/* The straight edges stop short of the corners by the radius, and each
+* corner is a quarter circle drawn with the midpoint method.
+*/
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius)
+{
+    int x0 = rect.origin.x;
+    int y0 = rect.origin.y;
+    int x1 = x0 + rect.size.w - 1;
+    int y1 = y0 + rect.size.h - 1;
+    int r = radius;
+    int x;
+    int y;
+    int err;
+
+    if (rect.size.w <= 0 || rect.size.h <= 0)
+    {
+        return;
+    }
+
+    draw_cost(DRAW_CALL_US, 2 * (rect.size.w + rect.size.h));
+    for (x = x0 + r; x <= x1 - r; x++)
+    {
+        plot(ctx, x, y0, ctx->stroke_color);
+        plot(ctx, x, y1, ctx->stroke_color);
+    }
+    for (y = y0 + r; y <= y1 - r; y++)
+    {
+        plot(ctx, x0, y, ctx->stroke_color);
+        plot(ctx, x1, y, ctx->stroke_color);
+    }
+
+    x = r;
+    y = 0;
+    err = 1 - r;
+    while (r > 0 && x >= y)
+    {
+        plot(ctx, x1 - r + x, y1 - r + y, ctx->stroke_color);
+        plot(ctx, x1 - r + y, y1 - r + x, ctx->stroke_color);
+        plot(ctx, x0 + r - x, y1 - r + y, ctx->stroke_color);
+        plot(ctx, x0 + r - y, y1 - r + x, ctx->stroke_color);
+        plot(ctx, x1 - r + x, y0 + r - y, ctx->stroke_color);
+        plot(ctx, x1 - r + y, y0 + r - x, ctx->stroke_color);
+        plot(ctx, x0 + r - x, y0 + r - y, ctx->stroke_color);
+        plot(ctx, x0 + r - y, y0 + r - x, ctx->stroke_color);
+
+        y++;
+        if (err < 0)
+        {
+            err += 2 * y + 1;
+        }
+        else
+        {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+
+/* What each compositing mode does to the frame for a source pixel that is
+* black and one that is white. The new pixel is (old & keep) | set, which
+* has no branch to mispredict on the glyph edges.
+*/
+typedef struct _CompOp
+{
+    uint8_t keep;
+    uint8_t set;
+}
+CompOp;
+
+static const CompOp comp_ops[][2] =
+{
+    [GCompOpAssign] = { { 0, 0 }, { 0, 1 } },
+    [GCompOpAssignInverted] = { { 0, 1 }, { 0, 0 } },
+    [GCompOpOr] = { { 1, 0 }, { 0, 1 } },
+    [GCompOpAnd] = { { 0, 0 }, { 1, 0 } },
+    [GCompOpClear] = { { 1, 0 }, { 0, 0 } },
+    [GCompOpSet] = { { 0, 1 }, { 1, 0 } },
+};
+
+
+/* The bitmap is tiled over the rect if it is smaller. Set bits in the
+* source are white, least significant bit leftmost as on the watch, and
+* the compositing mode says what they do to the frame.
+*/
+void graphics_draw_bitmap_in_rect(GContext *ctx,
+                                  const GBitmap *bitmap,
+                                  GRect rect)
+{
+    const CompOp *op = comp_ops[ctx->compositing_mode];
+    GRect b = bitmap->bounds;
+    GRect r;
+    int left = rect.origin.x + ctx->offset.x;
+    int top = rect.origin.y + ctx->offset.y;
+    int x;
+    int y;
+
+    if (b.size.w <= 0 || b.size.h <= 0)
+    {
+        return;
+    }
+
+    r = intersect(ctx->clip, GRect(left, top, rect.size.w, rect.size.h));
+    draw_cost(DRAW_CALL_US, r.size.w * r.size.h);
+    for (y = r.origin.y; y < r.origin.y + r.size.h; y++)
+    {
+        const uint8_t *src = (const uint8_t *)bitmap->addr
+                             + (b.origin.y + (y - top) % b.size.h)
+                               * bitmap->row_size_bytes;
+        uint8_t *dst = &frame[y][r.origin.x];
+        int sx = (r.origin.x - left) % b.size.w;
+
+        for (x = 0; x < r.size.w; x++)
+        {
+            int px = b.origin.x + sx;
+            const CompOp *c = &op[(src[px / 8] >> (px % 8)) & 1];
+
+            dst[x] = (dst[x] & c->keep) | c->set;
+            if (++sx == b.size.w)
+            {
+                sx = 0;
+            }
+        }
+    }
+}
+
+
+/* Flip every pixel of the clip, which is the inverter layer's frame.
+*/
+static void invert(GRect clip)
+{
+    int x;
+    int y;
+
+    draw_cost(DRAW_CALL_US, clip.size.w * clip.size.h);
+    for (y = clip.origin.y; y < clip.origin.y + clip.size.h; y++)
+    {
+        for (x = clip.origin.x; x < clip.origin.x + clip.size.w; x++)
+        {
+            frame[y][x] = !frame[y][x];
+        }
+    }
+}
+
+
+static GRect intersect(GRect a, GRect b)
+{
+    int x1 = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+    int y1 = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+    int x2 = a.origin.x + a.size.w;
+    int y2 = a.origin.y + a.size.h;
+
+    if (b.origin.x + b.size.w < x2)
+    {
+        x2 = b.origin.x + b.size.w;
+    }
+    if (b.origin.y + b.size.h < y2)
+    {
+        y2 = b.origin.y + b.size.h;
+    }
+
+    return GRect(x1, y1, x2 > x1 ? x2 - x1 : 0, y2 > y1 ? y2 - y1 : 0);
+}
+
+
+/* Draw a layer, then its children on top in the order they were added.
+*/
+static void render_layer(Layer *layer, GPoint origin, GRect clip)
+{
+    GContext ctx;
+    Layer *child;
+
+    if (layer->hidden)
+    {
+        return;
+    }
+
+    origin.x += layer->frame.origin.x;
+    origin.y += layer->frame.origin.y;
+    clip = intersect(clip,
+                     GRect(origin.x,
+                           origin.y,
+                           layer->frame.size.w,
+                           layer->frame.size.h));
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.offset = origin;
+    ctx.clip = clip;
+    ctx.stroke_color = GColorBlack;
+    ctx.fill_color = GColorBlack;
+    ctx.compositing_mode = GCompOpAssign;
+
+    if (layer->kind == LAYER_TEXT)
+    {
+        TextLayer *t = (TextLayer *)layer;
+        uint32_t glyphs = t->text ? strlen(t->text) : 0;
+        uint32_t h = layer->frame.size.h;
+
+        if (t->background_color != GColorClear)
+        {
+            graphics_context_set_fill_color(&ctx, t->background_color);
+            graphics_fill_rect(&ctx, layer_get_bounds(layer), 0, GCornerNone);
+        }
+
+        /* The text isn't drawn, but is charged as if it were, each glyph
+        * taken to cover half a square the height of the layer.
+        */
+        if (glyphs)
+        {
+            uint32_t pixels = glyphs * h * h / 2;
+
+            if (pixels > (uint32_t)(clip.size.w * clip.size.h))
+            {
+                pixels = clip.size.w * clip.size.h;
+            }
+            draw_cost(DRAW_CALL_US + glyphs * DRAW_GLYPH_US, pixels);
+        }
+    }
+    else if (layer->kind == LAYER_INVERTER)
+    {
+        invert(clip);
+    }
+    else if (layer->kind == LAYER_BITMAP)
+    {
+        BitmapLayer *b = (BitmapLayer *)layer;
+
+        if (b->bitmap)
+        {
+            graphics_draw_bitmap_in_rect(&ctx,
+                                         b->bitmap,
+                                         GRect(0,
+                                               0,
+                                               b->bitmap->bounds.size.w,
+                                               b->bitmap->bounds.size.h));
+        }
+    }
+
+    if (layer->update_proc)
+    {
+        layer->update_proc(layer, &ctx);
+    }
+
+    for (child = layer->first_child; child; child = child->next_sibling)
+    {
+        render_layer(child, origin, clip);
+    }
+}
+
+
+uint32_t graphics_render(Layer *root, GColor background)
+{
+    static uint8_t before[HOST_SCREEN_H][HOST_SCREEN_W];
+    GContext ctx;
+    GRect screen = GRect(0, 0, HOST_SCREEN_W, HOST_SCREEN_H);
+    uint32_t changed = 0;
+    int x;
+    int y;
+
+    memcpy(before, frame, sizeof(frame));
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.clip = screen;
+    graphics_context_set_fill_color(&ctx, background);
+    graphics_fill_rect(&ctx, screen, 0, GCornerNone);
+
+    render_layer(root, GPoint(0, 0), screen);
+
+    for (y = 0; y < HOST_SCREEN_H; y++)
+    {
+        if (memcmp(frame[y], before[y], HOST_SCREEN_W) == 0)
+        {
+            continue;
+        }
+        for (x = 0; x < HOST_SCREEN_W; x++)
+        {
+            changed += frame[y][x] != before[y][x];
+        }
+    }
+
+    return changed;
+}
+
+
+/****************************************************************************/
+/* Frames.                                                                  */
+/****************************************************************************/
+
+/* Frames are saved as binary PBM, which any image viewer can show. In PBM
+* a set bit is black, the first pixel of a row is the top bit.
+*/
+bool host_frame_write(const char *path)
+{
+    uint8_t row[(HOST_SCREEN_W + 7) / 8];
+    FILE *f;
+    int x;
+    int y;
+
+    f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        return false;
+    }
+
+    fprintf(f, "P4\n%d %d\n", HOST_SCREEN_W, HOST_SCREEN_H);
+    for (y = 0; y < HOST_SCREEN_H; y++)
+    {
+        memset(row, 0, sizeof(row));
+        for (x = 0; x < HOST_SCREEN_W; x++)
+        {
+            if (!frame[y][x])
+            {
+                row[x / 8] |= 0x80 >> (x % 8);
+            }
+        }
+        fwrite(row, sizeof(row), 1, f);
+    }
+
+    return fclose(f) == 0;
+}
+
+
+int host_frame_diff(const char *path)
+{
+    uint8_t row[(HOST_SCREEN_W + 7) / 8];
+    FILE *f;
+    int w;
+    int h;
+    int diff = 0;
+    int x;
+    int y;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        return -1;
+    }
+
+    if (fscanf(f, "P4 %d %d", &w, &h) != 2
+        || w != HOST_SCREEN_W || h != HOST_SCREEN_H
+        || fgetc(f) == EOF)
+    {
+        fclose(f);
+        return -1;
+    }
+
+    for (y = 0; y < HOST_SCREEN_H; y++)
+    {
+        if (fread(row, sizeof(row), 1, f) != 1)
+        {
+            fclose(f);
+            return -1;
+        }
+        for (x = 0; x < HOST_SCREEN_W; x++)
+        {
+            int white = (row[x / 8] & (0x80 >> (x % 8))) == 0;
+
+            diff += white != frame[y][x];
+        }
+    }
+
+    fclose(f);
+    return diff;
+}
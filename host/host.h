@@ -0,0 +1,261 @@
+/****************************************************************************/
+/**
+* Control side of the host stand-in. A test or benchmark uses these calls to
+* launch the app, move the virtual clock, press buttons and look at what the
+* app did.
+*
+* Each launch runs the app in a child process, so every launch starts with
+* fresh statics the way a real app start does. The clock, the persist store,
+* scheduled wakeups and the counters live in memory shared with the parent,
+* so they carry over from one launch to the next. A launch can end normally,
+* as if the user long-clicked BACK, or be killed at any point.
+*
+* Time is SDK 2 time: time() and localtime() give the watch's local time, and
+* the host runs with TZ=UTC so the two agree. Changing the phone's time zone
+* or a daylight saving change is a jump of the clock, see host_set_time().
+*
+* @file   host.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef HOST_H
+#define HOST_H
+
+
+#include <pebble.h>
+
+
+#define HOST_SCREEN_W   (144)
+#define HOST_SCREEN_H   (168)
+
+/* What happened in the app, counted from the last host_reset().
+*/
+typedef enum
+{
+    HOST_WAKE,          /* the app ran for any reason */
+    HOST_WAKE_TICK,
+    HOST_WAKE_TIMER,
+    HOST_WAKE_WAKEUP,
+    HOST_WAKE_CLICK,
+    HOST_SET_TEXT,      /* text_layer_set_text() */
+    HOST_MARK_DIRTY,    /* layer_mark_dirty() */
+    HOST_FRAME,         /* screen redrawn */
+    HOST_PIXELS,        /* pixels those redraws changed */
+    HOST_VIBE,          /* any vibes_*() call but cancel */
+    HOST_PERSIST_READ,
+    HOST_PERSIST_WRITE,
+    HOST_PERSIST_BYTES,
+    HOST_TIMER_REGISTER,
+    HOST_LAUNCH,
+    HOST_HEAP_ALLOC,    /* app heap allocations, the SDK's objects too */
+    HOST_LAYER_CREATE,  /* layers of every kind */
+    HOST_DRAW_US,       /* modelled time spent drawing, see host_model_time() */
+    HOST_FLASH_US,      /* modelled persist calls, the same */
+    HOST_RESOURCE_US,   /* modelled resource loads, the same */
+    HOST_COUNTER_COUNT
+}
+HostCounter;
+
+/* How a launch ended.
+*/
+typedef enum
+{
+    HOST_EXIT,          /* script returned, app deinit ran */
+    HOST_KILLED,        /* killed, no deinit */
+    HOST_FAILED,        /* a check failed or the app crashed */
+}
+HostResult;
+
+typedef void (*HostScript)(void *ctx);
+
+
+/**
+* Start over: empty persist store, no wakeups, counters zeroed, clock set to
+* the given local time.
+*****************************************************************************/
+void host_reset(time_t now);
+
+
+/**
+* Run the app once. script is called from inside app_event_loop() after the
+* app has initialized, and drives it with the calls below. When the script
+* returns, the window is popped and the app exits normally.
+*
+* @param reason What launch_reason() reports. APP_LAUNCH_WAKEUP is used
+*               automatically if host_sleep() stopped at a wakeup.
+*
+* @return How the launch ended.
+*****************************************************************************/
+HostResult host_launch(AppLaunchReason reason, HostScript script, void *ctx);
+
+
+/**
+* Advance the clock by ms, delivering ticks, AppTimers and wakeups on time
+* and redrawing after each one. Only called from a script.
+*****************************************************************************/
+void host_run(uint32_t ms);
+
+
+/**
+* Advance the clock by up to ms while the app is not running. Stops early at
+* a due wakeup, in which case the next launch is a wakeup launch.
+*
+* @return true if it stopped at a wakeup.
+*****************************************************************************/
+bool host_sleep(uint32_t ms);
+
+
+/**
+* Button presses. Each one runs the handler the app subscribed and redraws.
+* host_click() is a single click, host_multi_click() a burst of count clicks,
+* host_hold() a long click.
+*****************************************************************************/
+void host_click(ButtonId button);
+void host_multi_click(ButtonId button, uint8_t count);
+void host_hold(ButtonId button);
+
+
+/**
+* Kill the app where it stands, as a crash or a battery pull would. The
+* launch returns HOST_KILLED and deinit does not run.
+*****************************************************************************/
+void host_kill(void);
+
+
+/**
+* Kill the app just before its next n-th persist write is stored. 0 turns
+* it off.
+*****************************************************************************/
+void host_kill_on_write(int n);
+
+
+/**
+* The clock, as local time in ms. host_set_time() jumps it without running
+* anything in between, the way the phone setting the watch's time does.
+*****************************************************************************/
+int64_t host_now_ms(void);
+void host_set_time(time_t now, uint16_t ms);
+
+
+/**
+* Tick delivery. Each tick is late by a random 0 to jitter_ms, and a tick is
+* dropped with probability drop_pct percent. Both default to 0.
+*****************************************************************************/
+void host_tick_jitter(uint16_t jitter_ms, uint8_t drop_pct);
+
+
+/**
+* Phone and battery state. Changes are delivered to subscribed handlers.
+*****************************************************************************/
+void host_set_battery(uint8_t percent, bool charging);
+void host_set_bluetooth(bool connected);
+void host_set_24h(bool enabled);
+
+
+/**
+* Model the watch's run time. The stand-in draws far faster than the watch,
+* so each drawing call is charged an estimate of what it costs there: a
+* fixed amount per call plus an amount per pixel it touches, and per glyph
+* for a TextLayer, which the stand-in doesn't rasterize. Persist calls and
+* resource loads are charged the same way, per call and per byte, writes
+* more than reads. The estimates are always counted, in HOST_DRAW_US,
+* HOST_FLASH_US and HOST_RESOURCE_US. With this on, the clock also moves
+* on by them while the app runs, so the app's own timings see them. Off by
+* default, so tests see no time pass inside a handler.
+*****************************************************************************/
+void host_model_time(bool on);
+
+
+/**
+* Direct access to the persist store, for setting up an old layout or
+* corrupting one.
+*****************************************************************************/
+int host_persist_read(uint32_t key, void *data, size_t size);
+void host_persist_write(uint32_t key, const void *data, size_t size);
+void host_persist_delete(uint32_t key);
+
+
+/**
+* Wakeups the app has scheduled. Returns the number, fills in up to max
+* times.
+*****************************************************************************/
+int host_wakeups(time_t *times, int max);
+
+
+/**
+* Vibration. host_vibing() is true while a pattern is playing at the current
+* time.
+*****************************************************************************/
+bool host_vibing(void);
+
+
+/**
+* Counters.
+*****************************************************************************/
+uint32_t host_count(HostCounter c);
+void host_count_clear(void);
+
+
+/**
+* Text of every visible TextLayer, joined by '|', in the order they are
+* drawn. Only useful from a script.
+*****************************************************************************/
+const char *host_texts(void);
+
+
+/**
+* Print app_log() messages at or above this level to stderr. Default is
+* APP_LOG_LEVEL_ERROR; 0 turns logging off.
+*****************************************************************************/
+void host_log_level(uint8_t level);
+
+
+/**
+* The last frame drawn. host_frame_write() saves it as a PBM image,
+* host_frame_diff() counts the pixels that differ from a saved one, or
+* returns -1 if it can't be read. Only useful from a script.
+*****************************************************************************/
+bool host_frame_write(const char *path);
+int host_frame_diff(const char *path);
+
+
+/**
+* Record a failure from inside a script. The launch returns HOST_FAILED.
+*****************************************************************************/
+void host_fail(const char *file, int line, const char *msg);
+
+
+/**
+* Number of failures recorded so far, in this process and every launch.
+*****************************************************************************/
+int host_failures(void);
+
+
+/**
+* The app's main(), renamed when it is built for the host.
+*****************************************************************************/
+int app_main(void);
+
+
+#endif  /* include guard */
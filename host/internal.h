@@ -0,0 +1,128 @@
+/****************************************************************************/
+/**
+* What the pieces of the host stand-in share with each other but not with
+* the app: the layer structures and the drawing entry point.
+*
+* @file   internal.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef INTERNAL_H
+#define INTERNAL_H
+
+
+#include "host.h"
+
+
+typedef enum
+{
+    LAYER_PLAIN,
+    LAYER_TEXT,
+    LAYER_BITMAP,
+    LAYER_INVERTER,
+}
+LayerKind;
+
+struct Layer
+{
+    LayerKind kind;
+    GRect frame;
+    bool hidden;
+    LayerUpdateProc update_proc;
+    Layer *parent;
+    Layer *first_child;
+    Layer *next_sibling;
+    void *data;                 /* layer_create_with_data() */
+};
+
+struct TextLayer
+{
+    Layer layer;
+    const char *text;
+    GFont font;
+    GColor text_color;
+    GColor background_color;
+    GTextAlignment alignment;
+};
+
+struct BitmapLayer
+{
+    Layer layer;
+    const GBitmap *bitmap;
+    GAlign alignment;
+};
+
+struct InverterLayer
+{
+    Layer layer;
+};
+
+
+/**
+* Count something the app did.
+*****************************************************************************/
+void host_counter_inc(HostCounter c, uint32_t n);
+
+
+/**
+* Charge modelled watch time to a counter, and to the clock if
+* host_model_time() is on.
+*****************************************************************************/
+void host_spend_us(HostCounter c, uint32_t us);
+
+
+/**
+* Charge the modelled cost of reading from flash to a counter,
+* HOST_FLASH_US for a persist call or HOST_RESOURCE_US for a resource.
+*****************************************************************************/
+void host_flash_read(HostCounter c, uint32_t bytes);
+
+
+/**
+* The app heap. App sources are built with malloc() and free() renamed to
+* these, and the SDK's objects use them too, so heap_bytes_used() reports
+* what the app holds as the watch would count it, less its block headers.
+* host_zalloc() is calloc() for one block.
+*****************************************************************************/
+void *host_malloc(size_t size);
+void *host_zalloc(size_t size);
+void host_free(void *ptr);
+
+
+/**
+* Draw the layer tree under root, with the given window background.
+*
+* @return  Pixels that are different from the last frame.
+*****************************************************************************/
+uint32_t graphics_render(Layer *root, GColor background);
+
+
+/**
+* Load a whole resource file. The result is cached for the life of the
+* launch. Returns NULL if there is no such resource.
+*****************************************************************************/
+const uint8_t *resource_data(uint32_t resource_id, size_t *size);
+
+
+#endif  /* include guard */
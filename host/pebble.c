@@ -0,0 +1,1779 @@
+/****************************************************************************/
+/**
+* Host stand-in for the Pebble SDK: virtual clock, event loop, services,
+* persist store, windows, layers and clicks. Drawing and resources are in
+* graphics.c.
+*
+* The clock only moves when the control side moves it. host_run() steps it
+* from one event to the next, so a simulated day takes as long as the app
+* takes to handle that day's events and no longer.
+*
+* @file   pebble.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <stdarg.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "internal.h"
+
+
+#define PERSIST_SLOTS   (32)
+#define WAKEUP_SLOTS    (8)     /* per app, as on the watch */
+#define EXIT_KILLED     (3)
+#define EXIT_FAILED     (2)
+
+/* Modelled flash costs on the watch. A persist call looks the key up in
+* the file system, and a write or delete also programs a page.
+*/
+#define FLASH_CALL_US   (300)
+#define FLASH_WRITE_US  (2000)
+#define FLASH_READ_NS   (1000)  /* per byte */
+#define FLASH_WRITE_NS  (8000)  /* per byte */
+
+/* The head of an app heap block, big enough to keep what follows aligned.
+*/
+typedef union _Block
+{
+    size_t size;
+    long double align;
+}
+Block;
+
+typedef struct _Slot
+{
+    bool used;
+    uint32_t key;
+    uint16_t size;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+}
+Slot;
+
+typedef struct _Wakeup
+{
+    WakeupId id;                /* 0 = free */
+    time_t when;
+    int32_t cookie;
+}
+Wakeup;
+
+/* Everything that outlives a launch. Shared with the child that runs the
+* app, so it sees what earlier launches left and the parent sees what it
+* did.
+*/
+typedef struct _Shared
+{
+    int64_t now;                /* local time, ms */
+    Slot persist[PERSIST_SLOTS];
+    Wakeup wakeup[WAKEUP_SLOTS];
+    WakeupId last_wakeup_id;
+    Wakeup launch_wakeup;       /* id != 0 = next launch is for this one */
+    uint32_t count[HOST_COUNTER_COUNT];
+    uint16_t jitter_ms;
+    uint8_t drop_pct;
+    uint32_t seed;
+    BatteryChargeState battery;
+    bool bluetooth;
+    bool clock_24h;
+    int kill_on_write;
+    uint8_t log_level;
+    int64_t vibe_until;
+    int failures;
+    bool model_time;            /* host_model_time() */
+    uint32_t model_us;          /* modelled time not yet on the clock */
+}
+Shared;
+
+typedef struct _Click
+{
+    ClickHandler single;
+    ClickHandler multi;
+    uint8_t multi_min;
+    uint8_t multi_max;
+    ClickHandler long_down;
+    ClickHandler long_up;
+}
+Click;
+
+typedef struct _Recognizer
+{
+    uint8_t count;
+}
+Recognizer;
+
+struct AppTimer
+{
+    int64_t due;
+    AppTimerCallback callback;
+    void *data;
+    AppTimer *next;
+};
+
+struct Window
+{
+    Layer root;
+    WindowHandlers handlers;
+    ClickConfigProvider click_config;
+    GColor background;
+    bool loaded;
+};
+
+static Shared *shared;
+
+/* The rest only exists in the child running the app.
+*/
+static bool in_app;
+static AppLaunchReason reason;
+static Wakeup launch_wakeup;
+static HostScript script;
+static void *script_ctx;
+static Window *top;
+static bool dirty;
+static Click clicks[NUM_BUTTONS];
+static AppTimer *timers;
+static TickHandler tick_handler;
+static TimeUnits tick_units;
+static int64_t tick_next;       /* next boundary */
+static int64_t tick_due;        /* next boundary plus jitter */
+static struct tm tick_last;
+static WakeupHandler wakeup_handler;
+static BatteryStateHandler battery_handler;
+static BluetoothConnectionHandler bluetooth_handler;
+static char texts[512];
+static size_t heap_used;
+static uint32_t flash_ns;       /* modelled flash time under a us */
+
+
+/****************************************************************************/
+/* Control side.                                                            */
+/****************************************************************************/
+
+void host_counter_inc(HostCounter c, uint32_t n)
+{
+    shared->count[c] += n;
+}
+
+
+static uint32_t host_random(void)
+{
+    uint32_t x = shared->seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    shared->seed = x;
+
+    return x;
+}
+
+
+void host_reset(time_t now)
+{
+    int failures;
+
+    if (shared == NULL)
+    {
+        shared = mmap(NULL,
+                      sizeof(Shared),
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS,
+                      -1,
+                      0);
+        if (shared == MAP_FAILED)
+        {
+            perror("mmap");
+            exit(1);
+        }
+
+        /* The watch has no time zone, localtime() is just a breakdown.
+        */
+        setenv("TZ", "UTC", 1);
+        tzset();
+    }
+
+    failures = shared->failures;
+    memset(shared, 0, sizeof(Shared));
+    shared->failures = failures;
+    shared->now = (int64_t)now * 1000;
+    shared->seed = 2463534242u;
+    shared->battery.charge_percent = 80;
+    shared->bluetooth = true;
+    shared->log_level = APP_LOG_LEVEL_ERROR;
+}
+
+
+HostResult host_launch(AppLaunchReason why, HostScript run, void *ctx)
+{
+    pid_t pid;
+    int status;
+
+    fflush(NULL);
+    pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        exit(1);
+    }
+
+    if (pid == 0)
+    {
+        in_app = true;
+        reason = shared->launch_wakeup.id ? APP_LAUNCH_WAKEUP : why;
+        launch_wakeup = shared->launch_wakeup;
+        memset(&shared->launch_wakeup, 0, sizeof(Wakeup));
+        script = run;
+        script_ctx = ctx;
+        host_counter_inc(HOST_LAUNCH, 1);
+        app_main();
+        fflush(NULL);
+        _exit(0);
+    }
+
+    while (waitpid(pid, &status, 0) < 0)
+    {
+    }
+    memset(&shared->launch_wakeup, 0, sizeof(Wakeup));
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+    {
+        return HOST_EXIT;
+    }
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_KILLED)
+    {
+        return HOST_KILLED;
+    }
+
+    if (WIFSIGNALED(status))
+    {
+        fprintf(stderr, "app died with signal %d\n", WTERMSIG(status));
+        shared->failures++;
+    }
+
+    return HOST_FAILED;
+}
+
+
+static void render(void)
+{
+    if (dirty && top && top->loaded)
+    {
+        dirty = false;
+        host_counter_inc(HOST_FRAME, 1);
+        host_counter_inc(HOST_PIXELS,
+                         graphics_render(&top->root, top->background));
+    }
+}
+
+
+static void units_changed(struct tm *now, TimeUnits *units)
+{
+    *units = SECOND_UNIT;
+
+    if (now->tm_min != tick_last.tm_min || now->tm_hour != tick_last.tm_hour)
+    {
+        *units |= MINUTE_UNIT;
+    }
+    if (now->tm_hour != tick_last.tm_hour)
+    {
+        *units |= HOUR_UNIT;
+    }
+    if (now->tm_mday != tick_last.tm_mday)
+    {
+        *units |= DAY_UNIT;
+    }
+    if (now->tm_mon != tick_last.tm_mon)
+    {
+        *units |= MONTH_UNIT;
+    }
+    if (now->tm_year != tick_last.tm_year)
+    {
+        *units |= YEAR_UNIT;
+    }
+}
+
+
+/* Pick the next tick: the next boundary of the subscribed unit, late by the
+* jitter, and maybe dropped.
+*/
+static void tick_plan(void)
+{
+    int64_t step = tick_units & SECOND_UNIT ? 1000 : 60000;
+
+    tick_next = (shared->now / step + 1) * step;
+    while (shared->drop_pct && host_random() % 100 < shared->drop_pct)
+    {
+        tick_next += step;
+    }
+
+    tick_due = tick_next;
+    if (shared->jitter_ms)
+    {
+        tick_due += host_random() % (shared->jitter_ms + 1);
+    }
+}
+
+
+static void tick_fire(void)
+{
+    time_t t = tick_next / 1000;
+    struct tm now = *localtime(&t);
+    TimeUnits units;
+
+    units_changed(&now, &units);
+    tick_last = now;
+    tick_plan();
+
+    if (units & tick_units)
+    {
+        host_counter_inc(HOST_WAKE, 1);
+        host_counter_inc(HOST_WAKE_TICK, 1);
+        tick_handler(&now, units);
+    }
+}
+
+
+static void timer_fire(AppTimer *timer)
+{
+    AppTimer **p;
+
+    for (p = &timers; *p; p = &(*p)->next)
+    {
+        if (*p == timer)
+        {
+            *p = timer->next;
+            break;
+        }
+    }
+
+    host_counter_inc(HOST_WAKE, 1);
+    host_counter_inc(HOST_WAKE_TIMER, 1);
+    timer->callback(timer->data);
+    free(timer);
+}
+
+
+static Wakeup *wakeup_next(void)
+{
+    Wakeup *next = NULL;
+    int i;
+
+    for (i = 0; i < WAKEUP_SLOTS; i++)
+    {
+        if (shared->wakeup[i].id
+            && (next == NULL || shared->wakeup[i].when < next->when))
+        {
+            next = &shared->wakeup[i];
+        }
+    }
+
+    return next;
+}
+
+
+void host_run(uint32_t ms)
+{
+    int64_t end = shared->now + ms;
+
+    for (;;)
+    {
+        AppTimer *timer = NULL;
+        AppTimer *t;
+        Wakeup *w = wakeup_handler ? wakeup_next() : NULL;
+        int64_t when = end + 1;
+
+        for (t = timers; t; t = t->next)
+        {
+            if (t->due < when)
+            {
+                timer = t;
+                when = t->due;
+            }
+        }
+
+        if (tick_handler && tick_due < when)
+        {
+            timer = NULL;
+            when = tick_due;
+        }
+
+        if (w && (int64_t)w->when * 1000 < when)
+        {
+            timer = NULL;
+            when = (int64_t)w->when * 1000;
+        }
+        else
+        {
+            w = NULL;
+        }
+
+        if (when > end)
+        {
+            break;
+        }
+
+        if (when > shared->now)
+        {
+            shared->now = when;
+        }
+
+        if (w)
+        {
+            Wakeup fired = *w;
+
+            w->id = 0;
+            host_counter_inc(HOST_WAKE, 1);
+            host_counter_inc(HOST_WAKE_WAKEUP, 1);
+            wakeup_handler(fired.id, fired.cookie);
+        }
+        else if (timer)
+        {
+            timer_fire(timer);
+        }
+        else
+        {
+            tick_fire();
+        }
+
+        render();
+    }
+
+    /* Modelled run time may have carried the clock past the end.
+    */
+    if (shared->now < end)
+    {
+        shared->now = end;
+    }
+}
+
+
+bool host_sleep(uint32_t ms)
+{
+    int64_t end = shared->now + ms;
+    Wakeup *w = wakeup_next();
+
+    if (w && (int64_t)w->when * 1000 <= end)
+    {
+        if ((int64_t)w->when * 1000 > shared->now)
+        {
+            shared->now = (int64_t)w->when * 1000;
+        }
+        shared->launch_wakeup = *w;
+        w->id = 0;
+        return true;
+    }
+
+    shared->now = end;
+    return false;
+}
+
+
+static void click(ButtonId button, ClickHandler handler, uint8_t count)
+{
+    Recognizer r = { count };
+
+    host_counter_inc(HOST_WAKE, 1);
+    host_counter_inc(HOST_WAKE_CLICK, 1);
+    handler(&r, NULL);
+    render();
+}
+
+
+void host_click(ButtonId button)
+{
+    if (clicks[button].single)
+    {
+        click(button, clicks[button].single, 1);
+    }
+}
+
+
+void host_multi_click(ButtonId button, uint8_t count)
+{
+    Click *c = &clicks[button];
+    uint8_t max = c->multi_max ? c->multi_max : c->multi_min;
+    uint8_t i;
+
+    if (c->multi && count >= c->multi_min && count <= max)
+    {
+        click(button, c->multi, count);
+    }
+    else
+    {
+        for (i = 1; i <= count; i++)
+        {
+            host_click(button);
+        }
+    }
+}
+
+
+void host_hold(ButtonId button)
+{
+    if (clicks[button].long_down)
+    {
+        click(button, clicks[button].long_down, 1);
+    }
+    if (clicks[button].long_up)
+    {
+        click(button, clicks[button].long_up, 1);
+    }
+}
+
+
+void host_kill(void)
+{
+    fflush(NULL);
+    _exit(EXIT_KILLED);
+}
+
+
+void host_kill_on_write(int n)
+{
+    shared->kill_on_write = n;
+}
+
+
+int64_t host_now_ms(void)
+{
+    return shared->now;
+}
+
+
+/* A wakeup whose time was jumped over is missed, as it is when the watch
+* is off at the time. A vibration keeps playing for what it had left.
+*/
+void host_set_time(time_t now, uint16_t ms)
+{
+    int64_t left = shared->vibe_until - shared->now;
+    int i;
+
+    shared->now = (int64_t)now * 1000 + ms;
+    shared->vibe_until = shared->now + (left > 0 ? left : 0);
+    for (i = 0; i < WAKEUP_SLOTS; i++)
+    {
+        if (shared->wakeup[i].id && shared->wakeup[i].when < now)
+        {
+            shared->wakeup[i].id = 0;
+        }
+    }
+
+    if (in_app && tick_handler)
+    {
+        tick_plan();
+    }
+}
+
+
+void host_model_time(bool on)
+{
+    shared->model_time = on;
+}
+
+
+void host_spend_us(HostCounter c, uint32_t us)
+{
+    host_counter_inc(c, us);
+    if (shared->model_time)
+    {
+        shared->model_us += us;
+        shared->now += shared->model_us / 1000;
+        shared->model_us %= 1000;
+    }
+}
+
+
+void host_tick_jitter(uint16_t jitter_ms, uint8_t drop_pct)
+{
+    shared->jitter_ms = jitter_ms;
+    shared->drop_pct = drop_pct;
+}
+
+
+void host_set_battery(uint8_t percent, bool charging)
+{
+    shared->battery.charge_percent = percent;
+    shared->battery.is_charging = charging;
+    shared->battery.is_plugged = charging;
+    if (in_app && battery_handler)
+    {
+        host_counter_inc(HOST_WAKE, 1);
+        battery_handler(shared->battery);
+        render();
+    }
+}
+
+
+void host_set_bluetooth(bool connected)
+{
+    shared->bluetooth = connected;
+    if (in_app && bluetooth_handler)
+    {
+        host_counter_inc(HOST_WAKE, 1);
+        bluetooth_handler(connected);
+        render();
+    }
+}
+
+
+void host_set_24h(bool enabled)
+{
+    shared->clock_24h = enabled;
+}
+
+
+static Slot *slot_find(uint32_t key)
+{
+    int i;
+
+    for (i = 0; i < PERSIST_SLOTS; i++)
+    {
+        if (shared->persist[i].used && shared->persist[i].key == key)
+        {
+            return &shared->persist[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+int host_persist_read(uint32_t key, void *data, size_t size)
+{
+    Slot *s = slot_find(key);
+
+    if (s == NULL)
+    {
+        return E_DOES_NOT_EXIST;
+    }
+
+    if (size > s->size)
+    {
+        size = s->size;
+    }
+    memcpy(data, s->data, size);
+
+    return size;
+}
+
+
+void host_persist_write(uint32_t key, const void *data, size_t size)
+{
+    Slot *s = slot_find(key);
+    int i;
+
+    for (i = 0; s == NULL && i < PERSIST_SLOTS; i++)
+    {
+        if (!shared->persist[i].used)
+        {
+            s = &shared->persist[i];
+        }
+    }
+
+    if (s == NULL || size > PERSIST_DATA_MAX_LENGTH)
+    {
+        host_fail(__FILE__, __LINE__, "persist store full");
+        return;
+    }
+
+    s->used = true;
+    s->key = key;
+    s->size = size;
+    memcpy(s->data, data, size);
+}
+
+
+void host_persist_delete(uint32_t key)
+{
+    Slot *s = slot_find(key);
+
+    if (s)
+    {
+        s->used = false;
+    }
+}
+
+
+int host_wakeups(time_t *times, int max)
+{
+    int n = 0;
+    int i;
+
+    for (i = 0; i < WAKEUP_SLOTS; i++)
+    {
+        if (shared->wakeup[i].id)
+        {
+            if (n < max)
+            {
+                times[n] = shared->wakeup[i].when;
+            }
+            n++;
+        }
+    }
+
+    return n;
+}
+
+
+bool host_vibing(void)
+{
+    return shared->now < shared->vibe_until;
+}
+
+
+uint32_t host_count(HostCounter c)
+{
+    return shared->count[c];
+}
+
+
+void host_count_clear(void)
+{
+    memset(shared->count, 0, sizeof(shared->count));
+}
+
+
+static void texts_add(Layer *layer)
+{
+    Layer *child;
+
+    if (layer->hidden)
+    {
+        return;
+    }
+
+    if (layer->kind == LAYER_TEXT && ((TextLayer *)layer)->text)
+    {
+        size_t len = strlen(texts);
+
+        snprintf(texts + len,
+                 sizeof(texts) - len,
+                 "%s%s",
+                 len ? "|" : "",
+                 ((TextLayer *)layer)->text);
+    }
+
+    for (child = layer->first_child; child; child = child->next_sibling)
+    {
+        texts_add(child);
+    }
+}
+
+
+const char *host_texts(void)
+{
+    texts[0] = 0;
+    if (top)
+    {
+        texts_add(&top->root);
+    }
+
+    return texts;
+}
+
+
+void host_log_level(uint8_t level)
+{
+    shared->log_level = level;
+}
+
+
+void host_fail(const char *file, int line, const char *msg)
+{
+    fprintf(stderr, "%s:%d: FAIL %s\n", file, line, msg);
+    shared->failures++;
+    if (in_app)
+    {
+        fflush(NULL);
+        _exit(EXIT_FAILED);
+    }
+}
+
+
+int host_failures(void)
+{
+    return shared->failures;
+}
+
+
+/****************************************************************************/
+/* SDK side.                                                                */
+/****************************************************************************/
+
+void app_log(uint8_t log_level,
+             const char *src_filename,
+             int src_line_number,
+             const char *fmt,
+             ...)
+{
+    va_list ap;
+
+    if (log_level > shared->log_level)
+    {
+        return;
+    }
+
+    fprintf(stderr, "%s:%d: ", src_filename, src_line_number);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+
+/* Replaces the C library's time(), so the app sees the virtual clock.
+*/
+time_t time(time_t *t)
+{
+    time_t now = shared->now / 1000;
+
+    if (t)
+    {
+        *t = now;
+    }
+
+    return now;
+}
+
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms)
+{
+    uint16_t ms = shared->now % 1000;
+
+    if (t_utc)
+    {
+        *t_utc = shared->now / 1000;
+    }
+    if (out_ms)
+    {
+        *out_ms = ms;
+    }
+
+    return ms;
+}
+
+
+bool clock_is_24h_style(void)
+{
+    return shared->clock_24h;
+}
+
+
+void tick_timer_service_subscribe(TimeUnits tick_units_wanted,
+                                  TickHandler handler)
+{
+    time_t t = shared->now / 1000;
+
+    tick_handler = handler;
+    tick_units = tick_units_wanted;
+    tick_last = *localtime(&t);
+    tick_plan();
+}
+
+
+void tick_timer_service_unsubscribe(void)
+{
+    tick_handler = NULL;
+    tick_units = 0;
+}
+
+
+AppTimer *app_timer_register(uint32_t timeout_ms,
+                             AppTimerCallback callback,
+                             void *callback_data)
+{
+    AppTimer *timer = malloc(sizeof(AppTimer));
+
+    if (timer)
+    {
+        timer->due = shared->now + timeout_ms;
+        timer->callback = callback;
+        timer->data = callback_data;
+        timer->next = timers;
+        timers = timer;
+        host_counter_inc(HOST_TIMER_REGISTER, 1);
+    }
+
+    return timer;
+}
+
+
+static bool timer_pending(AppTimer *timer)
+{
+    AppTimer *t;
+
+    for (t = timers; t; t = t->next)
+    {
+        if (t == timer)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms)
+{
+    if (!timer_pending(timer))
+    {
+        return false;
+    }
+
+    timer->due = shared->now + new_timeout_ms;
+    host_counter_inc(HOST_TIMER_REGISTER, 1);
+
+    return true;
+}
+
+
+void app_timer_cancel(AppTimer *timer)
+{
+    AppTimer **p;
+
+    for (p = &timers; *p; p = &(*p)->next)
+    {
+        if (*p == timer)
+        {
+            *p = timer->next;
+            free(timer);
+            break;
+        }
+    }
+}
+
+
+WakeupId wakeup_schedule(time_t timestamp,
+                         int32_t cookie,
+                         bool notify_if_missed)
+{
+    Wakeup *free_slot = NULL;
+    int i;
+
+    if ((int64_t)timestamp * 1000 <= shared->now)
+    {
+        return E_INVALID_ARGUMENT;
+    }
+
+    for (i = 0; i < WAKEUP_SLOTS; i++)
+    {
+        Wakeup *w = &shared->wakeup[i];
+
+        if (w->id == 0)
+        {
+            free_slot = free_slot ? free_slot : w;
+        }
+        else if (w->when > timestamp - 60 && w->when < timestamp + 60)
+        {
+            return E_RANGE;
+        }
+    }
+
+    if (free_slot == NULL)
+    {
+        return E_OUT_OF_RESOURCES;
+    }
+
+    free_slot->id = ++shared->last_wakeup_id;
+    free_slot->when = timestamp;
+    free_slot->cookie = cookie;
+
+    return free_slot->id;
+}
+
+
+void wakeup_cancel(WakeupId wakeup_id)
+{
+    int i;
+
+    for (i = 0; i < WAKEUP_SLOTS; i++)
+    {
+        if (shared->wakeup[i].id == wakeup_id)
+        {
+            shared->wakeup[i].id = 0;
+        }
+    }
+}
+
+
+void wakeup_cancel_all(void)
+{
+    int i;
+
+    for (i = 0; i < WAKEUP_SLOTS; i++)
+    {
+        shared->wakeup[i].id = 0;
+    }
+}
+
+
+void wakeup_service_subscribe(WakeupHandler handler)
+{
+    wakeup_handler = handler;
+}
+
+
+bool wakeup_get_launch_event(WakeupId *wakeup_id, int32_t *cookie)
+{
+    if (reason != APP_LAUNCH_WAKEUP)
+    {
+        return false;
+    }
+
+    *wakeup_id = launch_wakeup.id;
+    *cookie = launch_wakeup.cookie;
+
+    return true;
+}
+
+
+bool wakeup_query(WakeupId wakeup_id, time_t *timestamp)
+{
+    int i;
+
+    for (i = 0; i < WAKEUP_SLOTS; i++)
+    {
+        if (wakeup_id > 0 && shared->wakeup[i].id == wakeup_id)
+        {
+            if (timestamp)
+            {
+                *timestamp = shared->wakeup[i].when;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+AppLaunchReason launch_reason(void)
+{
+    return reason;
+}
+
+
+/* The app's main loop is the script. When it returns, the user has long
+* clicked BACK: the window comes off the stack and the app exits.
+*/
+void app_event_loop(void)
+{
+    render();
+    if (script)
+    {
+        script(script_ctx);
+    }
+
+    window_stack_pop(false);
+}
+
+
+static void flash_cost(HostCounter c,
+                       uint32_t us,
+                       uint32_t bytes,
+                       uint32_t byte_ns)
+{
+    flash_ns += bytes * byte_ns;
+    host_spend_us(c, us + flash_ns / 1000);
+    flash_ns %= 1000;
+}
+
+
+void host_flash_read(HostCounter c, uint32_t bytes)
+{
+    flash_cost(c, FLASH_CALL_US, bytes, FLASH_READ_NS);
+}
+
+
+bool persist_exists(const uint32_t key)
+{
+    flash_cost(HOST_FLASH_US, FLASH_CALL_US, 0, 0);
+
+    return slot_find(key) != NULL;
+}
+
+
+int persist_get_size(const uint32_t key)
+{
+    Slot *s = slot_find(key);
+
+    flash_cost(HOST_FLASH_US, FLASH_CALL_US, 0, 0);
+
+    return s ? s->size : E_DOES_NOT_EXIST;
+}
+
+
+int persist_read_data(const uint32_t key,
+                      void *buffer,
+                      const size_t buffer_size)
+{
+    int size = host_persist_read(key, buffer, buffer_size);
+
+    host_counter_inc(HOST_PERSIST_READ, 1);
+    host_flash_read(HOST_FLASH_US, size > 0 ? size : 0);
+
+    return size;
+}
+
+
+bool persist_read_bool(const uint32_t key)
+{
+    bool value = false;
+
+    persist_read_data(key, &value, sizeof(value));
+
+    return value;
+}
+
+
+int32_t persist_read_int(const uint32_t key)
+{
+    int32_t value = 0;
+
+    persist_read_data(key, &value, sizeof(value));
+
+    return value;
+}
+
+
+int persist_write_data(const uint32_t key,
+                       const void *data,
+                       const size_t size)
+{
+    if (size > PERSIST_DATA_MAX_LENGTH)
+    {
+        return E_RANGE;
+    }
+
+    if (shared->kill_on_write && --shared->kill_on_write == 0)
+    {
+        host_kill();
+    }
+
+    host_counter_inc(HOST_PERSIST_WRITE, 1);
+    host_counter_inc(HOST_PERSIST_BYTES, size);
+    flash_cost(HOST_FLASH_US, FLASH_WRITE_US, size, FLASH_WRITE_NS);
+    host_persist_write(key, data, size);
+
+    return size;
+}
+
+
+status_t persist_write_bool(const uint32_t key, const bool value)
+{
+    return persist_write_data(key, &value, sizeof(value));
+}
+
+
+status_t persist_write_int(const uint32_t key, const int32_t value)
+{
+    return persist_write_data(key, &value, sizeof(value));
+}
+
+
+status_t persist_delete(const uint32_t key)
+{
+    flash_cost(HOST_FLASH_US, FLASH_CALL_US, 0, 0);
+    if (slot_find(key) == NULL)
+    {
+        return E_DOES_NOT_EXIST;
+    }
+
+    flash_cost(HOST_FLASH_US, FLASH_WRITE_US, 0, 0);
+    host_persist_delete(key);
+
+    return S_SUCCESS;
+}
+
+
+BatteryChargeState battery_state_service_peek(void)
+{
+    return shared->battery;
+}
+
+
+void battery_state_service_subscribe(BatteryStateHandler handler)
+{
+    battery_handler = handler;
+}
+
+
+void battery_state_service_unsubscribe(void)
+{
+    battery_handler = NULL;
+}
+
+
+bool bluetooth_connection_service_peek(void)
+{
+    return shared->bluetooth;
+}
+
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler)
+{
+    bluetooth_handler = handler;
+}
+
+
+void bluetooth_connection_service_unsubscribe(void)
+{
+    bluetooth_handler = NULL;
+}
+
+
+void light_enable_interaction(void)
+{
+}
+
+
+size_t heap_bytes_free(void)
+{
+    return 0;
+}
+
+
+size_t heap_bytes_used(void)
+{
+    return heap_used;
+}
+
+
+void *host_malloc(size_t size)
+{
+    Block *block = malloc(sizeof(Block) + size);
+
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    block->size = size;
+    heap_used += size;
+    host_counter_inc(HOST_HEAP_ALLOC, 1);
+
+    return block + 1;
+}
+
+
+void *host_zalloc(size_t size)
+{
+    void *ptr = host_malloc(size);
+
+    if (ptr)
+    {
+        memset(ptr, 0, size);
+    }
+
+    return ptr;
+}
+
+
+void host_free(void *ptr)
+{
+    Block *block = (Block *)ptr - 1;
+
+    if (ptr)
+    {
+        heap_used -= block->size;
+        free(block);
+    }
+}
+
+
+static void vibe(uint32_t ms)
+{
+    host_counter_inc(HOST_VIBE, 1);
+    shared->vibe_until = shared->now + ms;
+}
+
+
+void vibes_cancel(void)
+{
+    shared->vibe_until = shared->now;
+}
+
+
+void vibes_short_pulse(void)
+{
+    vibe(250);
+}
+
+
+void vibes_long_pulse(void)
+{
+    vibe(500);
+}
+
+
+void vibes_double_pulse(void)
+{
+    vibe(350);
+}
+
+
+void vibes_enqueue_custom_pattern(VibePattern pattern)
+{
+    uint32_t ms = 0;
+    uint32_t i;
+
+    for (i = 0; i < pattern.num_segments; i++)
+    {
+        ms += pattern.durations[i];
+    }
+
+    vibe(ms);
+}
+
+
+static void layer_init(Layer *layer, LayerKind kind, GRect frame)
+{
+    memset(layer, 0, sizeof(Layer));
+    layer->kind = kind;
+    layer->frame = frame;
+}
+
+
+static void invalidate(void)
+{
+    dirty = true;
+    host_counter_inc(HOST_MARK_DIRTY, 1);
+}
+
+
+Layer *layer_create(GRect frame)
+{
+    return layer_create_with_data(frame, 0);
+}
+
+
+Layer *layer_create_with_data(GRect frame, size_t data_size)
+{
+    Layer *layer = host_zalloc(sizeof(Layer) + data_size);
+
+    if (layer)
+    {
+        host_counter_inc(HOST_LAYER_CREATE, 1);
+        layer_init(layer, LAYER_PLAIN, frame);
+        layer->data = data_size ? layer + 1 : NULL;
+    }
+
+    return layer;
+}
+
+
+void layer_destroy(Layer *layer)
+{
+    if (layer)
+    {
+        layer_remove_from_parent(layer);
+        host_free(layer);
+    }
+}
+
+
+void *layer_get_data(const Layer *layer)
+{
+    return layer->data;
+}
+
+
+void layer_mark_dirty(Layer *layer)
+{
+    invalidate();
+}
+
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc)
+{
+    layer->update_proc = update_proc;
+}
+
+
+void layer_set_frame(Layer *layer, GRect frame)
+{
+    layer->frame = frame;
+    invalidate();
+}
+
+
+GRect layer_get_frame(const Layer *layer)
+{
+    return layer->frame;
+}
+
+
+GRect layer_get_bounds(const Layer *layer)
+{
+    return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+
+void layer_add_child(Layer *parent, Layer *child)
+{
+    Layer **p;
+
+    layer_remove_from_parent(child);
+    for (p = &parent->first_child; *p; p = &(*p)->next_sibling)
+    {
+    }
+
+    *p = child;
+    child->parent = parent;
+    child->next_sibling = NULL;
+    invalidate();
+}
+
+
+void layer_remove_from_parent(Layer *child)
+{
+    Layer **p;
+
+    if (child->parent == NULL)
+    {
+        return;
+    }
+
+    for (p = &child->parent->first_child; *p; p = &(*p)->next_sibling)
+    {
+        if (*p == child)
+        {
+            *p = child->next_sibling;
+            break;
+        }
+    }
+
+    child->parent = NULL;
+    child->next_sibling = NULL;
+}
+
+
+void layer_set_hidden(Layer *layer, bool hidden)
+{
+    if (layer->hidden != hidden)
+    {
+        layer->hidden = hidden;
+        invalidate();
+    }
+}
+
+
+bool layer_get_hidden(const Layer *layer)
+{
+    return layer->hidden;
+}
+
+
+TextLayer *text_layer_create(GRect frame)
+{
+    TextLayer *text_layer = host_zalloc(sizeof(TextLayer));
+
+    if (text_layer)
+    {
+        host_counter_inc(HOST_LAYER_CREATE, 1);
+        layer_init(&text_layer->layer, LAYER_TEXT, frame);
+        text_layer->text_color = GColorBlack;
+        text_layer->background_color = GColorWhite;
+    }
+
+    return text_layer;
+}
+
+
+void text_layer_destroy(TextLayer *text_layer)
+{
+    if (text_layer)
+    {
+        layer_remove_from_parent(&text_layer->layer);
+        host_free(text_layer);
+    }
+}
+
+
+Layer *text_layer_get_layer(TextLayer *text_layer)
+{
+    return &text_layer->layer;
+}
+
+
+void text_layer_set_text(TextLayer *text_layer, const char *text)
+{
+    host_counter_inc(HOST_SET_TEXT, 1);
+    text_layer->text = text;
+    invalidate();
+}
+
+
+const char *text_layer_get_text(TextLayer *text_layer)
+{
+    return text_layer->text;
+}
+
+
+void text_layer_set_font(TextLayer *text_layer, GFont font)
+{
+    text_layer->font = font;
+}
+
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color)
+{
+    text_layer->text_color = color;
+}
+
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color)
+{
+    text_layer->background_color = color;
+}
+
+
+void text_layer_set_text_alignment(TextLayer *text_layer,
+                                   GTextAlignment text_alignment)
+{
+    text_layer->alignment = text_alignment;
+}
+
+
+BitmapLayer *bitmap_layer_create(GRect frame)
+{
+    BitmapLayer *bitmap_layer = host_zalloc(sizeof(BitmapLayer));
+
+    if (bitmap_layer)
+    {
+        host_counter_inc(HOST_LAYER_CREATE, 1);
+        layer_init(&bitmap_layer->layer, LAYER_BITMAP, frame);
+        bitmap_layer->alignment = GAlignCenter;
+    }
+
+    return bitmap_layer;
+}
+
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer)
+{
+    if (bitmap_layer)
+    {
+        layer_remove_from_parent(&bitmap_layer->layer);
+        host_free(bitmap_layer);
+    }
+}
+
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer)
+{
+    return (Layer *)&bitmap_layer->layer;
+}
+
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer,
+                             const GBitmap *bitmap)
+{
+    bitmap_layer->bitmap = bitmap;
+    invalidate();
+}
+
+
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment)
+{
+    bitmap_layer->alignment = alignment;
+}
+
+
+InverterLayer *inverter_layer_create(GRect frame)
+{
+    InverterLayer *inverter_layer = host_zalloc(sizeof(InverterLayer));
+
+    if (inverter_layer)
+    {
+        host_counter_inc(HOST_LAYER_CREATE, 1);
+        layer_init(&inverter_layer->layer, LAYER_INVERTER, frame);
+    }
+
+    return inverter_layer;
+}
+
+
+void inverter_layer_destroy(InverterLayer *inverter_layer)
+{
+    if (inverter_layer)
+    {
+        layer_remove_from_parent(&inverter_layer->layer);
+        host_free(inverter_layer);
+    }
+}
+
+
+Layer *inverter_layer_get_layer(InverterLayer *inverter_layer)
+{
+    return &inverter_layer->layer;
+}
+
+
+Window *window_create(void)
+{
+    Window *window = host_zalloc(sizeof(Window));
+
+    if (window)
+    {
+        layer_init(&window->root,
+                   LAYER_PLAIN,
+                   GRect(0, 0, HOST_SCREEN_W, HOST_SCREEN_H));
+        window->background = GColorWhite;
+    }
+
+    return window;
+}
+
+
+void window_destroy(Window *window)
+{
+    if (window == top)
+    {
+        top = NULL;
+    }
+
+    host_free(window);
+}
+
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers)
+{
+    window->handlers = handlers;
+}
+
+
+void window_set_click_config_provider(Window *window,
+                                      ClickConfigProvider click_config_provider)
+{
+    window->click_config = click_config_provider;
+}
+
+
+void window_set_fullscreen(Window *window, bool enabled)
+{
+}
+
+
+void window_set_background_color(Window *window, GColor background_color)
+{
+    window->background = background_color;
+}
+
+
+Layer *window_get_root_layer(const Window *window)
+{
+    return (Layer *)&window->root;
+}
+
+
+/* Only one window deep, which is all the app uses.
+*/
+void window_stack_push(Window *window, bool animated)
+{
+    top = window;
+    memset(clicks, 0, sizeof(clicks));
+    if (window->click_config)
+    {
+        window->click_config(NULL);
+    }
+
+    if (!window->loaded)
+    {
+        window->loaded = true;
+        if (window->handlers.load)
+        {
+            window->handlers.load(window);
+        }
+    }
+
+    invalidate();
+}
+
+
+Window *window_stack_pop(bool animated)
+{
+    Window *window = top;
+
+    if (window)
+    {
+        top = NULL;
+        memset(clicks, 0, sizeof(clicks));
+        if (window->loaded)
+        {
+            window->loaded = false;
+            if (window->handlers.unload)
+            {
+                window->handlers.unload(window);
+            }
+        }
+    }
+
+    return window;
+}
+
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler)
+{
+    clicks[button_id].single = handler;
+}
+
+
+void window_single_repeating_click_subscribe(ButtonId button_id,
+                                             uint16_t repeat_interval_ms,
+                                             ClickHandler handler)
+{
+    clicks[button_id].single = handler;
+}
+
+
+void window_multi_click_subscribe(ButtonId button_id,
+                                  uint8_t min_clicks,
+                                  uint8_t max_clicks,
+                                  uint16_t timeout,
+                                  bool last_click_only,
+                                  ClickHandler handler)
+{
+    clicks[button_id].multi = handler;
+    clicks[button_id].multi_min = min_clicks;
+    clicks[button_id].multi_max = max_clicks;
+}
+
+
+void window_long_click_subscribe(ButtonId button_id,
+                                 uint16_t delay_ms,
+                                 ClickHandler down_handler,
+                                 ClickHandler up_handler)
+{
+    clicks[button_id].long_down = down_handler;
+    clicks[button_id].long_up = up_handler;
+}
+
+
+uint8_t click_number_of_clicks_counted(ClickRecognizerRef recognizer)
+{
+    return ((Recognizer *)recognizer)->count;
+}
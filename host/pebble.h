@@ -0,0 +1,461 @@
+/****************************************************************************/
+/**
+* Host stand-in for the parts of the Pebble SDK 2 API that DigiChron uses.
+* The app sources are compiled unmodified against this header and linked
+* with pebble.c, so they run as an ordinary Linux program under a virtual
+* clock. See host.h for how a test drives it.
+*
+* Only what the app calls is declared. Types that the app looks inside of,
+* such as GRect and GBitmap, have the same layout as the SDK. The rest are
+* opaque here, as they are in the SDK.
+*
+* @file   pebble.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef PEBBLE_H
+#define PEBBLE_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/* Resource ids, in appinfo.json order as the SDK numbers them.
+*/
+#define RESOURCE_ID_IMAGE_MENU_ICON             (1)
+#define RESOURCE_ID_IMAGE_STATUS_BAR            (2)
+#define RESOURCE_ID_FONT_ROBOTO_CONDENSED_14    (3)
+#define RESOURCE_ID_IMAGE_GLYPH_ATLAS           (4)
+#define RESOURCE_ID_ZONE_TABLE                  (5)
+
+
+/* Logging.
+*/
+typedef enum
+{
+    APP_LOG_LEVEL_ERROR = 1,
+    APP_LOG_LEVEL_WARNING = 50,
+    APP_LOG_LEVEL_INFO = 100,
+    APP_LOG_LEVEL_DEBUG = 200,
+    APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+}
+AppLogLevel;
+
+#define APP_LOG(level, fmt, args...) \
+    app_log((level), __FILE__, __LINE__, fmt, ## args)
+
+void app_log(uint8_t log_level,
+             const char *src_filename,
+             int src_line_number,
+             const char *fmt,
+             ...) __attribute__((format(printf, 4, 5)));
+
+
+typedef enum
+{
+    S_SUCCESS = 0,
+    E_ERROR = -1,
+    E_UNKNOWN = -2,
+    E_INTERNAL = -3,
+    E_INVALID_ARGUMENT = -4,
+    E_OUT_OF_MEMORY = -5,
+    E_OUT_OF_STORAGE = -6,
+    E_OUT_OF_RESOURCES = -7,
+    E_RANGE = -8,
+    E_DOES_NOT_EXIST = -9,
+    E_INVALID_OPERATION = -10,
+    E_BUSY = -11,
+    S_TRUE = 1,
+    S_FALSE = 0,
+    S_NO_MORE_ITEMS = 2,
+    S_NO_ACTION_REQUIRED = 3,
+}
+StatusCode;
+
+typedef int32_t status_t;
+
+
+/* Graphics types.
+*/
+typedef struct GPoint
+{
+    int16_t x;
+    int16_t y;
+}
+GPoint;
+
+#define GPoint(x, y) ((GPoint){(x), (y)})
+
+typedef struct GSize
+{
+    int16_t w;
+    int16_t h;
+}
+GSize;
+
+#define GSize(w, h) ((GSize){(w), (h)})
+
+typedef struct GRect
+{
+    GPoint origin;
+    GSize size;
+}
+GRect;
+
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+
+typedef enum GColor
+{
+    GColorClear = ~0,
+    GColorBlack = 0,
+    GColorWhite = 1,
+}
+GColor;
+
+typedef enum
+{
+    GCornerNone = 0,
+    GCornerTopLeft = 1 << 0,
+    GCornerTopRight = 1 << 1,
+    GCornerBottomLeft = 1 << 2,
+    GCornerBottomRight = 1 << 3,
+    GCornersAll = 0xf,
+}
+GCornerMask;
+
+typedef enum
+{
+    GCompOpAssign,
+    GCompOpAssignInverted,
+    GCompOpOr,
+    GCompOpAnd,
+    GCompOpClear,
+    GCompOpSet,
+}
+GCompOp;
+
+typedef enum
+{
+    GAlignCenter,
+    GAlignTopLeft,
+    GAlignTopRight,
+    GAlignTop,
+    GAlignLeft,
+    GAlignBottom,
+    GAlignRight,
+    GAlignBottomRight,
+    GAlignBottomLeft,
+}
+GAlign;
+
+typedef enum
+{
+    GTextAlignmentLeft,
+    GTextAlignmentCenter,
+    GTextAlignmentRight,
+}
+GTextAlignment;
+
+/* 1-bit image, one bit per pixel, least significant bit leftmost, rows
+* padded to a multiple of 4 bytes. A set bit is white.
+*/
+typedef struct
+{
+    void *addr;
+    uint16_t row_size_bytes;
+    uint16_t info_flags;
+    GRect bounds;
+}
+GBitmap;
+
+typedef struct GContext GContext;
+typedef void *GFont;
+typedef struct Layer Layer;
+typedef struct TextLayer TextLayer;
+typedef struct BitmapLayer BitmapLayer;
+typedef struct InverterLayer InverterLayer;
+typedef struct Window Window;
+typedef struct AppTimer AppTimer;
+typedef void *ClickRecognizerRef;
+typedef const void *ResHandle;
+
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+
+/* Time.
+*/
+typedef enum
+{
+    SECOND_UNIT = 1 << 0,
+    MINUTE_UNIT = 1 << 1,
+    HOUR_UNIT = 1 << 2,
+    DAY_UNIT = 1 << 3,
+    MONTH_UNIT = 1 << 4,
+    YEAR_UNIT = 1 << 5,
+}
+TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms);
+bool clock_is_24h_style(void);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer *app_timer_register(uint32_t timeout_ms,
+                             AppTimerCallback callback,
+                             void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+
+/* Wakeup and launch.
+*/
+typedef int32_t WakeupId;
+typedef void (*WakeupHandler)(WakeupId wakeup_id, int32_t cookie);
+
+WakeupId wakeup_schedule(time_t timestamp,
+                         int32_t cookie,
+                         bool notify_if_missed);
+void wakeup_cancel(WakeupId wakeup_id);
+void wakeup_cancel_all(void);
+void wakeup_service_subscribe(WakeupHandler handler);
+bool wakeup_get_launch_event(WakeupId *wakeup_id, int32_t *cookie);
+bool wakeup_query(WakeupId wakeup_id, time_t *timestamp);
+
+typedef enum
+{
+    APP_LAUNCH_SYSTEM,
+    APP_LAUNCH_USER,
+    APP_LAUNCH_PHONE,
+    APP_LAUNCH_WAKEUP,
+    APP_LAUNCH_WORKER,
+    APP_LAUNCH_QUICK_LAUNCH,
+}
+AppLaunchReason;
+
+AppLaunchReason launch_reason(void);
+
+void app_event_loop(void);
+
+
+/* Persistent storage.
+*/
+#define PERSIST_DATA_MAX_LENGTH     (256)
+#define PERSIST_STRING_MAX_LENGTH   PERSIST_DATA_MAX_LENGTH
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+bool persist_read_bool(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+status_t persist_write_bool(const uint32_t key, const bool value);
+status_t persist_write_int(const uint32_t key, const int32_t value);
+int persist_write_data(const uint32_t key,
+                       const void *data,
+                       const size_t size);
+status_t persist_delete(const uint32_t key);
+
+
+/* Services.
+*/
+typedef struct
+{
+    uint8_t charge_percent;
+    bool is_charging;
+    bool is_plugged;
+}
+BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+typedef void (*BluetoothConnectionHandler)(bool connected);
+
+BatteryChargeState battery_state_service_peek(void);
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+
+bool bluetooth_connection_service_peek(void);
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler);
+void bluetooth_connection_service_unsubscribe(void);
+
+void light_enable_interaction(void);
+
+size_t heap_bytes_free(void);
+size_t heap_bytes_used(void);
+
+
+/* Vibes.
+*/
+typedef struct
+{
+    const uint32_t *durations;
+    uint32_t num_segments;
+}
+VibePattern;
+
+void vibes_cancel(void);
+void vibes_short_pulse(void);
+void vibes_long_pulse(void);
+void vibes_double_pulse(void);
+void vibes_enqueue_custom_pattern(VibePattern pattern);
+
+
+/* Resources.
+*/
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle h);
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length);
+size_t resource_load_byte_range(ResHandle h,
+                                uint32_t start_offset,
+                                uint8_t *buffer,
+                                size_t num_bytes);
+
+GFont fonts_load_custom_font(ResHandle handle);
+void fonts_unload_custom_font(GFont font);
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap,
+                                      GRect sub_rect);
+void gbitmap_destroy(GBitmap *bitmap);
+
+
+/* Layers.
+*/
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+void layer_mark_dirty(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_set_frame(Layer *layer, GRect frame);
+GRect layer_get_frame(const Layer *layer);
+GRect layer_get_bounds(const Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+void layer_set_hidden(Layer *layer, bool hidden);
+bool layer_get_hidden(const Layer *layer);
+
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+const char *text_layer_get_text(TextLayer *text_layer);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_alignment(TextLayer *text_layer,
+                                   GTextAlignment text_alignment);
+
+BitmapLayer *bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer);
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer,
+                             const GBitmap *bitmap);
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment);
+
+InverterLayer *inverter_layer_create(GRect frame);
+void inverter_layer_destroy(InverterLayer *inverter_layer);
+Layer *inverter_layer_get_layer(InverterLayer *inverter_layer);
+
+
+/* Graphics.
+*/
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_fill_rect(GContext *ctx,
+                        GRect rect,
+                        uint16_t corner_radius,
+                        GCornerMask corner_mask);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_draw_round_rect(GContext *ctx, GRect rect, uint16_t radius);
+void graphics_draw_bitmap_in_rect(GContext *ctx,
+                                  const GBitmap *bitmap,
+                                  GRect rect);
+
+
+/* Windows and clicks.
+*/
+typedef enum
+{
+    BUTTON_ID_BACK,
+    BUTTON_ID_UP,
+    BUTTON_ID_SELECT,
+    BUTTON_ID_DOWN,
+    NUM_BUTTONS,
+}
+ButtonId;
+
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+
+typedef void (*WindowHandler)(Window *window);
+
+typedef struct WindowHandlers
+{
+    WindowHandler load;
+    WindowHandler appear;
+    WindowHandler disappear;
+    WindowHandler unload;
+}
+WindowHandlers;
+
+Window *window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_click_config_provider(Window *window,
+                                      ClickConfigProvider click_config_provider);
+void window_set_fullscreen(Window *window, bool enabled);
+void window_set_background_color(Window *window, GColor background_color);
+Layer *window_get_root_layer(const Window *window);
+void window_stack_push(Window *window, bool animated);
+Window *window_stack_pop(bool animated);
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+void window_single_repeating_click_subscribe(ButtonId button_id,
+                                             uint16_t repeat_interval_ms,
+                                             ClickHandler handler);
+void window_multi_click_subscribe(ButtonId button_id,
+                                  uint8_t min_clicks,
+                                  uint8_t max_clicks,
+                                  uint16_t timeout,
+                                  bool last_click_only,
+                                  ClickHandler handler);
+void window_long_click_subscribe(ButtonId button_id,
+                                 uint16_t delay_ms,
+                                 ClickHandler down_handler,
+                                 ClickHandler up_handler);
+uint8_t click_number_of_clicks_counted(ClickRecognizerRef recognizer);
+
+
+#endif  /* include guard */
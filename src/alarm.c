@@ -1,6 +1,23 @@
 /****************************************************************************/
 /**
-* Definitions for a watch face that sets an alarm.
+* Definitions for a face with several alarms. Each alarm goes off once,
+* every day, or on weekdays, and can be snoozed. Only the alarm that is
+* due soonest is registered with the wakeup service, so the app can be
+* closed and the watch will start it when the alarm is due. Any other
+* alarm due by then rings along with it.
+*
+* Titles:
+*       n MODE  Which alarm is on screen and how it repeats: OFF, ONCE,
+*               DAILY, WKDAY, or SNZ while it is snoozed.
+*
+* Buttons:
+*       UP      In setting mode, increase the highlighted value. Otherwise
+*               show the next alarm.
+*       SEL     While alarms are ringing, snooze them. In setting mode, move
+*               the highlight to the other field. Otherwise change how the
+*               alarm repeats, or turn it off.
+*       L-SEL   Switch between alarm and setting mode.
+*       DN      In setting mode, decrease the highlighted value.
 *
 * @file   alarm.c
 *
@@ -27,78 +44,687 @@
 * THE SOFTWARE.
 *
 *****************************************************************************/
+#include "alarm.h"
 #include "display.h"
+#include "fmt.h"
+#include "record.h"
 #include "utils.h"
-#include "watch.h"
+#include "vibe.h"
+
+
+#define ALARM_COUNT         (4)
+#define ALARM_SNOOZE_SEC    (5 * 60)
+#define ALARM_HORIZON_SEC   (8 * 24 * 60 * 60)  /* none is set further out */
+#define ALARM_VIBE_BASE     (8)     /* vibe sources 8-15 are the alarms */
+#define ALARM_VIBE_SOURCES  (((1UL << ALARM_COUNT) - 1) << ALARM_VIBE_BASE)
+#define ALARM_VERSION       (1)     /* persisted record layout */
 
 
+typedef enum
+{
+    REPEAT_OFF,
+    REPEAT_ONCE,
+    REPEAT_DAILY,
+    REPEAT_WEEKDAYS,
+    REPEAT_COUNT,
+}
+Repeat;
+
+typedef enum
+{
+    STATE_SHOW,
+    STATE_SET_HRS,
+    STATE_SET_MIN,
+}
+State;
+
+#define ALARM_SNOOZED       (0x01)  /* next is the snooze, not the schedule */
+
+/* One alarm, as persisted.
+*/
+typedef struct _Alarm
+{
+    uint8_t hour;
+    uint8_t min;
+    uint8_t repeat;
+    uint8_t flags;
+    int32_t next;               /* when it goes off next, 0 = never */
+}
+Alarm;
+
+/* Everything that is persisted, RECORD_TAG_ALARMS.
+*/
+typedef struct _Store
+{
+    Alarm alarms[ALARM_COUNT];
+    int32_t wakeup_id;          /* registered wakeup, < 0 if none */
+    int32_t wakeup_time;        /* when it is for */
+}
+Store;
+
 typedef struct _Private
 {
-    int day_flag;               /* TRUE displays day instead of date */
-    int force_day_update;       /* Forces day/date update after seconds */
+    Store store;
+
+    uint8_t order[ALARM_COUNT]; /* alarms soonest first, off ones last */
+    uint8_t current;            /* alarm on screen */
+    State state;
+    uint8_t ringing;            /* bit per alarm that is ringing */
+    bool visible;
 } Private;
 
+FACE_STORAGE(storage, Private);
 
-static bool click_sel(Face *face)
+_Static_assert(sizeof(Store) <= RECORD_ALARMS_SIZE,
+               "alarms don't fit their record");
+
+
+/* The wakeup service has no context pointer, so it finds the face here.
+*/
+static Face *alarm_face;
+
+static const char *repeat_names[REPEAT_COUNT] =
+{
+    [REPEAT_OFF] = "OFF",
+    [REPEAT_ONCE] = "ONCE",
+    [REPEAT_DAILY] = "DAILY",
+    [REPEAT_WEEKDAYS] = "WKDAY",
+};
+
+
+static bool armed(Alarm *a)
+{
+    return a->next && (a->repeat != REPEAT_OFF || (a->flags & ALARM_SNOOZED));
+}
+
+
+/* Work out when an alarm next goes off after a given time, going by the
+* local calendar so it stays at the same wall clock time across daylight
+* saving changes.
+*/
+static time_t next_fire(Alarm *a, time_t after)
 {
+    struct tm today = *localtime(&after);
+    int day;
+
+    if (a->repeat == REPEAT_OFF)
+    {
+        return 0;
+    }
+
+    for (day = 0; day <= 7; day++)
+    {
+        struct tm t = today;
+        time_t when;
+
+        t.tm_mday += day;
+        t.tm_hour = a->hour;
+        t.tm_min = a->min;
+        t.tm_sec = 0;
+        t.tm_isdst = -1;
+        when = mktime(&t);
+
+        if (when <= after)
+        {
+            continue;
+        }
+        if (a->repeat == REPEAT_WEEKDAYS && (t.tm_wday == 0 || t.tm_wday == 6))
+        {
+            continue;
+        }
+
+        return when;
+    }
+
     return 0;
 }
 
 
+/* Sort the alarms by when they go off, then make sure the wakeup service
+* has the soonest one and only that one.
+*/
+static void reschedule(Private *pvt)
+{
+    Store *s = &pvt->store;
+    Alarm *first;
+    int i;
+    int j;
+
+    for (i = 0; i < ALARM_COUNT; i++)
+    {
+        uint8_t n = i;
+
+        for (j = i; j > 0; j--)
+        {
+            Alarm *a = &s->alarms[pvt->order[j - 1]];
+            Alarm *b = &s->alarms[n];
+
+            if (armed(a) && (!armed(b) || a->next <= b->next))
+            {
+                break;
+            }
+            pvt->order[j] = pvt->order[j - 1];
+        }
+        pvt->order[j] = n;
+    }
+
+    first = &s->alarms[pvt->order[0]];
+    if (armed(first) && s->wakeup_id >= 0 && s->wakeup_time == first->next)
+    {
+        return;
+    }
+
+    if (s->wakeup_id >= 0)
+    {
+        wakeup_cancel(s->wakeup_id);
+        s->wakeup_id = -1;
+    }
+
+    if (armed(first))
+    {
+        s->wakeup_id = wakeup_schedule(first->next, pvt->order[0], true);
+        s->wakeup_time = first->next;
+        if (s->wakeup_id < 0)
+        {
+            LOG_MSG_ERROR("Can't schedule wakeup, error %ld", (long)s->wakeup_id);
+        }
+    }
+}
+
+
+/* Checkpoint the alarms. Done on every change that has to survive the app
+* being killed, which is nearly all of them, since the wakeup registered
+* with the system has to match what is saved.
+*/
+static void save(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    record_write(face->key, RECORD_TAG_ALARMS, ALARM_VERSION,
+                 &pvt->store, sizeof(Store));
+}
+
+
+static void show(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    Alarm *a = &pvt->store.alarms[pvt->current];
+    struct tm t;
+    char title[8];
+    char *s;
+
+    memset(&t, 0, sizeof(t));
+    t.tm_hour = a->hour;
+    t.tm_min = a->min;
+    display_set_time(&t, HOUR_UNIT | MINUTE_UNIT, 0);
+
+    s = fmt_int(title, pvt->current + 1);
+    *s++ = ' ';
+    strcpy(s, (a->flags & ALARM_SNOOZED) ? "SNZ" : repeat_names[a->repeat]);
+    display_set_title(title);
+
+    if (pvt->ringing & (1 << pvt->current))
+    {
+        display_set_highlight(HL_DATE);
+    }
+    else if (pvt->state == STATE_SET_HRS)
+    {
+        display_set_highlight(HL_HOURS);
+    }
+    else if (pvt->state == STATE_SET_MIN)
+    {
+        display_set_highlight(HL_MINUTES);
+    }
+    else
+    {
+        display_set_highlight(HL_NONE);
+    }
+}
+
+
+static void stop_ringing(Private *pvt)
+{
+    int i;
+
+    for (i = 0; i < ALARM_COUNT; i++)
+    {
+        if (pvt->ringing & (1 << i))
+        {
+            vibe_ring_stop(ALARM_VIBE_BASE + i);
+        }
+    }
+    pvt->ringing = 0;
+}
+
+
+/* The first alarm that is ringing, for showing it.
+*/
+static int first_ringing(Private *pvt)
+{
+    int i;
+
+    for (i = 0; i < ALARM_COUNT; i++)
+    {
+        if (pvt->ringing & (1 << i))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+/* Ring every alarm that is due by now and work out when each goes off
+* next. Two alarms can be set for the same minute, and only one of them
+* has the wakeup, so they all have to be looked at. None is left due
+* afterwards, which keeps reschedule() from asking for a past time.
+*/
+static void fire_due(Face *face, time_t now)
+{
+    Private *pvt = (Private *)face->data;
+    uint8_t due = 0;
+    int i;
+
+    for (i = 0; i < ALARM_COUNT; i++)
+    {
+        Alarm *a = &pvt->store.alarms[i];
+
+        if (!armed(a) || a->next > now)
+        {
+            continue;
+        }
+
+        due |= 1 << i;
+        a->flags &= ~ALARM_SNOOZED;
+        if (a->repeat == REPEAT_ONCE)
+        {
+            a->repeat = REPEAT_OFF;
+        }
+        a->next = next_fire(a, now);
+    }
+
+    if (due)
+    {
+        stop_ringing(pvt);
+        pvt->ringing = due;
+        for (i = 0; i < ALARM_COUNT; i++)
+        {
+            if (due & (1 << i))
+            {
+                vibe_ring_start(ALARM_VIBE_BASE + i);
+            }
+        }
+    }
+
+    reschedule(pvt);
+    save(face);
+
+    if (due && pvt->visible)
+    {
+        pvt->current = first_ringing(pvt);
+        show(face);
+    }
+}
+
+
+/* The wakeup can come a little early, so the alarm it was for counts as
+* due even if the clock hasn't quite got there.
+*/
+static time_t due_time(Private *pvt, int32_t cookie)
+{
+    time_t now = time(NULL);
+
+    if (cookie >= 0 && cookie < ALARM_COUNT
+        && armed(&pvt->store.alarms[cookie])
+        && pvt->store.alarms[cookie].next > now
+        && pvt->store.alarms[cookie].next == pvt->store.wakeup_time)
+    {
+        now = pvt->store.alarms[cookie].next;
+    }
+
+    return now;
+}
+
+
+static void wakeup_handler(WakeupId id, int32_t cookie)
+{
+    Private *pvt = (Private *)alarm_face->data;
+    time_t now = due_time(pvt, cookie);
+
+    pvt->store.wakeup_id = -1;
+    fire_due(alarm_face, now);
+}
+
+
+static bool click_sel(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    Alarm *a = &pvt->store.alarms[pvt->current];
+    int i;
+
+    if (pvt->ringing)
+    {
+        /* Snooze everything that is ringing, not just the one shown.
+        */
+        for (i = 0; i < ALARM_COUNT; i++)
+        {
+            if (pvt->ringing & (1 << i))
+            {
+                a = &pvt->store.alarms[i];
+                a->flags |= ALARM_SNOOZED;
+                a->next = time(NULL) + ALARM_SNOOZE_SEC;
+            }
+        }
+        stop_ringing(pvt);
+        reschedule(pvt);
+    }
+    else if (pvt->state == STATE_SET_HRS)
+    {
+        pvt->state = STATE_SET_MIN;
+    }
+    else if (pvt->state == STATE_SET_MIN)
+    {
+        pvt->state = STATE_SET_HRS;
+    }
+    else
+    {
+        if (++a->repeat >= REPEAT_COUNT)
+        {
+            a->repeat = REPEAT_OFF;
+        }
+        a->flags &= ~ALARM_SNOOZED;
+        a->next = next_fire(a, time(NULL));
+        reschedule(pvt);
+    }
+
+    save(face);
+    show(face);
+    return true;
+}
+
+
+/* Leave setting mode and arm the alarm that was set. Setting the time
+* means the alarm is wanted.
+*/
+static void set_done(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    Alarm *a = &pvt->store.alarms[pvt->current];
+
+    pvt->state = STATE_SHOW;
+    if (a->repeat == REPEAT_OFF)
+    {
+        a->repeat = REPEAT_ONCE;
+    }
+    a->flags &= ~ALARM_SNOOZED;
+    a->next = next_fire(a, time(NULL));
+    reschedule(pvt);
+    save(face);
+}
+
+
+static bool click_long_sel(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->state == STATE_SHOW)
+    {
+        pvt->state = STATE_SET_HRS;
+    }
+    else
+    {
+        set_done(face);
+    }
+
+    show(face);
+    return true;
+}
+
+
+/* Move the highlighted field of the current alarm by n, wrapping around.
+*/
+static void adjust(Private *pvt, int n)
+{
+    Alarm *a = &pvt->store.alarms[pvt->current];
+
+    if (pvt->state == STATE_SET_HRS)
+    {
+        a->hour = (a->hour + 24 + n % 24) % 24;
+    }
+    else
+    {
+        a->min = (a->min + 60 + n % 60) % 60;
+    }
+}
+
+
+static bool click_up(Face *face, uint8_t count)
+{
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->state == STATE_SHOW)
+    {
+        if (++pvt->current >= ALARM_COUNT)
+        {
+            pvt->current = 0;
+        }
+    }
+    else
+    {
+        adjust(pvt, count > 10 ? 10 : count > 5 ? 5 : 1);
+    }
+
+    show(face);
+    return true;
+}
+
+
+static bool click_dn(Face *face, uint8_t count)
+{
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->state == STATE_SHOW)
+    {
+        return false;
+    }
+
+    adjust(pvt, count > 10 ? -10 : count > 5 ? -5 : -1);
+    show(face);
+    return true;
+}
+
+
+static void shut_up(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->ringing)
+    {
+        stop_ringing(pvt);
+        if (pvt->visible)
+        {
+            show(face);
+        }
+    }
+}
+
+
+/* The ringing gave up with nobody there to stop it. The alarms were already
+* moved on to their next time when they fired.
+*/
+static void give_up_handler(uint32_t sources, void *data)
+{
+    Face *face = data;
+    Private *pvt = (Private *)face->data;
+
+    pvt->ringing &= ~(sources >> ALARM_VIBE_BASE);
+    if (pvt->visible)
+    {
+        show(face);
+    }
+}
+
+
 static void load_handler(Face *face)
 {
-    time_t t = 0;
-    struct tm *zero = gmtime(&t);
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->ringing)
+    {
+        pvt->current = first_ringing(pvt);
+    }
 
-    display_set_time(zero, 0xff, 0);
-    display_set_title("ALM");
+    pvt->visible = true;
+    display_clear();
+    show(face);
 }
 
 
 static void unload_handler(Face *face)
 {
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->state != STATE_SHOW)
+    {
+        /* Leaving in the middle of setting, take what was set.
+        */
+        set_done(face);
+    }
+    pvt->visible = false;
     display_clear();
 }
 
 
 static void update_handler(Face *face, struct tm *tt, TimeUnits uc)
 {
+    /* nothing to do, the wakeup service does the timing */
 }
 
 
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
-*
-* @return  Pointer to the face, or NULL on error.
+* Create the alarm face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *****************************************************************************/
-Face *alarm_create(void)
+Face *alarm_create(const char *name, uint32_t key)
 {
-    Face *face = malloc(sizeof(Face) + sizeof(Private));
+    Face *face = (Face *)storage;
+    Private *pvt = (Private *)face->data;
+    WakeupId id;
+    int32_t cookie;
+    time_t now = time(NULL);
+    int i;
 
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    if (face)
+    memset(storage, 0, sizeof(storage));
+
+    face->load_handler = load_handler;
+    face->unload_handler = unload_handler;
+    face->update_handler = update_handler;
+    face->click_sel = click_sel;
+    face->click_long_sel = click_long_sel;
+    face->click_up = click_up;
+    face->click_dn = click_dn;
+    face->shut_up = shut_up;
+
+    face->tick_units = 0;
+    face->tick_hidden = false;
+
+    strncpy(face->name, name, sizeof(face->name));
+    face->name[sizeof(face->name) - 1] = 0;
+    face->key = key;
+
+    pvt->store.wakeup_id = -1;
+    record_read(face->key, RECORD_TAG_ALARMS, ALARM_VERSION,
+                &pvt->store, sizeof(Store));
+
+    for (i = 0; i < ALARM_COUNT; i++)
+    {
+        pvt->order[i] = i;
+    }
+
+    alarm_face = face;
+    wakeup_service_subscribe(wakeup_handler);
+    vibe_give_up_subscribe(ALARM_VIBE_SOURCES, give_up_handler, face);
+
+    /* Started by the watch because an alarm is due.
+    */
+    if (launch_reason() == APP_LAUNCH_WAKEUP
+        && wakeup_get_launch_event(&id, &cookie))
     {
-        memset(face, 0, sizeof(Face) + sizeof(Private));
+        now = due_time(pvt, cookie);
+        pvt->store.wakeup_id = -1;
+        fire_due(face, now);
+    }
 
-        face->load_handler = load_handler;
-        face->unload_handler = unload_handler;
-        face->update_handler = update_handler;
-        face->click_sel = click_sel;
+    /* Catch up on an alarm that was missed with the watch off. Times are
+    * local, so a time zone or daylight saving change leaves the rest
+    * right. One that was set more than a week out means the clock went
+    * back by days, so it is worked out again. Going back by less rings
+    * nothing twice.
+    */
+    for (i = 0; i < ALARM_COUNT; i++)
+    {
+        Alarm *a = &pvt->store.alarms[i];
+
+        if (a->next <= now || a->next > now + ALARM_HORIZON_SEC)
+        {
+            a->flags &= ~ALARM_SNOOZED;
+            if (a->repeat == REPEAT_ONCE && a->next && a->next <= now)
+            {
+                a->repeat = REPEAT_OFF;
+            }
+            a->next = next_fire(a, now);
+        }
     }
 
+    reschedule(pvt);
+    save(face);
+
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
     return face;
 }
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Check for an alarm that is set.
+*****************************************************************************/
+bool alarm_busy(uint32_t key)
+{
+    Store store;
+    int i;
+
+    memset(&store, 0, sizeof(Store));
+    if (record_read(key, RECORD_TAG_ALARMS, ALARM_VERSION,
+                    &store, sizeof(Store)) < 0)
+    {
+        return false;
+    }
+
+    for (i = 0; i < ALARM_COUNT; i++)
+    {
+        if (armed(&store.alarms[i]))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+* Destroy the alarm face. Save its state and release resources.
 *****************************************************************************/
 void alarm_destroy(Face *face)
 {
+    Private *pvt = (Private *)face->data;
+
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    free(face);
+    stop_ringing(pvt);
+    wakeup_service_subscribe(NULL);
+    vibe_give_up_subscribe(ALARM_VIBE_SOURCES, NULL, NULL);
+    alarm_face = NULL;
+    save(face);
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
 }
-
@@ -35,18 +35,32 @@
 
 
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
+* Create the alarm face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *
-* @return  Pointer to the face, or NULL on error.
+* @param  name  Name of the face.
+* @param  key   Storage key to use.
+*
+* @return  Pointer to the face.
 *****************************************************************************/
-Face *alarm_create(void);
+Face *alarm_create(const char *name, uint32_t key);
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Destroy the alarm face. Save its state and release resources.
 *****************************************************************************/
 void alarm_destroy(Face *face);
 
 
+/**
+* Check the saved alarms for one that is set. Only the alarm face handles
+* wakeups, so it is created at startup whenever one may be due.
+*
+* @param  key   Storage key the face uses.
+*
+* @return  true if the face must be created at startup.
+*****************************************************************************/
+bool alarm_busy(uint32_t key);
+
+
 #endif  /* include guard */
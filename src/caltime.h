@@ -0,0 +1,61 @@
+/****************************************************************************/
+/**
+* Cached local calendar time. Most calls move the clock forward a second
+* or two from the last call, so the broken-down time is advanced in place
+* instead of running localtime() again. A full localtime() is only done
+* when the clock crosses a local hour boundary, which is where day
+* rollovers and DST transitions happen, or when it jumps backward.
+*
+* @file   caltime.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef CALTIME_H
+#define CALTIME_H
+
+
+#include <pebble.h>
+
+
+/**
+* Get the broken-down local time for a time value. Cheapest when called
+* with times that move forward within the hour.
+*
+* @param t      The time to convert.
+*
+* @return  Pointer to the shared broken-down time. It is only good until
+*          the next call, just like localtime().
+*****************************************************************************/
+struct tm *caltime_get(time_t t);
+
+
+/**
+* Get the broken-down local time for right now.
+*
+* @return  Pointer to the shared broken-down time.
+*****************************************************************************/
+struct tm *caltime_now(void);
+
+
+#endif  /* include guard */
@@ -9,6 +9,7 @@
 *
 * Default button actions:
 *       DBL-BACK        Invert the display.
+*       TPL-BACK        Dump the event trace to the log, if TRACE is on.
 *       SEL             Force a time update.
 *       DN              Switch to the next face.
 *
@@ -17,6 +18,10 @@
 * This is so pressing any key will stop alerts even if the responsible Face
 * is not the active one.
 *
+* Ticks are only delivered to faces that ask for them through tick_units,
+* and only to the active face unless it sets tick_hidden. The tick service
+* runs at the finest rate any face currently needs, or not at all.
+*
 * The display inversion mode and the currently-displayed face are saved when
 * exiting the app.
 *
@@ -46,102 +51,252 @@
 *
 *****************************************************************************/
 #include <pebble.h>
+#include "alarm.h"
+#include "caltime.h"
 #include "display.h"
+#include "hud.h"
+#include "perf.h"
+#include "record.h"
 #include "resources.h"
 #include "utils.h"
 #include "status.h"
 #include "stopwatch.h"
 #include "timer.h"
+#include "trace.h"
 #include "watch.h"
+#include "zone.h"
+
+
+#ifndef LAZY_FACES
+#define LAZY_FACES  (true)  /* false creates every face at startup */
+#endif
+
+
+/* The faces, in the order DOWN steps through them. Each entry is
+* X(module, busy, key, name), and the module provides module_create() and
+* module_destroy(). busy is NULL for a face that never has to be created at
+* startup.
+*/
+#if HUD
+#define FACE_HUD(X) X(hud, NULL, PERSIST_KEY_HUD_STATE, "PERF")
+#else
+#define FACE_HUD(X)
+#endif
+
+#define FACE_LIST(X)                                                        \
+    X(watch, NULL, PERSIST_KEY_WATCH_STATE, "MAIN")                         \
+    X(timer, timer_busy, PERSIST_KEY_TIMERS, "TMR")                         \
+    X(stopwatch, stopwatch_busy, PERSIST_KEY_STW_STATE, "STW")              \
+    X(alarm, alarm_busy, PERSIST_KEY_ALARMS, "ALM")                         \
+    X(zone, NULL, PERSIST_KEY_ZONE, "ZONE")                                 \
+    FACE_HUD(X)
+
+#define FACE_ID(module, busy, key, name)    FACE_##module,
+#define FACE_RECORD(module, busy, key, name)                                \
+    {module##_create, module##_destroy, busy, key, name},
+
+typedef enum
+{
+    FACE_LIST(FACE_ID)
+    FACE_COUNT
+}
+FaceId;
 
 
 typedef struct _FaceRecord
 {
     Face *(*create)(const char *name, uint32_t key);
     void (*destroy)(Face *);
+    bool (*busy)(uint32_t key); /* true = create at startup, NULL = never */
     uint32_t key;
     const char *name;
-    Face *face;
 }
 FaceRecord;
 
+#define MAIN_VERSION    (1)     /* persisted record layout */
+
+
 typedef struct _Active
 {
-    int face;
-    int invert_mode;
+    int32_t face;
+    int32_t invert_mode;
 }
 Active;
 
+_Static_assert(sizeof(Active) <= RECORD_MAIN_SIZE,
+               "active face doesn't fit its record");
+
+
+/* The faces as the baseline release numbered them in the saved Active.
+*/
+static const uint8_t legacy_faces[] =
+{
+    FACE_watch,                 /* MAIN */
+    FACE_timer,                 /* TMR1 */
+    FACE_timer,                 /* TMR2 */
+    FACE_stopwatch,             /* STW */
+};
 
 static Window *window;
 static Active active;
-static FaceRecord faces[] =
+static TimeUnits tick_unit;     /* rate the tick service runs at, 0 = off */
+static const FaceRecord faces[FACE_COUNT] = { FACE_LIST(FACE_RECORD) };
+static Face *live[FACE_COUNT];  /* NULL until first needed */
+
+
+/* Get a face, creating it if this is the first time it is needed.
+*/
+static Face *face_get(int i)
 {
-    {watch_create, watch_destroy, PERSIST_KEY_WATCH_STATE, "MAIN", NULL},
-    {timer_create, timer_destroy, PERSIST_KEY_TMR1_STATE, "TMR1", NULL},
-    {timer_create, timer_destroy, PERSIST_KEY_TMR2_STATE, "TMR2", NULL},
-    {stopwatch_create, stopwatch_destroy, PERSIST_KEY_STW_STATE, "STW", NULL},
-    {NULL, NULL, 0, NULL, NULL},
-};
+    if (live[i] == NULL)
+    {
+        TRACE_EVENT(TRACE_FACE_CREATE, i, 0);
+        live[i] = faces[i].create(faces[i].name, faces[i].key);
+    }
+
+    return live[i];
+}
 
 
 static void shut_up(void)
 {
-    int i = 0;
+    int i;
 
-    while (faces[i].face)
+    for (i = 0; i < FACE_COUNT; i++)
     {
-        if (faces[i].face->shut_up)
+        if (live[i] && live[i]->shut_up)
         {
-            faces[i].face->shut_up(faces[i].face);
+            live[i]->shut_up(live[i]);
         }
-
-        i++;
     }
 }
 
 
 static void update_time(void)
 {
-    time_t t = time(NULL);
-    struct tm *tick_time = localtime(&t);
+    struct tm *tick_time = caltime_now();
     TimeUnits units_changed = SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT | DAY_UNIT;
 
-    faces[active.face].face->update_handler(faces[active.face].face,
-                                            tick_time,
-                                            units_changed);
+    PERF_INC(PERF_UPDATE);
+    live[active.face]->update_handler(live[active.face],
+                                      tick_time,
+                                      units_changed);
 }
 
 
-static void handle_second_tick(struct tm *tick_time, TimeUnits units_changed)
+static void handle_tick(struct tm *tick_time, TimeUnits units_changed);
+
+
+/* Collect the tick units wanted by the active face and by any hidden faces
+* that asked for ticks, then run the tick service at the finest rate anyone
+* needs. Seconds if somebody wants them, otherwise minutes, otherwise off.
+*/
+static void ticks_update(void)
 {
-    int i = 0;
+    TimeUnits needed = 0;
+    TimeUnits unit = 0;
+    int i;
+
+    for (i = 0; i < FACE_COUNT; i++)
+    {
+        if (live[i] && (i == active.face || live[i]->tick_hidden))
+        {
+            needed |= live[i]->tick_units;
+        }
+    }
+
+    if (needed & SECOND_UNIT)
+    {
+        unit = SECOND_UNIT;
+    }
+    else if (needed)
+    {
+        unit = MINUTE_UNIT;
+    }
 
-    while (faces[i].face)
+    if (unit != tick_unit)
     {
-        faces[i].face->update_handler(faces[i].face, tick_time, units_changed);
-        i++;
+        LOG_MSG_DEBUG("tick unit %d -> %d", tick_unit, unit);
+
+        tick_timer_service_unsubscribe();
+        if (unit)
+        {
+            tick_timer_service_subscribe(unit, handle_tick);
+        }
+        tick_unit = unit;
     }
 }
 
 
+#if PERF || TRACE
+/* How long after the second, or the minute, the tick arrived. Ticks are
+* never early, so this is only ever late.
+*/
+static int32_t tick_lateness(void)
+{
+    TimeMS now;
+
+    time_ms(&now.sec, &now.ms);
+
+    return now.ms + (tick_unit == SECOND_UNIT ? 0 : (now.sec % 60) * 1000);
+}
+#endif
+
+
+static void handle_tick(struct tm *tick_time, TimeUnits units_changed)
+{
+    int i;
+#if PERF || TRACE
+    int32_t late = tick_lateness();
+
+    PERF_LATE(PERF_LATE_TICK, late);
+    TRACE_EVENT(TRACE_TICK, units_changed, late);
+#endif
+
+    PERF_INC(PERF_WAKE_TICK);
+
+    for (i = 0; i < FACE_COUNT; i++)
+    {
+        Face *face = live[i];
+
+        if (face
+            && (face->tick_units & units_changed)
+            && (i == active.face || face->tick_hidden))
+        {
+            PERF_INC(PERF_UPDATE);
+            face->update_handler(face, tick_time, units_changed);
+        }
+    }
+
+    ticks_update();
+}
+
+
 static void click_back_handler(ClickRecognizerRef recognizer, void *ctx)
 {
+    TRACE_EVENT(TRACE_CLICK, BUTTON_ID_BACK, 1);
+    PERF_CLICK_START(BUTTON_ID_BACK, active.face);
     shut_up();
     update_time();
     light_enable_interaction();
+    ticks_update();
+    PERF_CLICK_END();
 }
 
 
 static void click_sel_handler(ClickRecognizerRef recognizer, void *ctx)
 {
-    if (!faces[active.face].face->click_sel
-        || !faces[active.face].face->click_sel(faces[active.face].face))
+    TRACE_EVENT(TRACE_CLICK, BUTTON_ID_SELECT, 1);
+    PERF_CLICK_START(BUTTON_ID_SELECT, active.face);
+    if (!live[active.face]->click_sel
+        || !live[active.face]->click_sel(live[active.face]))
     {
         update_time();
     }
 
     shut_up();
+    ticks_update();
+    PERF_CLICK_END();
 }
 
 
@@ -149,12 +304,17 @@ static void click_up_handler(ClickRecognizerRef recognizer, void *ctx)
 {
     uint8_t count = click_number_of_clicks_counted(recognizer);
 
-    if (faces[active.face].face->click_up)
+    TRACE_EVENT(TRACE_CLICK, BUTTON_ID_UP, count);
+    PERF_CLICK_START(BUTTON_ID_UP, active.face);
+
+    if (live[active.face]->click_up)
     {
-        faces[active.face].face->click_up(faces[active.face].face, count);
+        live[active.face]->click_up(live[active.face], count);
     }
 
     shut_up();
+    ticks_update();
+    PERF_CLICK_END();
 }
 
 
@@ -162,35 +322,57 @@ static void click_down_handler(ClickRecognizerRef recognizer, void *ctx)
 {
     uint8_t count = click_number_of_clicks_counted(recognizer);
 
-    if (!faces[active.face].face->click_dn
-        || !faces[active.face].face->click_dn(faces[active.face].face, count))
+    TRACE_EVENT(TRACE_CLICK, BUTTON_ID_DOWN, count);
+    PERF_CLICK_START(BUTTON_ID_DOWN, active.face);
+
+    if (!live[active.face]->click_dn
+        || !live[active.face]->click_dn(live[active.face], count))
     {
-        faces[active.face].face->unload_handler(faces[active.face].face);
-        active.face++;
-        if (faces[active.face].face == NULL)
-        {
-            active.face = 0;
-        }
-        faces[active.face].face->load_handler(faces[active.face].face);
+        TRACE_EVENT(TRACE_FACE_UNLOAD, active.face, 0);
+        live[active.face]->unload_handler(live[active.face]);
+        active.face = (active.face + 1) % FACE_COUNT;
+        TRACE_EVENT(TRACE_FACE_LOAD, active.face, 0);
+        face_get(active.face)->load_handler(live[active.face]);
     }
 
     shut_up();
+    ticks_update();
+    PERF_CLICK_END();
 }
 
 
 static void click_long_sel_handler(ClickRecognizerRef recognizer, void *ctx)
 {
-    if (faces[active.face].face->click_long_sel)
+    TRACE_EVENT(TRACE_CLICK, BUTTON_ID_SELECT, 0);
+    PERF_CLICK_START(BUTTON_ID_SELECT, active.face);
+    if (live[active.face]->click_long_sel)
     {
-        faces[active.face].face->click_long_sel(faces[active.face].face);
+        live[active.face]->click_long_sel(live[active.face]);
     }
+
+    ticks_update();
+    PERF_CLICK_END();
 }
 
 
 static void click_multi_back_handler(ClickRecognizerRef recognizer, void *ctx)
 {
+    uint8_t count = click_number_of_clicks_counted(recognizer);
+
+    TRACE_EVENT(TRACE_CLICK, BUTTON_ID_BACK, count);
+
+    /* Get the trace without having to exit the app.
+    */
+    if (count >= 3)
+    {
+        trace_dump();
+        return;
+    }
+
+    PERF_CLICK_START(BUTTON_ID_BACK, active.face);
     active.invert_mode = !display_get_invert();
     display_set_invert(active.invert_mode);
+    PERF_CLICK_END();
 }
 
 
@@ -211,11 +393,14 @@ static void click_config_provider(void *ctx)
                                 click_long_sel_handler,
                                 NULL);
 
+    /* With the trace on, a triple click has to be told from a double, so
+    * the handler waits for the last click.
+    */
     window_multi_click_subscribe(BUTTON_ID_BACK,
                                  2,
+                                 TRACE ? 3 : 0,
                                  0,
-                                 0,
-                                 false,
+                                 TRACE,
                                  click_multi_back_handler);
 }
 
@@ -224,13 +409,10 @@ static void window_load(Window *window)
 {
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
 
-    if (persist_get_size(PERSIST_KEY_MAIN_STATE) == sizeof(Active))
-    {
-        persist_read_data(PERSIST_KEY_MAIN_STATE, &active, sizeof(Active));
-    }
-
     display_set_invert(active.invert_mode);
-    faces[active.face].face->load_handler(faces[active.face].face);
+    TRACE_EVENT(TRACE_FACE_LOAD, active.face, 0);
+    live[active.face]->load_handler(live[active.face]);
+    ticks_update();
 
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
 }
@@ -240,41 +422,76 @@ static void window_unload(Window *window)
 {
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
 
-    persist_write_data(PERSIST_KEY_MAIN_STATE, &active, sizeof(Active));
-    faces[active.face].face->unload_handler(faces[active.face].face);
+    TRACE_EVENT(TRACE_FACE_UNLOAD, active.face, 0);
+    live[active.face]->unload_handler(live[active.face]);
 
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
 }
 
 
-static bool faces_create(Window *window)
+/* Pick the face to show first and create it, along with any face that has
+* something running. The rest are created when they are first shown.
+*/
+static void faces_create(void)
 {
-    int i = 0;
+    int i;
 
-    while(faces[i].create)
+    if (record_read(PERSIST_KEY_MAIN_STATE, RECORD_TAG_MAIN, MAIN_VERSION,
+                    &active, sizeof(Active)) < 0
+        && record_legacy()
+        && persist_get_size(PERSIST_KEY_MAIN_STATE) == sizeof(Active))
     {
-        faces[i].face = faces[i].create(faces[i].name, faces[i].key);
-        if (faces[i].face == NULL)
-        {
-            break;
-        }
-        i++;
+        persist_read_data(PERSIST_KEY_MAIN_STATE, &active, sizeof(Active));
+        active.face = (active.face >= 0
+                       && active.face < (int)sizeof(legacy_faces))
+                      ? legacy_faces[active.face]
+                      : FACE_watch;
+        record_write(PERSIST_KEY_MAIN_STATE, RECORD_TAG_MAIN, MAIN_VERSION,
+                     &active, sizeof(Active));
+    }
+
+    /* The saved face may be gone if the faces list changed since.
+    */
+    if (active.face < 0 || active.face >= FACE_COUNT)
+    {
+        active.face = 0;
     }
 
-    active.face = 0;
+    /* Started by an alarm, so show the alarm that is ringing.
+    */
+    if (launch_reason() == APP_LAUNCH_WAKEUP)
+    {
+        active.face = FACE_alarm;
+    }
 
-    return faces[active.face].face == NULL; /* we created at least one */
+    /* On the first start after an upgrade every face is created, so each
+    * moves its old state into the first snapshot before the old keys are
+    * deleted.
+    */
+    for (i = 0; i < FACE_COUNT; i++)
+    {
+        if (!LAZY_FACES
+            || i == active.face
+            || record_legacy()
+            || (faces[i].busy && faces[i].busy(faces[i].key)))
+        {
+            face_get(i);
+        }
+    }
 }
 
 
 static void faces_destroy(void)
 {
-    int i = 0;
+    int i;
 
-    while(faces[i].destroy)
+    for (i = 0; i < FACE_COUNT; i++)
     {
-        faces[i].destroy(faces[i].face);
-        i++;
+        if (live[i])
+        {
+            faces[i].destroy(live[i]);
+            live[i] = NULL;
+        }
     }
 }
 
@@ -284,6 +501,16 @@ static bool init(void)
     bool err = true;
     WindowHandlers wh = { .load = window_load, .unload = window_unload };
 
+    perf_start();
+    trace_start();
+
+    /* Everything the faces and window read at startup comes out of the
+    * snapshot, and anything they change while starting goes back in one
+    * write at the end.
+    */
+    record_load();
+    record_begin();
+
     if (res_create())
     {
         LOG_MSG_ERROR("Can't initialize global resources");
@@ -303,12 +530,7 @@ static bool init(void)
         goto error_2;
     }
 
-    if (faces_create(window))
-    {
-        LOG_MSG_ERROR("One or more sub-faces could not be created, aborting");
-        goto error_3;
-    }
-
+    faces_create();
     status_create();
 
     display_set_invert(active.invert_mode);
@@ -317,13 +539,11 @@ static bool init(void)
     window_set_click_config_provider(window, click_config_provider);
     window_stack_push(window, true);
 
-    tick_timer_service_subscribe(SECOND_UNIT, handle_second_tick);
+    ticks_update();
+    record_end();
     err = false;
     goto error_0;
 
-error_3:
-    display_destroy();
-
 error_2:
     window_destroy(window);
 
@@ -338,8 +558,20 @@ error_0:
 static void deinit(void)
 {
     tick_timer_service_unsubscribe();
+    tick_unit = 0;
     status_destroy();
+
+    /* Save everything in one write.
+    */
+    record_begin();
+    record_write(PERSIST_KEY_MAIN_STATE, RECORD_TAG_MAIN, MAIN_VERSION,
+                 &active, sizeof(Active));
     faces_destroy();
+    record_end();
+
+    perf_log();
+    trace_dump();
+
     display_destroy();
     window_destroy(window);
     res_destroy();
@@ -29,27 +29,56 @@
 *
 *****************************************************************************/
 #include "display.h"
+#include "fmt.h"
+#include "glyphs.h"
+#include "perf.h"
 #include "resources.h"
+#include "trace.h"
 #include "utils.h"
 
 
+#define FIELD_UNKNOWN   (-1)    /* field value not known, always redraw */
+#define FIELD_12H       (1000)  /* added to 12h hours, they're formatted
+                                * differently than 24h hours */
+#define FIELD_HOURS     (100)   /* added to interval hours in the AM/PM field */
+
+
+typedef enum
+{
+    FIELD_HOUR,
+    FIELD_HM,                   /* holds the ':' separator */
+    FIELD_MINS,
+    FIELD_SECS,
+    FIELD_AMPM,
+    FIELD_DATE,
+    FIELD_COUNT,
+}
+FieldId;
+
+typedef struct _Field
+{
+    GRect frame;
+    uint8_t font;               /* GlyphFontId */
+    uint8_t align;              /* GTextAlignment */
+    int value;                  /* value last drawn, see field_changed() */
+    char text[8];               /* hh, mm, am, mmm dd, etc */
+}
+Field;
+
 typedef struct _Display
 {
     /* Global inverter layer.
     */
     InverterLayer *invert_layer;
 
-    /* Main display.
+    /* Main display. All of the fields are drawn by the one layer, using
+    * glyphs from the atlas.
     */
-    TextLayer *hour_layer;
-    TextLayer *hm_layer;        /* holds the ':' separator */
-    TextLayer *mins_layer;
-    TextLayer *secs_layer;
-    TextLayer *ampm_layer;
-    TextLayer *date_layer;
     Layer *watch_layer;
-    Layer *box_layer;
-    InverterLayer *hl_layer;    /* highlight layer */
+    GBitmap *glyph_atlas;
+    Field field[FIELD_COUNT];
+    HighlightFields highlight;
+    GRect dirty;                /* what changed since the last redraw */
 
     /* Status display.
     */
@@ -61,27 +90,187 @@ typedef struct _Display
 
     GBitmap *status_bitmap;
 
-    /* Other state.
-    */
-    struct
-    {
-        time_t sec;
-        uint16_t ms;
-    } last_interval;
+    DisplayStats stats;
 
-    /* Field buffers...make them pack neatly into 4-byte words.
-    */
-    char hour_string[4];        /* hh */
-    char hm_string[4];          /* : */
-    char mins_string[4];        /* mm */
-    char secs_string[4];        /* ss */
-    char ampm_string[4];        /* am */
-    char date_string[8];        /* mmm dd or ddd */
     char batt_string[4];        /* +99 */
 } Display;
 
 static Display display;
 
+static const int highlight_fields[] =
+{
+    [HL_NONE] = FIELD_COUNT,
+    [HL_SECONDS] = FIELD_SECS,
+    [HL_MINUTES] = FIELD_MINS,
+    [HL_HOURS] = FIELD_HOUR,
+    [HL_AMPM] = FIELD_AMPM,
+    [HL_DATE] = FIELD_DATE,
+};
+
+
+/* Add a rectangle to the area that needs to be redrawn. The whole layer
+* gets redrawn regardless, this is only so we can measure how much of it
+* really changed.
+*/
+static void mark_dirty(GRect r)
+{
+    GRect *d = &display.dirty;
+
+    if (d->size.w == 0 || d->size.h == 0)
+    {
+        *d = r;
+    }
+    else
+    {
+        int x2 = d->origin.x + d->size.w;
+        int y2 = d->origin.y + d->size.h;
+
+        if (r.origin.x + r.size.w > x2)
+        {
+            x2 = r.origin.x + r.size.w;
+        }
+        if (r.origin.y + r.size.h > y2)
+        {
+            y2 = r.origin.y + r.size.h;
+        }
+        if (r.origin.x < d->origin.x)
+        {
+            d->origin.x = r.origin.x;
+        }
+        if (r.origin.y < d->origin.y)
+        {
+            d->origin.y = r.origin.y;
+        }
+
+        d->size.w = x2 - d->origin.x;
+        d->size.h = y2 - d->origin.y;
+    }
+
+    PERF_INC(PERF_LAYER_DIRTY);
+    layer_mark_dirty(display.watch_layer);
+}
+
+
+/* Record that a field is to show a new value. Returns TRUE if it isn't
+* already showing it, in which case the caller formats the new text into
+* the field and calls field_drawn().
+*/
+static bool field_changed(FieldId id, int value)
+{
+    if (value != FIELD_UNKNOWN && display.field[id].value == value)
+    {
+        display.stats.skipped++;
+        return false;
+    }
+
+    display.field[id].value = value;
+    display.stats.drawn++;
+    return true;
+}
+
+
+static void field_drawn(FieldId id)
+{
+    TRACE_EVENT(TRACE_FIELD, id, display.field[id].value);
+    mark_dirty(display.field[id].frame);
+}
+
+
+/* Set a field that holds free-form text. Skipped if the text is the same
+* as what is there already.
+*/
+static void field_set_text(FieldId id, const char *text)
+{
+    Field *f = &display.field[id];
+
+    f->value = FIELD_UNKNOWN;
+    if (strncmp(f->text, text, sizeof(f->text) - 1) == 0)
+    {
+        display.stats.skipped++;
+        return;
+    }
+
+    strncpy(f->text, text, sizeof(f->text));
+    f->text[sizeof(f->text) - 1] = 0;
+    display.stats.drawn++;
+    field_drawn(id);
+}
+
+
+static const Glyph *glyph_find(const GlyphFont *font, char c)
+{
+    int i = (unsigned char)c - 32;
+
+    if (i < 0 || i >= 96 || font->index[i] < 0)
+    {
+        return NULL;
+    }
+
+    return &font->glyphs[(int)font->index[i]];
+}
+
+
+/* Blit a field's text from the glyph atlas. A highlighted field is drawn
+* black on white, which is what the old InverterLayer highlight did.
+*/
+static void draw_field(GContext *ctx, const Field *f, bool highlight)
+{
+    const GlyphFont *font = &glyph_fonts[f->font];
+    const Glyph *g;
+    const char *s;
+    int width = 0;
+    int x = f->frame.origin.x;
+    int y = f->frame.origin.y + font->top;
+
+    /* Sub-bitmap of the atlas. GBitmap is a plain struct, so a copy with
+    * different bounds picks out one glyph without allocating anything.
+    */
+    GBitmap glyph = *display.glyph_atlas;
+
+    for (s = f->text; *s; s++)
+    {
+        g = glyph_find(font, *s);
+        width += g ? g->w : font->space;
+    }
+
+    if (f->align == GTextAlignmentRight)
+    {
+        x += f->frame.size.w - width;
+    }
+    else if (f->align == GTextAlignmentCenter)
+    {
+        x += (f->frame.size.w - width) / 2;
+    }
+
+    if (highlight)
+    {
+        graphics_context_set_fill_color(ctx, GColorWhite);
+        graphics_fill_rect(ctx, f->frame, 0, GCornerNone);
+        graphics_context_set_compositing_mode(ctx, GCompOpClear);
+    }
+    else
+    {
+        graphics_context_set_compositing_mode(ctx, GCompOpOr);
+    }
+
+    for (s = f->text; *s; s++)
+    {
+        g = glyph_find(font, *s);
+        if (g)
+        {
+            glyph.bounds = GRect(g->x, g->y, g->w, font->height);
+            graphics_draw_bitmap_in_rect(ctx,
+                                         &glyph,
+                                         GRect(x, y, g->w, font->height));
+            x += g->w;
+        }
+        else
+        {
+            x += font->space;
+        }
+    }
+}
+
 
 static void status_update_callback(Layer *l, GContext *ctx)
 {
@@ -95,6 +284,20 @@ static void status_update_callback(Layer *l, GContext *ctx)
 static void watch_update_callback(Layer *l, GContext *ctx)
 {
     GRect bounds = layer_get_bounds(l);
+    int i;
+#if PERF || TRACE
+    TimeMS start;
+    TimeMS end;
+
+    time_ms(&start.sec, &start.ms);
+#endif
+
+    PERF_INC(PERF_FRAME);
+    /* The box around the fields that changed, an upper bound on the pixels
+    * that did. The host stand-in counts those exactly.
+    */
+    PERF_ADD(PERF_FRAME_AREA, display.dirty.size.w * display.dirty.size.h);
+    display.dirty = GRect(0, 0, 0, 0);
 
     graphics_context_set_stroke_color(ctx, GColorWhite);
 
@@ -111,13 +314,47 @@ static void watch_update_callback(Layer *l, GContext *ctx)
     bounds.size.h -= 2;
 
     graphics_draw_round_rect(ctx, bounds, 3);
+
+    /* Box around the date.
+    */
+    graphics_draw_round_rect(ctx, display.field[FIELD_DATE].frame, 3);
+
+    for (i = 0; i < FIELD_COUNT; i++)
+    {
+        draw_field(ctx,
+                   &display.field[i],
+                   i == highlight_fields[display.highlight]);
+    }
+
+    graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+
+#if PERF || TRACE
+    time_ms(&end.sec, &end.ms);
+    time_diff(&end, &end, &start);
+    PERF_ADD(PERF_DRAW_MS, end.sec * 1000 + end.ms);
+    PERF_MAX(PERF_DRAW_MAX_MS, end.sec * 1000 + end.ms);
+    PERF_FRAME_DONE();
+
+    /* Latencies in tools/trace.py end here, when the frame is drawn, not
+    * when a field was given its new value.
+    */
+    TRACE_EVENT(TRACE_FRAME, 0, end.sec * 1000 + end.ms);
+#endif
 }
 
 
-static void box_update_callback(Layer *l, GContext *ctx)
+static void field_init(FieldId id,
+                       GRect frame,
+                       GlyphFontId font,
+                       GTextAlignment align)
 {
-    graphics_context_set_stroke_color(ctx, GColorWhite);
-    graphics_draw_round_rect(ctx, layer_get_bounds(l), 3);
+    Field *f = &display.field[id];
+
+    f->frame = frame;
+    f->font = font;
+    f->align = align;
+    f->value = FIELD_UNKNOWN;
+    f->text[0] = 0;
 }
 
 
@@ -144,180 +381,39 @@ static bool create_main_layers(Window *window, GRect bounds)
                              ampm_frame.size.h);
 
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    LOG_MSG_DEBUG("hour_frame={%d,%d,%d,%d}",
-                  hour_frame.origin.x,
-                  hour_frame.origin.y,
-                  hour_frame.size.w,
-                  hour_frame.size.h);
-    LOG_MSG_DEBUG("hm_frame={%d,%d,%d,%d}",
-                  hm_frame.origin.x,
-                  hm_frame.origin.y,
-                  hm_frame.size.w,
-                  hm_frame.size.h);
-    LOG_MSG_DEBUG("mins_frame={%d,%d,%d,%d}",
-                  mins_frame.origin.x,
-                  mins_frame.origin.y,
-                  mins_frame.size.w,
-                  mins_frame.size.h);
-    LOG_MSG_DEBUG("secs_frame={%d,%d,%d,%d}",
-                  secs_frame.origin.x,
-                  secs_frame.origin.y,
-                  secs_frame.size.w,
-                  secs_frame.size.h);
-    LOG_MSG_DEBUG("ampm_frame={%d,%d,%d,%d}",
-                  ampm_frame.origin.x,
-                  ampm_frame.origin.y,
-                  ampm_frame.size.w,
-                  ampm_frame.size.h);
-    LOG_MSG_DEBUG("date_frame={%d,%d,%d,%d}",
-                  date_frame.origin.x,
-                  date_frame.origin.y,
-                  date_frame.size.w,
-                  date_frame.size.h);
 
     window_set_background_color(window, GColorBlack);
 
-    /* This creates a manager window for our children so we don't
-    * have to worry about the origin of the main window when placing
-    * them.
-    */
-    display.watch_layer = layer_create(bounds);
-    if (display.watch_layer == NULL)
+    display.glyph_atlas = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_GLYPH_ATLAS);
+    if (display.glyph_atlas == NULL)
     {
-        LOG_MSG_ERROR("Can't create display.watch_layer");
+        LOG_MSG_ERROR("Can't load glyph atlas");
         goto error_0;
     }
-    layer_set_update_proc(display.watch_layer, watch_update_callback);
 
-    display.hour_layer = text_layer_create(hour_frame);
-    if (display.hour_layer == NULL)
+    display.watch_layer = layer_create(bounds);
+    if (display.watch_layer == NULL)
     {
-        LOG_MSG_ERROR("Can't create display.hour_layer");
+        LOG_MSG_ERROR("Can't create display.watch_layer");
         goto error_1;
     }
+    layer_set_update_proc(display.watch_layer, watch_update_callback);
 
-    display.hm_layer = text_layer_create(hm_frame);
-    if (display.hm_layer == NULL)
-    {
-        LOG_MSG_ERROR("Can't create display.hm_layer");
-        goto error_2;
-    }
-
-    display.mins_layer = text_layer_create(mins_frame);
-    if (display.mins_layer == NULL)
-    {
-        LOG_MSG_ERROR("Can't create display.minslayer");
-        goto error_3;
-    }
-
-    display.secs_layer = text_layer_create(secs_frame);
-    if (display.secs_layer == NULL)
-    {
-        LOG_MSG_ERROR("Can't create display.secs_layer");
-        goto error_4;
-    }
-
-    display.ampm_layer = text_layer_create(ampm_frame);
-    if (display.ampm_layer == NULL)
-    {
-        LOG_MSG_ERROR("Can't create display.ampm_layer");
-        goto error_5;
-    }
-
-    display.date_layer = text_layer_create(date_frame);
-    if (display.date_layer == NULL)
-    {
-        LOG_MSG_ERROR("Can't create display.date_layer");
-        goto error_6;
-    }
-
-    display.box_layer = layer_create(date_frame);
-    if (display.box_layer == NULL)
-    {
-        LOG_MSG_ERROR("Can't create display.box_layer");
-        goto error_7;
-    }
-    layer_set_update_proc(display.box_layer, box_update_callback);
-
-    display.hl_layer = inverter_layer_create(date_frame);
-    if (display.hl_layer == NULL)
-    {
-        LOG_MSG_ERROR("Can't create display.hl_layer");
-        goto error_8;
-    }
-
-    text_layer_set_font(display.date_layer, res_font_medium);
-    text_layer_set_font(display.ampm_layer, res_font_medium);
-    text_layer_set_font(display.secs_layer, res_font_medium);
-    text_layer_set_font(display.mins_layer, res_font_large);
-    text_layer_set_font(display.hm_layer, res_font_large);
-    text_layer_set_font(display.hour_layer, res_font_large);
-
-    text_layer_set_text_color(display.date_layer, GColorWhite);
-    text_layer_set_text_color(display.ampm_layer, GColorWhite);
-    text_layer_set_text_color(display.secs_layer, GColorWhite);
-    text_layer_set_text_color(display.mins_layer, GColorWhite);
-    text_layer_set_text_color(display.hm_layer, GColorWhite);
-    text_layer_set_text_color(display.hour_layer, GColorWhite);
-
-    text_layer_set_background_color(display.date_layer, GColorClear);
-    text_layer_set_background_color(display.ampm_layer, GColorClear);
-    text_layer_set_background_color(display.secs_layer, GColorClear);
-    text_layer_set_background_color(display.mins_layer, GColorClear);
-    text_layer_set_background_color(display.hm_layer, GColorClear);
-    text_layer_set_background_color(display.hour_layer, GColorClear);
-
-    text_layer_set_text_alignment(display.date_layer, GTextAlignmentCenter);
-    text_layer_set_text_alignment(display.ampm_layer, GTextAlignmentLeft);
-    text_layer_set_text_alignment(display.secs_layer, GTextAlignmentLeft);
-    text_layer_set_text_alignment(display.mins_layer, GTextAlignmentLeft);
-    text_layer_set_text_alignment(display.hm_layer, GTextAlignmentCenter);
-    text_layer_set_text_alignment(display.hour_layer, GTextAlignmentRight);
+    field_init(FIELD_HOUR, hour_frame, GLYPH_FONT_LARGE, GTextAlignmentRight);
+    field_init(FIELD_HM, hm_frame, GLYPH_FONT_LARGE, GTextAlignmentCenter);
+    field_init(FIELD_MINS, mins_frame, GLYPH_FONT_LARGE, GTextAlignmentLeft);
+    field_init(FIELD_SECS, secs_frame, GLYPH_FONT_MEDIUM, GTextAlignmentLeft);
+    field_init(FIELD_AMPM, ampm_frame, GLYPH_FONT_MEDIUM, GTextAlignmentLeft);
+    field_init(FIELD_DATE, date_frame, GLYPH_FONT_MEDIUM, GTextAlignmentCenter);
+    field_set_text(FIELD_HM, ":");
 
-    layer_add_child(window_get_root_layer(window),
-                    display.watch_layer);
-    layer_add_child(display.watch_layer,
-                    text_layer_get_layer(display.date_layer));
-    layer_add_child(display.watch_layer,
-                    text_layer_get_layer(display.ampm_layer));
-    layer_add_child(display.watch_layer,
-                    text_layer_get_layer(display.secs_layer));
-    layer_add_child(display.watch_layer,
-                    text_layer_get_layer(display.mins_layer));
-    layer_add_child(display.watch_layer,
-                    text_layer_get_layer(display.hm_layer));
-    layer_add_child(display.watch_layer,
-                    text_layer_get_layer(display.hour_layer));
-
-    layer_add_child(display.watch_layer, display.box_layer);
-    text_layer_set_text(display.hm_layer, ":");
+    layer_add_child(window_get_root_layer(window), display.watch_layer);
 
     err = false;
     goto error_0;
 
-error_8:
-    layer_destroy(display.box_layer);
-
-error_7:
-    text_layer_destroy(display.date_layer);
-
-error_6:
-    text_layer_destroy(display.ampm_layer);
-
-error_5:
-    text_layer_destroy(display.secs_layer);
-
-error_4:
-    text_layer_destroy(display.hour_layer);
-
-error_3:
-    text_layer_destroy(display.hm_layer);
-
-error_2:
-    text_layer_destroy(display.mins_layer);
-
 error_1:
-    layer_destroy(display.watch_layer);
+    gbitmap_destroy(display.glyph_atlas);
 
 error_0:
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
@@ -327,15 +423,8 @@ error_0:
 
 static void destroy_main_layers(void)
 {
-    inverter_layer_destroy(display.hl_layer);
-    text_layer_destroy(display.date_layer);
-    text_layer_destroy(display.ampm_layer);
-    text_layer_destroy(display.secs_layer);
-    text_layer_destroy(display.hour_layer);
-    text_layer_destroy(display.hm_layer);
-    text_layer_destroy(display.mins_layer);
-    layer_destroy(display.box_layer);
     layer_destroy(display.watch_layer);
+    gbitmap_destroy(display.glyph_atlas);
 }
 
 
@@ -497,11 +586,7 @@ void display_destroy(void)
 *****************************************************************************/
 void display_set_title(const char *title)
 {
-    snprintf(display.date_string,
-             sizeof(display.date_string),
-             "%s",
-             title);
-    text_layer_set_text(display.date_layer, display.date_string);
+    field_set_text(FIELD_DATE, title);
 }
 
 
@@ -510,14 +595,10 @@ void display_set_title(const char *title)
 *****************************************************************************/
 void display_clear(void)
 {
-    text_layer_set_text(display.date_layer, " ");
-    text_layer_set_text(display.ampm_layer, " ");
-    text_layer_set_text(display.secs_layer, " ");
-    text_layer_set_text(display.hm_layer, ":");
-    layer_remove_from_parent(inverter_layer_get_layer(display.hl_layer));
-
-    display.last_interval.sec = 99 * 3600; /* max hours */
-    display.last_interval.ms = 999;
+    field_set_text(FIELD_DATE, " ");
+    field_set_text(FIELD_AMPM, " ");
+    field_set_text(FIELD_SECS, " ");
+    display_set_highlight(HL_NONE);
 }
 
 
@@ -528,55 +609,66 @@ void display_set_time(struct tm *time_now,
                       TimeUnits units_to_update,
                       int force_style)
 {
+    Field *f = display.field;
+
     if (units_to_update & DAY_UNIT)
     {
-        strftime(display.date_string,
-                 sizeof(display.date_string),
-                 "%b %d",
-                 time_now);
-
-        text_layer_set_text(display.date_layer, upcase(display.date_string));
+        if (field_changed(FIELD_DATE,
+                          time_now->tm_mon * 32 + time_now->tm_mday))
+        {
+            fmt_date(f[FIELD_DATE].text, time_now);
+            field_drawn(FIELD_DATE);
+        }
     }
 
     if (units_to_update & (MINUTE_UNIT | HOUR_UNIT))
     {
         if (force_style >= 1 || (force_style == 0 && clock_is_24h_style()))
         {
-            strcpy(display.ampm_string, "  ");
-            strftime(display.hour_string,
-                     sizeof(display.hour_string),
-                     "%H",
-                     time_now);
-            strftime(display.mins_string,
-                     sizeof(display.mins_string),
-                     "%M",
-                     time_now);
+            if (field_changed(FIELD_AMPM, 0))
+            {
+                strcpy(f[FIELD_AMPM].text, "  ");
+                field_drawn(FIELD_AMPM);
+            }
+
+            if (field_changed(FIELD_HOUR, time_now->tm_hour))
+            {
+                fmt_2d(f[FIELD_HOUR].text, time_now->tm_hour);
+                field_drawn(FIELD_HOUR);
+            }
         }
         else
         {
-            strcpy(display.ampm_string, time_now->tm_hour < 12 ? "AM" : "PM");
-            strftime(display.hour_string,
-                     sizeof(display.hour_string),
-                     "%l",
-                     time_now);
-            strftime(display.mins_string,
-                     sizeof(display.mins_string),
-                     "%M",
-                     time_now);
+            int hour = time_now->tm_hour % 12;
+
+            if (field_changed(FIELD_AMPM, time_now->tm_hour < 12 ? 1 : 2))
+            {
+                strcpy(f[FIELD_AMPM].text,
+                       time_now->tm_hour < 12 ? "AM" : "PM");
+                field_drawn(FIELD_AMPM);
+            }
+
+            if (field_changed(FIELD_HOUR, FIELD_12H + hour))
+            {
+                fmt_2d_space(f[FIELD_HOUR].text, hour ? hour : 12);
+                field_drawn(FIELD_HOUR);
+            }
         }
 
-        text_layer_set_text(display.ampm_layer, display.ampm_string);
-        text_layer_set_text(display.hour_layer, display.hour_string);
-        text_layer_set_text(display.mins_layer, display.mins_string);
+        if (field_changed(FIELD_MINS, time_now->tm_min))
+        {
+            fmt_2d(f[FIELD_MINS].text, time_now->tm_min);
+            field_drawn(FIELD_MINS);
+        }
     }
 
     if (units_to_update & SECOND_UNIT)
     {
-        strftime(display.secs_string,
-                 sizeof(display.secs_string),
-                 "%S",
-                 time_now);
-        text_layer_set_text(display.secs_layer, display.secs_string);
+        if (field_changed(FIELD_SECS, time_now->tm_sec))
+        {
+            fmt_2d(f[FIELD_SECS].text, time_now->tm_sec);
+            field_drawn(FIELD_SECS);
+        }
     }
 }
 
@@ -587,67 +679,88 @@ void display_set_time(struct tm *time_now,
 *****************************************************************************/
 void display_set_interval(time_t sec, uint16_t ms)
 {
-    if (display.last_interval.ms != ms)
+    Field *f = display.field;
+    int hundredths = (ms + 5) / 10;
+    int hours;
+    int minutes;
+    int seconds;
+
+    while (hundredths >= 100)
+    {
+        sec++;
+        hundredths -= 100;
+    }
+
+    if (field_changed(FIELD_SECS, hundredths))
     {
-        int hundredths = (ms + 5) / 10;
+        fmt_2d(f[FIELD_SECS].text, hundredths);
+        field_drawn(FIELD_SECS);
+    }
 
-        while (hundredths >= 100)
-        {
-            sec++;
-            hundredths -= 100;
-        }
+    seconds = sec;
+    hours = seconds / 3600;
+    if (hours > 99)
+    {
+        hours = 99;
+        minutes = 59;
+        seconds = 59;
+    }
+    else
+    {
+        seconds -= hours * 3600;
+        minutes  = seconds / 60;
+        seconds -= minutes * 60;
+    }
 
-        snprintf(display.secs_string, sizeof(display.secs_string),
-                 "%02d",
-                 hundredths);
-        text_layer_set_text(display.secs_layer, display.secs_string);
+    if (field_changed(FIELD_AMPM, FIELD_HOURS + hours))
+    {
+        strcpy(fmt_int(f[FIELD_AMPM].text, hours), "H");
+        field_drawn(FIELD_AMPM);
     }
 
-    if (display.last_interval.sec != sec)
+    if (field_changed(FIELD_HOUR, minutes))
     {
-        int hours;
-        int minutes;
-        int seconds = sec;
+        fmt_2d(f[FIELD_HOUR].text, minutes);
+        field_drawn(FIELD_HOUR);
+    }
 
-        hours = seconds / 3600;
-        if (hours > 99)
-        {
-            hours = 99;
-            minutes = 59;
-            seconds = 59;
-        }
-        else
-        {
-            seconds -= hours * 3600;
-            minutes  = seconds / 60;
-            seconds -= minutes * 60;
-        }
+    if (field_changed(FIELD_MINS, seconds))
+    {
+        fmt_2d(f[FIELD_MINS].text, seconds);
+        field_drawn(FIELD_MINS);
+    }
+}
 
-        if (hours != display.last_interval.sec / 3600)
-        {
-            snprintf(display.ampm_string,
-                     sizeof(display.ampm_string),
-                     "%dH",
-                     hours);
-            text_layer_set_text(display.ampm_layer, display.ampm_string);
-        }
 
-        snprintf(display.hour_string,
-                 sizeof(display.hour_string),
-                 "%02d",
-                 minutes);
+/**
+* Show a number of up to six digits in the time fields, two per field.
+*****************************************************************************/
+void display_set_number(uint32_t n)
+{
+    static const FieldId digits[] = { FIELD_HOUR, FIELD_MINS, FIELD_SECS };
+    Field *f = display.field;
+    int i;
 
-        snprintf(display.mins_string,
-                 sizeof(display.mins_string),
-                 "%02d",
-                 seconds);
+    if (n > 999999)
+    {
+        n = 999999;
+    }
 
-        text_layer_set_text(display.hour_layer, display.hour_string);
-        text_layer_set_text(display.mins_layer, display.mins_string);
+    if (field_changed(FIELD_AMPM, 0))
+    {
+        strcpy(f[FIELD_AMPM].text, "  ");
+        field_drawn(FIELD_AMPM);
     }
 
-    display.last_interval.sec = sec;
-    display.last_interval.ms = ms;
+    for (i = 2; i >= 0; i--)
+    {
+        if (field_changed(digits[i], n % 100))
+        {
+            fmt_2d(f[digits[i]].text, n % 100);
+            field_drawn(digits[i]);
+        }
+        n /= 100;
+    }
 }
 
 
@@ -657,49 +770,27 @@ void display_set_interval(time_t sec, uint16_t ms)
 *****************************************************************************/
 void display_set_highlight(HighlightFields what_to_highlight)
 {
-    GRect f;
-    Layer *l = NULL;
-    Layer *hl_layer = inverter_layer_get_layer(display.hl_layer);
-
-    layer_remove_from_parent(hl_layer);
-
-    switch (what_to_highlight)
+    if (what_to_highlight > HL_DATE)
     {
-    case HL_NONE:
-        break;
-
-    case HL_SECONDS:
-        l = text_layer_get_layer(display.secs_layer);
-        break;
-
-    case HL_MINUTES:
-        l = text_layer_get_layer(display.mins_layer);
-        break;
-
-    case HL_HOURS:
-        l = text_layer_get_layer(display.hour_layer);
-        break;
-
-    case HL_AMPM:
-        l = text_layer_get_layer(display.ampm_layer);
-        break;
-
-    case HL_DATE:
-        l = text_layer_get_layer(display.date_layer);
-        break;
-
-    default:
         LOG_MSG_WARNING("Unknown highlight value %d", what_to_highlight);
-        break;
+        what_to_highlight = HL_NONE;
     }
 
-    if (l)
+    if (display.highlight != what_to_highlight)
     {
-        f = layer_get_frame(l);
-        f.origin.x = 0;
-        f.origin.y = 0;
-        layer_set_frame(hl_layer, f);
-        layer_add_child(l, hl_layer);
+        int old_field = highlight_fields[display.highlight];
+        int new_field = highlight_fields[what_to_highlight];
+
+        if (old_field != FIELD_COUNT)
+        {
+            mark_dirty(display.field[old_field].frame);
+        }
+        if (new_field != FIELD_COUNT)
+        {
+            mark_dirty(display.field[new_field].frame);
+        }
+
+        display.highlight = what_to_highlight;
     }
 }
 
@@ -742,13 +833,13 @@ void display_set_battery(unsigned int percent, bool charge)
     }
     else
     {
-        snprintf(display.batt_string,
-                 sizeof(display.batt_string),
-                 "%0d%c",
-                 percent,
-                 charge ? '+' : ' ');
+        char *s = fmt_int(display.batt_string, percent);
+
+        s[0] = charge ? '+' : ' ';
+        s[1] = 0;
     }
 
+    PERF_INC(PERF_LAYER_DIRTY);
     text_layer_set_text(display.batt_layer, display.batt_string);
 }
 
@@ -758,6 +849,7 @@ void display_set_battery(unsigned int percent, bool charge)
 *****************************************************************************/
 void display_set_bluetooth(bool connected)
 {
+    PERF_INC(PERF_LAYER_DIRTY);
     layer_set_hidden(display.bt_layer, connected);
 }
 
@@ -767,6 +859,7 @@ void display_set_bluetooth(bool connected)
 *****************************************************************************/
 void display_set_invert(bool invert)
 {
+    PERF_INC(PERF_LAYER_DIRTY);
     layer_set_hidden(inverter_layer_get_layer(display.invert_layer), !invert);
 }
 
@@ -779,3 +872,12 @@ bool display_get_invert(void)
     return !layer_get_hidden(inverter_layer_get_layer(display.invert_layer));
 }
 
+
+/**
+* Get the counts of field updates drawn and skipped.
+*****************************************************************************/
+void display_get_stats(DisplayStats *stats)
+{
+    *stats = display.stats;
+}
+
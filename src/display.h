@@ -46,6 +46,13 @@ typedef enum
 }
 HighlightFields;
 
+typedef struct _DisplayStats
+{
+    uint32_t drawn;     /* field updates that changed what is shown */
+    uint32_t skipped;   /* field updates skipped, the value was unchanged */
+}
+DisplayStats;
+
 
 /**
 * Create the display. Allocate memory and set up the data structures. Do
@@ -102,6 +109,15 @@ void display_set_time(struct tm *time_now,
 void display_set_interval(time_t sec, uint16_t ms);
 
 
+/**
+* Show a number in the time fields. Used for things that aren't times,
+* like the counters on the performance face.
+*
+* @param n      The number, clamped to 0-999999.
+*****************************************************************************/
+void display_set_number(uint32_t n);
+
+
 /**
 * Highlight particular fields of the time display. Can be used to set
 * countdown intervals interactively.
@@ -168,4 +184,13 @@ void display_set_invert(bool invert);
 bool display_get_invert(void);
 
 
+/**
+* Get the counts of field updates drawn and skipped since the display was
+* created. Every field a caller asks to update counts as one or the other.
+*
+* @param stats  Pointer to where to put the counts.
+*****************************************************************************/
+void display_get_stats(DisplayStats *stats);
+
+
 #endif  /* include guard */
@@ -61,6 +61,14 @@ struct Face
     */
     void (*shut_up)(Face *);
 
+    /* Tick subscription. The update_handler() is only called for the units
+    * in tick_units, and only while the face is active unless tick_hidden is
+    * set. A face may change these at any time, the app picks up the change
+    * after the next button, tick, or face switch.
+    */
+    TimeUnits tick_units;
+    bool tick_hidden;
+
     /* Required face data.
     */
     GRect bounds;
@@ -73,4 +81,13 @@ struct Face
 };
 
 
+/* Storage for a face and its Private data. There is only ever one of each
+* face, so each module keeps its own in static memory instead of the heap.
+*/
+#define FACE_STORAGE(name, private)                                         \
+    static unsigned long name[(sizeof(Face) + sizeof(private)               \
+                               + sizeof(unsigned long) - 1)                  \
+                              / sizeof(unsigned long)]
+
+
 #endif  /* include guard */
\ No newline at end of file
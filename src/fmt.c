@@ -0,0 +1,207 @@
+/****************************************************************************/
+/**
+* Small formatting routines for the display fields. These cover the few
+* formats the app needs (two-digit fields, "JAN 05" dates, day names) with
+* table lookups, so the hot paths don't need strftime(), snprintf(), or
+* gmtime() and the upcase() pass after them.
+*
+* @file   fmt.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "fmt.h"
+
+
+static const char digit_pairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char month_names[12][4] =
+{
+    "JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+    "JUL", "AUG", "SEP", "OCT", "NOV", "DEC",
+};
+
+static const char day_names[7][4] =
+{
+    "SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT",
+};
+
+
+static int clamp_99(int n)
+{
+    if (n < 0)
+    {
+        return 0;
+    }
+
+    return n > 99 ? 99 : n;
+}
+
+
+static char *copy_name(char *buf, const char *name)
+{
+    buf[0] = name[0];
+    buf[1] = name[1];
+    buf[2] = name[2];
+    buf[3] = 0;
+
+    return buf + 3;
+}
+
+
+/**
+* Format 0-99 as two digits with a leading zero, like "%02d".
+*****************************************************************************/
+char *fmt_2d(char *buf, int n)
+{
+    const char *pair = &digit_pairs[clamp_99(n) * 2];
+
+    buf[0] = pair[0];
+    buf[1] = pair[1];
+    buf[2] = 0;
+
+    return buf + 2;
+}
+
+
+/**
+* Format 0-99 as two characters with a leading space, like "%2d".
+*****************************************************************************/
+char *fmt_2d_space(char *buf, int n)
+{
+    char *end = fmt_2d(buf, n);
+
+    if (buf[0] == '0')
+    {
+        buf[0] = ' ';
+    }
+
+    return end;
+}
+
+
+/**
+* Format 0-99 with no padding, like "%d".
+*****************************************************************************/
+char *fmt_int(char *buf, int n)
+{
+    n = clamp_99(n);
+
+    if (n < 10)
+    {
+        buf[0] = '0' + n;
+        buf[1] = 0;
+        return buf + 1;
+    }
+
+    return fmt_2d(buf, n);
+}
+
+
+/**
+* Format any unsigned number with no padding, like "%lu".
+*****************************************************************************/
+char *fmt_uint(char *buf, uint32_t n)
+{
+    char digits[10];
+    char *d = digits + sizeof(digits);
+
+    while (n >= 100)
+    {
+        d -= 2;
+        d[0] = digit_pairs[(n % 100) * 2];
+        d[1] = digit_pairs[(n % 100) * 2 + 1];
+        n /= 100;
+    }
+    if (n >= 10)
+    {
+        d -= 2;
+        d[0] = digit_pairs[n * 2];
+        d[1] = digit_pairs[n * 2 + 1];
+    }
+    else
+    {
+        *--d = '0' + n;
+    }
+
+    while (d < digits + sizeof(digits))
+    {
+        *buf++ = *d++;
+    }
+    *buf = 0;
+
+    return buf;
+}
+
+
+/**
+* Format a date as an upper case month and two-digit day, like "JAN 05".
+*****************************************************************************/
+char *fmt_date(char *buf, const struct tm *tm)
+{
+    char *s = copy_name(buf, month_names[tm->tm_mon % 12]);
+
+    *s++ = ' ';
+    return fmt_2d(s, tm->tm_mday);
+}
+
+
+/**
+* Format the upper case short day name, like "MON".
+*****************************************************************************/
+char *fmt_day(char *buf, const struct tm *tm)
+{
+    return copy_name(buf, day_names[tm->tm_wday % 7]);
+}
+
+
+/**
+* Split a count of seconds into hours, minutes, and seconds.
+*****************************************************************************/
+void fmt_split(time_t sec, struct tm *tm)
+{
+    int32_t s = sec;
+
+    memset(tm, 0, sizeof(*tm));
+
+    tm->tm_hour = s / 3600;
+    s -= tm->tm_hour * 3600;
+    tm->tm_min = s / 60;
+    tm->tm_sec = s - tm->tm_min * 60;
+
+    /* Day zero of the epoch, a Thursday.
+    */
+    tm->tm_mday = 1;
+    tm->tm_year = 70;
+    tm->tm_wday = 4;
+}
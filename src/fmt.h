@@ -0,0 +1,121 @@
+/****************************************************************************/
+/**
+* Small formatting routines for the display fields. These cover the few
+* formats the app needs (two-digit fields, "JAN 05" dates, day names) with
+* table lookups, so the hot paths don't need strftime(), snprintf(), or
+* gmtime() and the upcase() pass after them.
+*
+* Every routine writes a NUL-terminated string and returns a pointer to the
+* NUL, so results can be appended to.
+*
+* @file   fmt.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef FMT_H
+#define FMT_H
+
+
+#include <pebble.h>
+
+
+/**
+* Format 0-99 as two digits with a leading zero, like "%02d".
+*
+* @param buf    Where to put the string, at least 3 bytes.
+* @param n      The number, clamped to 0-99.
+*
+* @return  Pointer to the terminating NUL.
+*****************************************************************************/
+char *fmt_2d(char *buf, int n);
+
+
+/**
+* Format 0-99 as two characters with a leading space, like "%2d".
+*
+* @param buf    Where to put the string, at least 3 bytes.
+* @param n      The number, clamped to 0-99.
+*
+* @return  Pointer to the terminating NUL.
+*****************************************************************************/
+char *fmt_2d_space(char *buf, int n);
+
+
+/**
+* Format 0-99 with no padding, like "%d".
+*
+* @param buf    Where to put the string, at least 3 bytes.
+* @param n      The number, clamped to 0-99.
+*
+* @return  Pointer to the terminating NUL.
+*****************************************************************************/
+char *fmt_int(char *buf, int n);
+
+
+/**
+* Format any unsigned number with no padding, like "%lu". For logs, not
+* the display.
+*
+* @param buf    Where to put the string, at least 11 bytes.
+* @param n      The number.
+*
+* @return  Pointer to the terminating NUL.
+*****************************************************************************/
+char *fmt_uint(char *buf, uint32_t n);
+
+
+/**
+* Format a date as an upper case month and two-digit day, like "JAN 05".
+*
+* @param buf    Where to put the string, at least 7 bytes.
+* @param tm     The date.
+*
+* @return  Pointer to the terminating NUL.
+*****************************************************************************/
+char *fmt_date(char *buf, const struct tm *tm);
+
+
+/**
+* Format the upper case short day name, like "MON".
+*
+* @param buf    Where to put the string, at least 4 bytes.
+* @param tm     The date.
+*
+* @return  Pointer to the terminating NUL.
+*****************************************************************************/
+char *fmt_day(char *buf, const struct tm *tm);
+
+
+/**
+* Split a count of seconds into hours, minutes, and seconds. The rest of the
+* struct is filled in the way gmtime() would for an interval under a day,
+* so the result can be passed to anything that takes a time of day.
+*
+* @param sec    Number of seconds, must be >= 0.
+* @param tm     Where to put the result. tm_hour may be over 23.
+*****************************************************************************/
+void fmt_split(time_t sec, struct tm *tm);
+
+
+#endif  /* include guard */
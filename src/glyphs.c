@@ -0,0 +1,91 @@
+/* Generated by tools/mkglyphs.py, do not edit. */
+#include "glyphs.h"
+
+
+static const Glyph glyphs_large[] =
+{
+    {  0,   0, 24},  /* '0' */
+    { 24,   0, 24},  /* '1' */
+    { 48,   0, 24},  /* '2' */
+    { 72,   0, 24},  /* '3' */
+    { 96,   0, 24},  /* '4' */
+    {120,   0, 24},  /* '5' */
+    {  0,  31, 24},  /* '6' */
+    { 24,  31, 24},  /* '7' */
+    { 48,  31, 24},  /* '8' */
+    { 72,  31, 24},  /* '9' */
+    { 96,  31, 12},  /* ':' */
+};
+
+static const int8_t index_large[96] =
+{
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static const Glyph glyphs_medium[] =
+{
+    {  0,  62, 11},  /* '0' */
+    { 11,  62, 11},  /* '1' */
+    { 22,  62, 11},  /* '2' */
+    { 33,  62, 11},  /* '3' */
+    { 44,  62, 11},  /* '4' */
+    { 55,  62, 11},  /* '5' */
+    { 66,  62, 11},  /* '6' */
+    { 77,  62, 11},  /* '7' */
+    { 88,  62, 11},  /* '8' */
+    { 99,  62, 11},  /* '9' */
+    {110,  62,  5},  /* ':' */
+    {115,  62,  5},  /* '.' */
+    {120,  62, 11},  /* '+' */
+    {131,  62,  8},  /* '-' */
+    {139,  62,  8},  /* '/' */
+    {  0,  81, 15},  /* '%' */
+    { 15,  81, 12},  /* 'A' */
+    { 27,  81, 12},  /* 'B' */
+    { 39,  81, 12},  /* 'C' */
+    { 51,  81, 13},  /* 'D' */
+    { 64,  81, 11},  /* 'E' */
+    { 75,  81, 11},  /* 'F' */
+    { 86,  81, 13},  /* 'G' */
+    { 99,  81, 13},  /* 'H' */
+    {112,  81,  6},  /* 'I' */
+    {118,  81, 11},  /* 'J' */
+    {129,  81, 12},  /* 'K' */
+    {141,  81, 11},  /* 'L' */
+    {  0, 100, 16},  /* 'M' */
+    { 16, 100, 13},  /* 'N' */
+    { 29, 100, 13},  /* 'O' */
+    { 42, 100, 12},  /* 'P' */
+    { 54, 100, 13},  /* 'Q' */
+    { 67, 100, 12},  /* 'R' */
+    { 79, 100, 12},  /* 'S' */
+    { 91, 100, 11},  /* 'T' */
+    {102, 100, 13},  /* 'U' */
+    {115, 100, 12},  /* 'V' */
+    {127, 100, 17},  /* 'W' */
+    {144, 100, 12},  /* 'X' */
+    {  0, 119, 12},  /* 'Y' */
+    { 12, 119, 11},  /* 'Z' */
+};
+
+static const int8_t index_medium[96] =
+{
+    -1, -1, -1, -1, -1, 15, -1, -1, -1, -1, -1, 12, -1, 13, 11, 14,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, -1, -1, -1, -1, -1,
+    -1, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30,
+    31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+
+const GlyphFont glyph_fonts[GLYPH_FONT_COUNT] =
+{
+    {glyphs_large, index_large, 8, 31, 10},
+    {glyphs_medium, index_medium, 4, 19, 5},
+};
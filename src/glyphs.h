@@ -0,0 +1,70 @@
+/****************************************************************************/
+/**
+* Pre-rasterized glyphs for the display. All glyphs live in one 1-bit atlas
+* image resource (IMAGE_GLYPH_ATLAS). The tables in glyphs.c say where each
+* one is, both are generated by tools/mkglyphs.py.
+*
+* @file   glyphs.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef GLYPHS_H
+#define GLYPHS_H
+
+
+#include <pebble.h>
+
+
+typedef enum
+{
+    GLYPH_FONT_LARGE,           /* Roboto Bold 42, digits and ':' */
+    GLYPH_FONT_MEDIUM,          /* Roboto Condensed 22, digits and caps */
+    GLYPH_FONT_COUNT,
+}
+GlyphFontId;
+
+typedef struct _Glyph
+{
+    uint8_t x;                  /* position in the atlas */
+    uint8_t y;
+    uint8_t w;                  /* width, also the advance */
+}
+Glyph;
+
+typedef struct _GlyphFont
+{
+    const Glyph *glyphs;
+    const int8_t *index;        /* ASCII 32-127 to glyphs[], -1 if none */
+    uint8_t top;                /* offset of the glyph cells below the text
+                                * origin */
+    uint8_t height;             /* height of every glyph cell */
+    uint8_t space;              /* advance for characters not in the atlas */
+}
+GlyphFont;
+
+
+extern const GlyphFont glyph_fonts[GLYPH_FONT_COUNT];
+
+
+#endif  /* include guard */
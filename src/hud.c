@@ -0,0 +1,247 @@
+/****************************************************************************/
+/**
+* A face that shows what the app is costing while it runs, for finding out
+* why a particular watch drains fast. Left out of the build unless HUD is
+* turned on in hud.h.
+*
+* Titles, one page each:
+*       HEAP U  Heap bytes used.
+*       HEAP F  Heap bytes free.
+*       TICK/M  Tick service wakeups per minute.
+*       TMR/M   AppTimer wakeups per minute.
+*       TICK95  95th percentile tick lateness in milliseconds.
+*       TMR95   95th percentile AppTimer lateness in milliseconds.
+*       AVG US  Average watch layer redraw time in microseconds.
+*       MAX MS  Longest watch layer redraw in milliseconds.
+*       WRITES  Persistent storage writes this session.
+* Buttons:
+*       UP      Next page.
+*       SEL     Default action
+*       DN      Default action
+*
+* @file   hud.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "display.h"
+#include "hud.h"
+#include "record.h"
+#include "utils.h"
+
+#if HUD
+
+
+#define HUD_VERSION     (1)     /* persisted record layout */
+
+
+typedef enum
+{
+    PAGE_HEAP_USED,
+    PAGE_HEAP_FREE,
+    PAGE_TICKS,
+    PAGE_TIMERS,
+    PAGE_TICK_LATE,
+    PAGE_TIMER_LATE,
+    PAGE_DRAW_AVG,
+    PAGE_DRAW_MAX,
+    PAGE_WRITES,
+    PAGE_COUNT,
+}
+Page;
+
+typedef struct _Private
+{
+    int page;
+    bool visible;
+}
+Private;
+
+FACE_STORAGE(storage, Private);
+
+
+static const char *page_titles[PAGE_COUNT] =
+{
+    [PAGE_HEAP_USED] = "HEAP U",
+    [PAGE_HEAP_FREE] = "HEAP F",
+    [PAGE_TICKS] = "TICK/M",
+    [PAGE_TIMERS] = "TMR/M",
+    [PAGE_TICK_LATE] = "TICK95",
+    [PAGE_TIMER_LATE] = "TMR95",
+    [PAGE_DRAW_AVG] = "AVG.1MS",    /* tenths of a ms */
+    [PAGE_DRAW_MAX] = "MAX MS",
+    [PAGE_WRITES] = "WRITES",
+};
+
+
+static uint32_t per_minute(PerfCounter counter)
+{
+    uint32_t secs = perf_elapsed();
+
+    return secs ? (uint64_t)perf_get(counter) * 60 / secs : 0;
+}
+
+
+static void show_page(Private *pvt)
+{
+    uint32_t value = 0;
+    uint32_t frames;
+
+    switch (pvt->page)
+    {
+    case PAGE_HEAP_USED:
+        value = heap_bytes_used();
+        break;
+
+    case PAGE_HEAP_FREE:
+        value = heap_bytes_free();
+        break;
+
+    case PAGE_TICKS:
+        value = per_minute(PERF_WAKE_TICK);
+        break;
+
+    case PAGE_TIMERS:
+        value = per_minute(PERF_WAKE_TIMER);
+        break;
+
+    case PAGE_TICK_LATE:
+        value = perf_late_percentile(PERF_LATE_TICK, 95);
+        break;
+
+    case PAGE_TIMER_LATE:
+        value = perf_late_percentile(PERF_LATE_TIMER, 95);
+        break;
+
+    /* Redraws are timed to the ms, so the average is good to about a
+    * tenth of one over enough of them, and no finer.
+    */
+    case PAGE_DRAW_AVG:
+        frames = perf_get(PERF_FRAME);
+        value = frames ? perf_get(PERF_DRAW_MS) * 10 / frames : 0;
+        break;
+
+    case PAGE_DRAW_MAX:
+        value = perf_get(PERF_DRAW_MAX_MS);
+        break;
+
+    case PAGE_WRITES:
+        value = perf_get(PERF_PERSIST_WRITE);
+        break;
+    }
+
+    display_set_title(page_titles[pvt->page]);
+    display_set_number(value);
+}
+
+
+static bool click_up(Face *face, uint8_t count)
+{
+    Private *pvt = (Private *)face->data;
+
+    if (++pvt->page >= PAGE_COUNT)
+    {
+        pvt->page = 0;
+    }
+    show_page(pvt);
+
+    return true;
+}
+
+
+static void load_handler(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    pvt->visible = true;
+    show_page(pvt);
+}
+
+
+static void unload_handler(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    pvt->visible = false;
+    display_clear();
+}
+
+
+static void update_handler(Face *face, struct tm *tt, TimeUnits uc)
+{
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->visible)
+    {
+        show_page(pvt);
+    }
+}
+
+
+/**
+* Create the performance face. Set up the data structures in static
+* storage. Do not draw anything until the load_handler() is called.
+*****************************************************************************/
+Face *hud_create(const char *name, uint32_t key)
+{
+    Face *face = (Face *)storage;
+    Private *pvt = (Private *)face->data;
+    uint8_t page = 0;
+
+    LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
+    memset(storage, 0, sizeof(storage));
+
+    face->load_handler = load_handler;
+    face->unload_handler = unload_handler;
+    face->update_handler = update_handler;
+    face->click_up = click_up;
+
+    face->tick_units = SECOND_UNIT;
+    face->tick_hidden = false;
+
+    strncpy(face->name, name, sizeof(face->name));
+    face->name[sizeof(face->name) - 1] = 0;
+    face->key = key;
+
+    record_read(face->key, RECORD_TAG_HUD, HUD_VERSION, &page, sizeof(page));
+    pvt->page = page < PAGE_COUNT ? page : 0;
+
+    LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
+    return face;
+}
+
+
+/**
+* Destroy the performance face. Save its state and release resources.
+*****************************************************************************/
+void hud_destroy(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    uint8_t page = pvt->page;
+
+    LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
+    record_write(face->key, RECORD_TAG_HUD, HUD_VERSION, &page, sizeof(page));
+    LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
+}
+
+#endif
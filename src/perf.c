@@ -0,0 +1,391 @@
+/****************************************************************************/
+/**
+* Performance counters. Counts the things that cost battery: wakeups,
+* update handler calls, redraws, vibrations, and flash writes.
+*
+* @file   perf.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "fmt.h"
+#include "perf.h"
+#include "utils.h"
+
+#if PERF
+
+
+#define PERF_LATE_BUCKETS       12      /* 0, 1, 2-3, ... 512-1023, 1024+ */
+#define PERF_LINE_SLACK         48      /* room needed for one more item */
+
+
+typedef struct _PerfLateHist
+{
+    uint32_t bucket[PERF_LATE_BUCKETS];
+    uint32_t early;             /* samples that came early, also in bucket */
+    uint32_t max;
+}
+PerfLateHist;
+
+
+typedef struct _PerfClickStats
+{
+    uint16_t count;             /* clicks */
+    uint16_t draws;             /* clicks that caused a redraw */
+    uint16_t handler_max;
+    uint16_t draw_max;
+    uint32_t handler_ms;        /* total, for the average */
+    uint32_t draw_ms;
+}
+PerfClickStats;
+
+typedef struct _PerfClick
+{
+    TimeMS start;
+    PerfClickStats *stats;      /* NULL when not waiting for a redraw */
+    uint32_t dirty;             /* PERF_LAYER_DIRTY when clicked */
+}
+PerfClick;
+
+
+uint32_t perf_counters[PERF_NUM_COUNTERS];
+
+static time_t perf_started;
+static TimeMS perf_started_ms;  /* same, to the ms, for PERF_STARTUP_MS */
+static PerfLateHist perf_late_hist[PERF_NUM_LATE];
+static PerfClickStats perf_click_stats[PERF_NUM_BUTTONS][PERF_MAX_FACES];
+static PerfClick perf_click;
+
+static const char *perf_names[PERF_NUM_COUNTERS] =
+{
+    [PERF_WAKE_TICK] = "tick",
+    [PERF_WAKE_TIMER] = "timer",
+    [PERF_UPDATE] = "update",
+    [PERF_LAYER_DIRTY] = "dirty",
+    [PERF_FRAME] = "frame",
+    [PERF_FRAME_AREA] = "area",
+    [PERF_DRAW_MS] = "draw_ms",
+    [PERF_DRAW_MAX_MS] = "draw_max",
+    [PERF_VIBE] = "vibe",
+    [PERF_VIBE_MS] = "vibe_ms",
+    [PERF_PERSIST_WRITE] = "persist",
+    [PERF_PERSIST_SKIP] = "persist_skip",
+    [PERF_PERSIST_READ] = "persist_read",
+    [PERF_PERSIST_MS] = "persist_ms",
+    [PERF_STARTUP_MS] = "startup_ms",
+};
+
+static const char *perf_late_names[PERF_NUM_LATE] =
+{
+    [PERF_LATE_TICK] = "late_tick",
+    [PERF_LATE_TIMER] = "late_timer",
+};
+
+static const char *perf_button_names[PERF_NUM_BUTTONS] =
+{
+    [BUTTON_ID_BACK] = "back",
+    [BUTTON_ID_UP] = "up",
+    [BUTTON_ID_SELECT] = "sel",
+    [BUTTON_ID_DOWN] = "down",
+};
+
+
+/**
+* Reset the counters and start timing.
+*****************************************************************************/
+void perf_start(void)
+{
+    memset(perf_counters, 0, sizeof(perf_counters));
+    memset(perf_late_hist, 0, sizeof(perf_late_hist));
+    memset(perf_click_stats, 0, sizeof(perf_click_stats));
+    perf_click.stats = NULL;
+    perf_started = time(NULL);
+    time_ms(&perf_started_ms.sec, &perf_started_ms.ms);
+}
+
+
+/**
+* Get a counter.
+*****************************************************************************/
+uint32_t perf_get(PerfCounter counter)
+{
+    return perf_counters[counter];
+}
+
+
+/**
+* How long the counters have been running.
+*****************************************************************************/
+uint32_t perf_elapsed(void)
+{
+    return time(NULL) - perf_started;
+}
+
+
+/* Copy a string, and return a pointer to the terminating NUL.
+*/
+static char *perf_put(char *s, const char *str)
+{
+    while (*str)
+    {
+        *s++ = *str++;
+    }
+    *s = 0;
+
+    return s;
+}
+
+
+/* Log a line if there isn't room for another item, and start a new one.
+*/
+static char *perf_flush(char *line, char *s, char *end, bool force)
+{
+    if (force || end - s < PERF_LINE_SLACK)
+    {
+        app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "%s", line);
+        s = perf_put(line, "perf");
+    }
+
+    return s;
+}
+
+
+/**
+* Add one sample to a lateness histogram. Early samples are counted by how
+* early they were, that is timing error too.
+*****************************************************************************/
+void perf_late(PerfLate which, int32_t ms)
+{
+    PerfLateHist *h = &perf_late_hist[which];
+    uint32_t err = ms < 0 ? -ms : ms;
+    int i = 0;
+
+    if (ms < 0)
+    {
+        h->early++;
+    }
+
+    while (err >> i && i < PERF_LATE_BUCKETS - 1)
+    {
+        i++;
+    }
+    h->bucket[i]++;
+
+    if (err > h->max)
+    {
+        h->max = err;
+    }
+}
+
+
+/**
+* Get a percentile of a lateness histogram.
+*****************************************************************************/
+uint32_t perf_late_percentile(PerfLate which, unsigned int pct)
+{
+    PerfLateHist *h = &perf_late_hist[which];
+    uint32_t total = 0;
+    uint32_t want;
+    uint32_t seen = 0;
+    int i;
+
+    for (i = 0; i < PERF_LATE_BUCKETS; i++)
+    {
+        total += h->bucket[i];
+    }
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    want = ((uint64_t)total * pct + 99) / 100;
+    for (i = 0; i < PERF_LATE_BUCKETS - 1; i++)
+    {
+        seen += h->bucket[i];
+        if (seen >= want && seen > 0)
+        {
+            uint32_t top = (1 << i) - 1;
+
+            return top < h->max ? top : h->max;
+        }
+    }
+
+    return h->max;
+}
+
+
+/* Milliseconds since a click started, capped to fit the stats.
+*/
+static uint16_t perf_click_ms(void)
+{
+    TimeMS now;
+
+    time_ms(&now.sec, &now.ms);
+    time_diff(&now, &now, &perf_click.start);
+
+    return now.sec >= 60 ? 60000 : now.sec * 1000 + now.ms;
+}
+
+
+/**
+* Note that a click handler was entered.
+*****************************************************************************/
+void perf_click_start(ButtonId button, int face)
+{
+    if (button < PERF_NUM_BUTTONS && face >= 0 && face < PERF_MAX_FACES)
+    {
+        perf_click.stats = &perf_click_stats[button][face];
+        perf_click.dirty = perf_counters[PERF_LAYER_DIRTY];
+        time_ms(&perf_click.start.sec, &perf_click.start.ms);
+    }
+}
+
+
+/**
+* Note that the click handler is returning.
+*****************************************************************************/
+void perf_click_end(void)
+{
+    PerfClickStats *c = perf_click.stats;
+    uint16_t ms;
+
+    if (c)
+    {
+        ms = perf_click_ms();
+        c->count++;
+        c->handler_ms += ms;
+        if (ms > c->handler_max)
+        {
+            c->handler_max = ms;
+        }
+
+        if (perf_counters[PERF_LAYER_DIRTY] == perf_click.dirty)
+        {
+            perf_click.stats = NULL;
+        }
+    }
+}
+
+
+/**
+* Note that a redraw of the watch layer has finished.
+*****************************************************************************/
+void perf_frame_done(void)
+{
+    PerfClickStats *c = perf_click.stats;
+    uint16_t ms;
+
+    if (perf_counters[PERF_FRAME] == 1)
+    {
+        TimeMS now;
+
+        time_ms(&now.sec, &now.ms);
+        time_diff(&now, &now, &perf_started_ms);
+        perf_counters[PERF_STARTUP_MS] = now.sec * 1000 + now.ms;
+    }
+
+    if (c)
+    {
+        ms = perf_click_ms();
+        c->draws++;
+        c->draw_ms += ms;
+        if (ms > c->draw_max)
+        {
+            c->draw_max = ms;
+        }
+
+        perf_click.stats = NULL;
+    }
+}
+
+
+/**
+* Log the counters and the lateness histograms as name=value pairs, on as
+* many lines as it takes.
+*****************************************************************************/
+void perf_log(void)
+{
+    char line[160];
+    char *s = line;
+    char *end = line + sizeof(line);
+    uint32_t secs = perf_elapsed();
+    int i;
+
+    s = perf_put(s, "perf secs=");
+    s = fmt_uint(s, secs);
+
+    for (i = 0; i < PERF_NUM_COUNTERS; i++)
+    {
+        uint32_t per_day = secs ? (uint64_t)perf_counters[i] * 86400 / secs : 0;
+
+        s = perf_flush(line, s, end, false);
+        s = perf_put(s, " ");
+        s = perf_put(s, perf_names[i]);
+        s = perf_put(s, "=");
+        s = fmt_uint(s, perf_counters[i]);
+        s = perf_put(s, "/");
+        s = fmt_uint(s, per_day);
+    }
+
+    for (i = 0; i < PERF_NUM_LATE; i++)
+    {
+        s = perf_flush(line, s, end, false);
+        s = perf_put(s, " ");
+        s = perf_put(s, perf_late_names[i]);
+        s = perf_put(s, "=");
+        s = fmt_uint(s, perf_late_percentile(i, 50));
+        s = perf_put(s, "/");
+        s = fmt_uint(s, perf_late_percentile(i, 95));
+        s = perf_put(s, "/");
+        s = fmt_uint(s, perf_late_percentile(i, 100));
+    }
+
+    s = perf_flush(line, s, end, true);
+
+    for (i = 0; i < PERF_NUM_BUTTONS * PERF_MAX_FACES; i++)
+    {
+        PerfClickStats *c = &perf_click_stats[0][0] + i;
+
+        if (c->count)
+        {
+            s = perf_put(s, " click=");
+            s = perf_put(s, perf_button_names[i / PERF_MAX_FACES]);
+            s = perf_put(s, "/");
+            s = fmt_uint(s, i % PERF_MAX_FACES);
+            s = perf_put(s, " n=");
+            s = fmt_uint(s, c->count);
+            s = perf_put(s, " handler=");
+            s = fmt_uint(s, c->handler_ms / c->count);
+            s = perf_put(s, "/");
+            s = fmt_uint(s, c->handler_max);
+            s = perf_put(s, " draw=");
+            s = fmt_uint(s, c->draws ? c->draw_ms / c->draws : 0);
+            s = perf_put(s, "/");
+            s = fmt_uint(s, c->draw_max);
+            s = perf_flush(line, s, end, true);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,219 @@
+/****************************************************************************/
+/**
+* Performance counters. Counts the things that cost battery: wakeups,
+* update handler calls, redraws, vibrations, and flash writes. The counts
+* can be logged as one machine-readable line, scaled to a 24 hour day so
+* runs of different lengths compare directly.
+*
+* Set PERF to false to compile all of it out.
+*
+* @file   perf.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef PERF_H
+#define PERF_H
+
+
+#include <pebble.h>
+
+
+#ifndef PERF
+#define PERF    (false) /* true compiles in the counters, see Makefile */
+#endif
+
+
+typedef enum
+{
+    PERF_WAKE_TICK,             /* tick service wakeups */
+    PERF_WAKE_TIMER,            /* AppTimer wakeups */
+    PERF_UPDATE,                /* face update_handler() calls */
+    PERF_LAYER_DIRTY,           /* layers marked dirty or given new text */
+    PERF_FRAME,                 /* watch layer redraws */
+    PERF_FRAME_AREA,            /* area of the box around what changed */
+    PERF_DRAW_MS,               /* total time spent in those redraws */
+    PERF_DRAW_MAX_MS,           /* longest single redraw, not a count */
+    PERF_VIBE,                  /* vibration patterns started */
+    PERF_VIBE_MS,               /* time the motor was on for them */
+    PERF_PERSIST_WRITE,         /* persistent storage writes */
+    PERF_PERSIST_SKIP,          /* writes skipped, nothing had changed */
+    PERF_PERSIST_READ,          /* persistent storage reads */
+    PERF_PERSIST_MS,            /* time spent reading and writing it */
+    PERF_STARTUP_MS,            /* start to first frame drawn, not a count */
+    PERF_NUM_COUNTERS,
+}
+PerfCounter;
+
+typedef enum
+{
+    PERF_LATE_TICK,             /* tick service, from the second or minute */
+    PERF_LATE_TIMER,            /* AppTimers, from when they were due */
+    PERF_NUM_LATE,
+}
+PerfLate;
+
+
+#define PERF_MAX_FACES  8       /* faces tracked for click latency */
+#define PERF_NUM_BUTTONS 4      /* BACK, UP, SELECT, DOWN */
+
+
+#if !PERF
+
+#define PERF_INC(counter)
+#define PERF_ADD(counter, n)
+#define PERF_MAX(counter, n)
+#define PERF_LATE(which, ms)
+#define PERF_CLICK_START(button, face)
+#define PERF_CLICK_END()
+#define PERF_FRAME_DONE()
+
+#define perf_start()
+#define perf_get(counter)       (0)
+#define perf_elapsed()          (0)
+#define perf_late_percentile(which, pct)        (0)
+#define perf_log()
+
+#else
+
+extern uint32_t perf_counters[PERF_NUM_COUNTERS];
+
+/** Count one occurrence of something.
+*/
+#define PERF_INC(counter)       (perf_counters[(counter)]++)
+
+/** Count several occurrences of something.
+*/
+#define PERF_ADD(counter, n)    (perf_counters[(counter)] += (n))
+
+/** Keep the largest value seen.
+*/
+#define PERF_MAX(counter, n)                            \
+    do                                                  \
+    {                                                   \
+        uint32_t perf_n_ = (n);                         \
+        if (perf_n_ > perf_counters[(counter)])         \
+        {                                               \
+            perf_counters[(counter)] = perf_n_;         \
+        }                                               \
+    } while (0)
+
+
+/** Record how late a callback ran, in ms.
+*/
+#define PERF_LATE(which, ms)    perf_late((which), (ms))
+
+/** Time a click from the handler being called to the handler returning,
+* and to the end of the redraw it caused.
+*/
+#define PERF_CLICK_START(button, face)  perf_click_start((button), (face))
+#define PERF_CLICK_END()                perf_click_end()
+#define PERF_FRAME_DONE()               perf_frame_done()
+
+
+/**
+* Reset the counters and start timing.
+*****************************************************************************/
+void perf_start(void);
+
+
+/**
+* Get a counter.
+*
+* @param counter        Which counter.
+*
+* @return  The count since perf_start().
+*****************************************************************************/
+uint32_t perf_get(PerfCounter counter);
+
+
+/**
+* How long the counters have been running.
+*
+* @return  Seconds since perf_start().
+*****************************************************************************/
+uint32_t perf_elapsed(void);
+
+
+/**
+* Add one sample to a lateness histogram. Use the PERF_LATE() macro rather
+* than calling this directly. The histogram buckets are powers of two, so
+* it stays small and covers anything from 1 ms to seconds.
+*
+* @param which  Which histogram.
+* @param ms     How late the callback ran, negative if it was early.
+*****************************************************************************/
+void perf_late(PerfLate which, int32_t ms);
+
+
+/**
+* Get a percentile of a lateness histogram. The result is the top of the
+* bucket the percentile falls in, so it errs on the late side.
+*
+* @param which  Which histogram.
+* @param pct    The percentile, 0-100. 100 gives the latest ever seen.
+*
+* @return  Lateness in ms, or 0 if there are no samples.
+*****************************************************************************/
+uint32_t perf_late_percentile(PerfLate which, unsigned int pct);
+
+
+/**
+* Note that a click handler was entered. Use the PERF_CLICK_START() macro
+* rather than calling this directly.
+*
+* @param button Which button was clicked.
+* @param face   Index of the face that was active when it was clicked.
+*****************************************************************************/
+void perf_click_start(ButtonId button, int face);
+
+
+/**
+* Note that the click handler is returning. If the click didn't change
+* anything on screen there is no redraw to wait for, so only the handler
+* time is recorded.
+*****************************************************************************/
+void perf_click_end(void);
+
+
+/**
+* Note that a redraw of the watch layer has finished. Records the time
+* from the click that caused it, if there was one, and for the first one
+* the time since perf_start().
+*****************************************************************************/
+void perf_frame_done(void);
+
+
+/**
+* Log the counters as name=value pairs. Each value is the raw count followed
+* by the count per 24 hours, like "tick=3600/86400". Then the lateness
+* histograms as median/p95/max ms, like "late_tick=15/31/40". Then one line
+* per button and face that was clicked, with the click count and the
+* average/max ms to handler return and to the end of the redraw.
+*****************************************************************************/
+void perf_log(void);
+
+#endif
+
+
+#endif  /* include guard */
@@ -0,0 +1,335 @@
+/****************************************************************************/
+/**
+* Small tagged and versioned records for persistent storage, kept together
+* in one snapshot.
+*
+* @file   record.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "perf.h"
+#include "record.h"
+#include "resources.h"
+#include "trace.h"
+#include "utils.h"
+
+
+#define SNAPSHOT_VERSION    (1)
+
+
+typedef struct _Snapshot
+{
+    SnapshotHeader header;
+    uint8_t data[RECORD_SPACE]; /* records one after the other */
+}
+Snapshot;
+
+
+/* Where the baseline release kept each face's state, one blob per key.
+* The faces read these on the first start after an upgrade, and they are
+* deleted once that state is safely in the snapshot.
+*/
+static const uint8_t legacy_keys[] =
+{
+    PERSIST_KEY_MAIN_STATE,
+    PERSIST_KEY_WATCH_STATE,
+    PERSIST_KEY_STW_STATE,
+    PERSIST_KEY_TMR1_STATE,
+    PERSIST_KEY_TMR2_STATE,
+};
+
+static Snapshot snapshot;
+static int record_holds;        /* record_begin() depth */
+static bool record_dirty;       /* snapshot changed since it was written */
+static bool record_old_keys;    /* no snapshot yet, may be per-face keys */
+
+
+/* CRC-16/CCITT, bit at a time. The snapshot is small enough that a table
+* isn't worth the space.
+*/
+static uint16_t crc16(const uint8_t *data, size_t size)
+{
+    uint16_t crc = 0xffff;
+    int bit;
+
+    while (size--)
+    {
+        crc ^= *data++ << 8;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+
+/* Find where the record for a key starts in the snapshot, or -1.
+*/
+static int find(uint32_t key)
+{
+    int off = 0;
+
+    while (off + (int)sizeof(RecordHeader) <= snapshot.header.size)
+    {
+        RecordHeader *header = (RecordHeader *)&snapshot.data[off];
+
+        if (header->key == key)
+        {
+            return off;
+        }
+        off += sizeof(RecordHeader) + header->size;
+    }
+
+    return -1;
+}
+
+
+/* Check that the records exactly fill the snapshot.
+*/
+static bool well_formed(void)
+{
+    int off = 0;
+
+    while (off + (int)sizeof(RecordHeader) <= snapshot.header.size)
+    {
+        RecordHeader *header = (RecordHeader *)&snapshot.data[off];
+
+        off += sizeof(RecordHeader) + header->size;
+    }
+
+    return off == snapshot.header.size;
+}
+
+
+/* Write the snapshot. The first time, also get rid of the baseline keys,
+* but only after the write worked, so a failed or interrupted first write
+* leaves the old state there to be read again on the next start.
+*/
+static void commit(void)
+{
+    int len = sizeof(SnapshotHeader) + snapshot.header.size;
+    unsigned int i;
+#if PERF
+    TimeMS start, end;
+
+    time_ms(&start.sec, &start.ms);
+#endif
+
+    snapshot.header.magic[0] = 'D';
+    snapshot.header.magic[1] = 'C';
+    snapshot.header.version = SNAPSHOT_VERSION;
+    snapshot.header.spare = 0;
+    snapshot.header.crc = crc16(snapshot.data, snapshot.header.size);
+
+    if (persist_write_data(PERSIST_KEY_SNAPSHOT, &snapshot, len) < 0)
+    {
+        LOG_MSG_ERROR("Can't write snapshot");
+        goto error_0;
+    }
+    record_dirty = false;
+    PERF_INC(PERF_PERSIST_WRITE);
+    TRACE_EVENT(TRACE_PERSIST, PERSIST_KEY_SNAPSHOT, len);
+
+    if (record_old_keys)
+    {
+        for (i = 0; i < sizeof(legacy_keys); i++)
+        {
+            persist_delete(legacy_keys[i]);
+        }
+        record_old_keys = false;
+    }
+
+error_0:
+#if PERF
+    time_ms(&end.sec, &end.ms);
+    time_diff(&end, &end, &start);
+    PERF_ADD(PERF_PERSIST_MS, end.sec * 1000 + end.ms);
+#endif
+    return;
+}
+
+
+/**
+* Read the snapshot.
+*****************************************************************************/
+void record_load(void)
+{
+    int len;
+#if PERF
+    TimeMS start, end;
+
+    time_ms(&start.sec, &start.ms);
+#endif
+
+    len = persist_read_data(PERSIST_KEY_SNAPSHOT, &snapshot, sizeof(snapshot));
+    PERF_INC(PERF_PERSIST_READ);
+
+    if (len == E_DOES_NOT_EXIST)
+    {
+        record_old_keys = true;
+        memset(&snapshot, 0, sizeof(snapshot));
+    }
+    else if (len < (int)sizeof(SnapshotHeader)
+             || snapshot.header.magic[0] != 'D'
+             || snapshot.header.magic[1] != 'C'
+             || snapshot.header.version != SNAPSHOT_VERSION
+             || snapshot.header.size != len - sizeof(SnapshotHeader)
+             || snapshot.header.crc != crc16(snapshot.data, snapshot.header.size)
+             || !well_formed())
+    {
+        LOG_MSG_WARNING("Bad snapshot, %d bytes, using defaults", len);
+        memset(&snapshot, 0, sizeof(snapshot));
+    }
+
+#if PERF
+    time_ms(&end.sec, &end.ms);
+    time_diff(&end, &end, &start);
+    PERF_ADD(PERF_PERSIST_MS, end.sec * 1000 + end.ms);
+#endif
+}
+
+
+/**
+* Check if there is no snapshot yet.
+*****************************************************************************/
+bool record_legacy(void)
+{
+    return record_old_keys;
+}
+
+
+/**
+* Read a record.
+*****************************************************************************/
+int record_read(uint32_t key,
+                RecordTag tag,
+                uint8_t version,
+                void *data,
+                size_t size)
+{
+    int off = find(key);
+    RecordHeader *header;
+
+    if (off < 0)
+    {
+        return -1;
+    }
+
+    header = (RecordHeader *)&snapshot.data[off];
+    if (header->tag != tag || header->version != version || header->size > size)
+    {
+        LOG_MSG_WARNING("Key %lu has no record %d.%d",
+                        (unsigned long)key, tag, version);
+        return -1;
+    }
+
+    memcpy(data, &snapshot.data[off + sizeof(RecordHeader)], header->size);
+    return header->size;
+}
+
+
+/**
+* Write a record.
+*****************************************************************************/
+void record_write(uint32_t key,
+                  RecordTag tag,
+                  uint8_t version,
+                  const void *data,
+                  size_t size)
+{
+    int off = find(key);
+    int used = snapshot.header.size;
+    RecordHeader *header;
+
+    if (off >= 0)
+    {
+        header = (RecordHeader *)&snapshot.data[off];
+        if (header->tag == tag
+            && header->version == version
+            && header->size == size
+            && memcmp(&snapshot.data[off + sizeof(RecordHeader)], data, size) == 0)
+        {
+            PERF_INC(PERF_PERSIST_SKIP);
+            return;
+        }
+        used -= sizeof(RecordHeader) + header->size;
+    }
+
+    /* Check before taking anything out, so a record that doesn't fit
+    * leaves the old one there.
+    */
+    if (used + sizeof(RecordHeader) + size > RECORD_SPACE)
+    {
+        LOG_MSG_ERROR("No room for record %d, %u bytes", tag, (unsigned int)size);
+        return;
+    }
+
+    if (off >= 0)
+    {
+        /* Take the old one out, the new one goes at the end.
+        */
+        int len = snapshot.header.size - used;
+
+        memmove(&snapshot.data[off], &snapshot.data[off + len],
+                snapshot.header.size - off - len);
+        snapshot.header.size = used;
+    }
+
+    header = (RecordHeader *)&snapshot.data[snapshot.header.size];
+    header->tag = tag;
+    header->version = version;
+    header->size = size;
+    header->key = key;
+    memcpy(header + 1, data, size);
+    snapshot.header.size += sizeof(RecordHeader) + size;
+
+    record_dirty = true;
+    if (record_holds == 0)
+    {
+        commit();
+    }
+}
+
+
+/**
+* Hold back snapshot writes.
+*****************************************************************************/
+void record_begin(void)
+{
+    record_holds++;
+}
+
+
+/**
+* Write the snapshot if anything changed since record_begin().
+*****************************************************************************/
+void record_end(void)
+{
+    if (record_holds > 0 && --record_holds == 0 && record_dirty)
+    {
+        commit();
+    }
+}
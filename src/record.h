@@ -0,0 +1,183 @@
+/****************************************************************************/
+/**
+* Small tagged and versioned records for persistent storage. Each record is
+* a 4 byte header followed by the fields that mean something after a
+* restart, in fixed width types, so the layout doesn't depend on the
+* compiler and a face can tell its own current data from an older layout.
+*
+* All the records live in one snapshot under PERSIST_KEY_SNAPSHOT, with a
+* header that has a version and a CRC. It is read with one call at startup
+* and written with one call whenever a record changes, so a record that
+* hasn't changed costs nothing to write. Faces can then save at every change
+* of state that matters after a crash, and exiting only writes if something
+* changed. A snapshot that doesn't check out is thrown away and every face
+* starts from its defaults.
+*
+* @file   record.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef RECORD_H
+#define RECORD_H
+
+
+#include <pebble.h>
+
+
+/* Which record is stored for a key. Never reuse a value.
+*/
+typedef enum
+{
+    RECORD_TAG_NONE,
+    RECORD_TAG_STOPWATCH,
+    RECORD_TAG_TIMERS,
+    RECORD_TAG_ALARMS,
+    RECORD_TAG_MAIN,
+    RECORD_TAG_WATCH,
+    RECORD_TAG_ZONE,
+    RECORD_TAG_HUD,
+}
+RecordTag;
+
+typedef struct _RecordHeader
+{
+    uint8_t tag;                /* RecordTag */
+    uint8_t version;            /* layout of the data, per tag */
+    uint8_t size;               /* bytes of data after the header */
+    uint8_t key;                /* PersistKey the record is for */
+}
+RecordHeader;
+
+typedef struct _SnapshotHeader
+{
+    char magic[2];              /* "DC" */
+    uint8_t version;            /* layout of the snapshot itself */
+    uint8_t spare;
+    uint16_t size;              /* bytes of records after the header */
+    uint16_t crc;               /* CRC-16 of those bytes */
+}
+SnapshotHeader;
+
+/* Room for records, headers included.
+*/
+#define RECORD_SPACE    (PERSIST_DATA_MAX_LENGTH - sizeof(SnapshotHeader))
+#define RECORD_MAX_SIZE (RECORD_SPACE - sizeof(RecordHeader))
+
+/* The most data each record can hold. Every face's record has to fit in the
+* snapshot at the same time, so each face checks its record against its
+* entry here, and the total is checked against the space below. Growing a
+* record means finding the room for it here first.
+*/
+#define RECORD_MAIN_SIZE        (8)
+#define RECORD_WATCH_SIZE       (1)
+#define RECORD_TIMERS_SIZE      (96)
+#define RECORD_STOPWATCH_SIZE   (32)
+#define RECORD_ALARMS_SIZE      (40)
+#define RECORD_ZONE_SIZE        (2)
+#define RECORD_HUD_SIZE         (1)
+
+#define RECORD_WORST_CASE       (7 * sizeof(RecordHeader)                   \
+                                 + RECORD_MAIN_SIZE                         \
+                                 + RECORD_WATCH_SIZE                        \
+                                 + RECORD_TIMERS_SIZE                       \
+                                 + RECORD_STOPWATCH_SIZE                    \
+                                 + RECORD_ALARMS_SIZE                       \
+                                 + RECORD_ZONE_SIZE                         \
+                                 + RECORD_HUD_SIZE)
+
+_Static_assert(RECORD_WORST_CASE <= RECORD_SPACE,
+               "records can outgrow the snapshot");
+
+
+/**
+* Read the snapshot. Must be called before any records are read.
+*****************************************************************************/
+void record_load(void);
+
+
+/**
+* Check if there is no snapshot yet, because this is the first start since
+* an upgrade. Only then is it worth looking for state saved under the old
+* per-face keys. A face that finds old state writes it as a record right
+* away, so all of it goes into the first snapshot together, before the old
+* keys are deleted.
+*
+* @return  true if old per-face state may be around.
+*****************************************************************************/
+bool record_legacy(void);
+
+
+/**
+* Read a record. A record shorter than the buffer is allowed, the rest of
+* the buffer is left alone, so a record can grow at the end without a new
+* version.
+*
+* @param key        Persist key of the face.
+* @param tag        The tag the record must have.
+* @param version    The version the record must have.
+* @param data       Where to put the data.
+* @param size       Size of the buffer.
+*
+* @return  Bytes of data read, or -1 if there is no such record.
+*****************************************************************************/
+int record_read(uint32_t key,
+                RecordTag tag,
+                uint8_t version,
+                void *data,
+                size_t size);
+
+
+/**
+* Write a record, replacing the one for the key. If it is different from
+* what was there the snapshot is written, unless record_begin() is holding
+* writes back. If the new record doesn't fit, the old one is kept and
+* nothing is written.
+*
+* @param key        Persist key of the face.
+* @param tag        The record's tag.
+* @param version    The record's version.
+* @param data       The data.
+* @param size       Bytes of data, at most RECORD_MAX_SIZE.
+*****************************************************************************/
+void record_write(uint32_t key,
+                  RecordTag tag,
+                  uint8_t version,
+                  const void *data,
+                  size_t size);
+
+
+/**
+* Hold back snapshot writes until record_end(), so a batch of changes is
+* written with one call. Calls can be nested.
+*****************************************************************************/
+void record_begin(void);
+
+
+/**
+* End a record_begin(), writing the snapshot if anything changed.
+*****************************************************************************/
+void record_end(void);
+
+
+#endif  /* include guard */
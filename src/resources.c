@@ -31,8 +31,6 @@
 #include "utils.h"
 
 
-GFont *res_font_large;
-GFont *res_font_medium;
 GFont *res_font_small;
 
 
@@ -44,8 +42,6 @@ int res_create(void)
 {
     int err = true;
     ResHandle res_s = resource_get_handle(RESOURCE_ID_FONT_ROBOTO_CONDENSED_14);
-    ResHandle res_m = resource_get_handle(RESOURCE_ID_FONT_ROBOTO_CONDENSED_22);
-    ResHandle res_l = resource_get_handle(RESOURCE_ID_FONT_ROBOTO_BOLD_SUBSET_42);
 
     res_font_small = fonts_load_custom_font(res_s);
     if (res_font_small == NULL)
@@ -54,28 +50,7 @@ int res_create(void)
         goto error_0;
     }
 
-    res_font_medium = fonts_load_custom_font(res_m);
-    if (res_font_medium == NULL)
-    {
-        LOG_MSG_ERROR("Can't load medium font");
-        goto error_1;
-    }
-
-    res_font_large = fonts_load_custom_font(res_l);
-    if (res_font_large == NULL)
-    {
-        LOG_MSG_ERROR("Can't load large font");
-        goto error_2;
-    }
-
     err = false;
-    goto error_0;
-
-error_2:
-    fonts_unload_custom_font(res_font_medium);
-
-error_1:
-    fonts_unload_custom_font(res_font_small);
 
 error_0:
     return err;
@@ -87,8 +62,6 @@ error_0:
 *****************************************************************************/
 void res_destroy(void)
 {
-    fonts_unload_custom_font(res_font_large);
-    fonts_unload_custom_font(res_font_medium);
     fonts_unload_custom_font(res_font_small);
 }
 
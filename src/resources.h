@@ -39,14 +39,17 @@ typedef enum
     PERSIST_KEY_MAIN_STATE,
     PERSIST_KEY_WATCH_STATE,
     PERSIST_KEY_STW_STATE,
-    PERSIST_KEY_TMR1_STATE,
-    PERSIST_KEY_TMR2_STATE,
+    PERSIST_KEY_TMR1_STATE,     /* old, migrated to PERSIST_KEY_TIMERS */
+    PERSIST_KEY_TMR2_STATE,     /* old, migrated to PERSIST_KEY_TIMERS */
+    PERSIST_KEY_HUD_STATE,
+    PERSIST_KEY_TIMERS,
+    PERSIST_KEY_ALARMS,
+    PERSIST_KEY_ZONE,
+    PERSIST_KEY_SNAPSHOT,       /* all of the above except the old ones */
 }
 PersistKey;
 
 
-extern GFont *res_font_large;
-extern GFont *res_font_medium;
 extern GFont *res_font_small;
 
 
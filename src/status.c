@@ -30,6 +30,7 @@
 #include "display.h"
 #include "status.h"
 #include "utils.h"
+#include "vibe.h"
 
 
 static void battery_handler(BatteryChargeState battery_state)
@@ -42,7 +43,7 @@ static void battery_handler(BatteryChargeState battery_state)
 static void bt_handler(bool connected)
 {
     display_set_bluetooth(connected);
-    vibes_double_pulse();
+    vibe_notify();
 }
 
 
@@ -62,7 +63,7 @@ void status_create(void)
     display_set_bluetooth(bt_connected);
     if (!bt_connected)
     {
-        vibes_double_pulse();
+        vibe_notify();
     }
     bluetooth_connection_service_subscribe(bt_handler);
 }
@@ -59,13 +59,17 @@
 *
 *****************************************************************************/
 #include "display.h"
+#include "record.h"
 #include "utils.h"
 #include "stopwatch.h"
+#include "wheel.h"
 
 
-#define TIMER_FAST_MS   (200)
-#define TIMER_SLOW_MS   (1000)
-#define MAX_FAST_SEC    (300) /* max time to display hundreths */
+#define TIMER_FAST_MS   (100) /* display resolution up to MAX_FAST_SEC */
+#define TIMER_SLOW_MS   (1000)/* display resolution after that */
+#define TIMER_SLACK_MS  (5)   /* this close to a digit change counts as on it */
+#define MAX_FAST_SEC    (300) /* max time to display tenths */
+#define STOPWATCH_VERSION (1) /* persisted record layout */
 
 
 typedef enum
@@ -80,32 +84,65 @@ typedef enum
 State;
 
 typedef struct _Private
+{
+    State state;                /* state machine variable */
+
+    TimeMS start_time;          /* starting time */
+    TimeMS last_time;           /* saved stop time for calculating laps */
+    TimeMS split_time;          /* total delta from start to split */
+    TimeMS lap_time;            /* delta since last split */
+    TimeMS stop_time;           /* saved stop time */
+
+    bool visible;
+    WheelTimer refresh;         /* next display refresh */
+} Private;
+
+FACE_STORAGE(storage, Private);
+
+
+/* What gets persisted, RECORD_TAG_STOPWATCH. Add fields only at the end.
+*/
+typedef struct _StopwatchRecord
+{
+    int32_t start;
+    int32_t last;
+    int32_t split;
+    int32_t lap;
+    int32_t stop;
+    uint16_t start_ms;
+    uint16_t last_ms;
+    uint16_t split_ms;
+    uint16_t lap_ms;
+    uint16_t stop_ms;
+    uint8_t state;
+    uint8_t spare;
+}
+StopwatchRecord;
+
+_Static_assert(sizeof(StopwatchRecord) <= RECORD_STOPWATCH_SIZE,
+               "stopwatch doesn't fit its record");
+
+/* The state as it was persisted before there were records, the whole
+* Private padded out to 128 bytes. Only used to migrate it.
+*/
+typedef struct _OldPrivate
 {
     union
     {
         struct
         {
-            State state;        /* state machine variable */
-            AppTimer *timer;    /* timer for background tasks */
-
-            TimeMS start_time;  /* starting time */
-            TimeMS last_time;   /* saved stop time for calculating laps */
-            TimeMS split_time;  /* total delta from start to split */
-            TimeMS lap_time;    /* delta since last split */
-
+            State state;
+            AppTimer *timer;
+            TimeMS start_time;
+            TimeMS last_time;
+            TimeMS split_time;
+            TimeMS lap_time;
             bool visible;
-
-            TimeMS stop_time;   /* saved stop time */
-
-            /* Always add more at the end */
+            TimeMS stop_time;
         };
-
-        /* Force this thing to always be the same size so upgrades don't
-        * screw up the persistence.
-        */
         uint8_t reserved[128];
     };
-} Private;
+} OldPrivate;
 
 
 static void calculate_splits(Private *pvt)
@@ -119,32 +156,75 @@ static void calculate_splits(Private *pvt)
 }
 
 
-static void timer_handler(void *data)
+/* Truncate the elapsed time to what the display can show and return how
+* long it is until the next visible digit changes: the tenths digit up to
+* MAX_FAST_SEC, the seconds digit after that. So every wakeup changes a
+* digit and the display never runs ahead of the real time.
+*/
+static uint32_t next_refresh(TimeMS *elapsed)
+{
+    uint32_t step = elapsed->sec < MAX_FAST_SEC ? TIMER_FAST_MS : TIMER_SLOW_MS;
+    uint32_t delay = step - (elapsed->ms % step);
+
+    if (delay <= TIMER_SLACK_MS)
+    {
+        /* Woke up a hair early, show the digit that is about to change
+        * rather than waking again right away.
+        */
+        elapsed->ms += delay;
+        if (elapsed->ms >= 1000)
+        {
+            elapsed->sec++;
+            elapsed->ms -= 1000;
+        }
+        delay += step;
+    }
+
+    elapsed->ms -= elapsed->ms % step;
+    return delay;
+}
+
+
+static void timer_handler(void *data);
+
+
+/* Update the display and schedule the next refresh if the stopwatch is
+* running, otherwise cancel any refresh that is pending.
+*/
+static void refresh(Private *pvt)
 {
     TimeMS now;
-    Private *pvt = data;
 
     if (pvt->state == STATE_RUN)
     {
-        uint32_t interval;
-
         time_ms(&now.sec, &now.ms);
         time_diff(&now, &now, &pvt->start_time);
 
-        interval = now.sec < MAX_FAST_SEC ? TIMER_FAST_MS : TIMER_SLOW_MS;
-        pvt->timer = app_timer_register(interval,  timer_handler, pvt);
+        wheel_schedule(&pvt->refresh, next_refresh(&now), timer_handler, pvt);
 
         if (pvt->visible)
         {
-            /* Round up to the next multiple of 100 ms so that the last digit
-            * in the display doesn't look so random.
-            */
-            display_set_interval(now.sec, now.ms + 100 - (now.ms % 100));
+            display_set_interval(now.sec, now.ms);
         }
     }
+    else
+    {
+        wheel_cancel(&pvt->refresh);
+    }
+}
+
+
+static void timer_handler(void *data)
+{
+    Private *pvt = data;
+
+    refresh(pvt);
 }
 
 
+static void save(Face *face);
+
+
 static bool click_sel(Face *face)
 {
     Private *pvt = (Private *)face->data;
@@ -155,13 +235,14 @@ static bool click_sel(Face *face)
         pvt->state = STATE_RUN;
         time_ms(&pvt->start_time.sec, &pvt->start_time.ms);
         pvt->last_time = pvt->start_time;
-        timer_handler(pvt);
+        refresh(pvt);
         display_set_title(face->name);
         break;
 
     case STATE_RUN:
         pvt->state = STATE_STOP_SPLIT;
         time_ms(&pvt->stop_time.sec, &pvt->stop_time.ms);
+        refresh(pvt);
         calculate_splits(pvt);
         display_set_interval(pvt->split_time.sec, pvt->split_time.ms);
         display_set_title("SPLIT");
@@ -187,13 +268,16 @@ static bool click_sel(Face *face)
         pvt->state = STATE_RUN;
         display_set_title(face->name);
         display_set_highlight(HL_NONE);
-        timer_handler(pvt);
+        refresh(pvt);
         break;
 
     default:
         return false;
     }
 
+    /* Started or stopped, save the times in case the app dies.
+    */
+    save(face);
     return true;
 }
 
@@ -218,6 +302,8 @@ static bool click_long_sel(Face *face)
     display_set_title(face->name);
     display_set_highlight(HL_NONE);
     pvt->state = STATE_START;
+    refresh(pvt);
+    save(face);
 
     return true;
 }
@@ -231,9 +317,11 @@ static bool click_up(Face *face, uint8_t count)
     {
     case STATE_RUN:
         pvt->state = STATE_SPLIT;
+        refresh(pvt);
         calculate_splits(pvt);
         display_set_interval(pvt->split_time.sec, pvt->split_time.ms);
         display_set_title("SPLT");
+        save(face);
         break;
 
     case STATE_STOP_LAP:
@@ -278,7 +366,7 @@ static void load_handler(Face *face)
     {
     case STATE_RUN:
         display_set_title("STW");
-        timer_handler(pvt);
+        refresh(pvt);
         break;
 
     case STATE_SPLIT:
@@ -317,11 +405,7 @@ static void unload_handler(Face *face)
 {
     Private *pvt = (Private *)face->data;
 
-    if (pvt->timer)
-    {
-        app_timer_cancel(pvt->timer);
-        pvt->timer = NULL;
-    }
+    wheel_cancel(&pvt->refresh);
 
     display_clear();
     pvt->visible = false;
@@ -334,35 +418,100 @@ static void update_handler(Face *face, struct tm *tt, TimeUnits uc)
 }
 
 
+/* Read back the persisted state, from a record or, the first time after an
+* upgrade, from the old blob.
+*/
+static void restore(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    StopwatchRecord rec;
+
+    memset(&rec, 0, sizeof(rec));
+    if (record_read(face->key, RECORD_TAG_STOPWATCH, STOPWATCH_VERSION,
+                    &rec, sizeof(rec)) >= 0)
+    {
+        pvt->state = rec.state;
+        pvt->start_time.sec = rec.start;
+        pvt->start_time.ms = rec.start_ms;
+        pvt->last_time.sec = rec.last;
+        pvt->last_time.ms = rec.last_ms;
+        pvt->split_time.sec = rec.split;
+        pvt->split_time.ms = rec.split_ms;
+        pvt->lap_time.sec = rec.lap;
+        pvt->lap_time.ms = rec.lap_ms;
+        pvt->stop_time.sec = rec.stop;
+        pvt->stop_time.ms = rec.stop_ms;
+    }
+    else if (record_legacy()
+             && persist_get_size(face->key) == sizeof(OldPrivate))
+    {
+        OldPrivate old;
+
+        persist_read_data(face->key, &old, sizeof(OldPrivate));
+        pvt->state = old.state;
+        pvt->start_time = old.start_time;
+        pvt->last_time = old.last_time;
+        pvt->split_time = old.split_time;
+        pvt->lap_time = old.lap_time;
+        pvt->stop_time = old.stop_time;
+        save(face);
+    }
+}
+
+
+static void save(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    StopwatchRecord rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.state = pvt->state;
+    rec.start = pvt->start_time.sec;
+    rec.start_ms = pvt->start_time.ms;
+    rec.last = pvt->last_time.sec;
+    rec.last_ms = pvt->last_time.ms;
+    rec.split = pvt->split_time.sec;
+    rec.split_ms = pvt->split_time.ms;
+    rec.lap = pvt->lap_time.sec;
+    rec.lap_ms = pvt->lap_time.ms;
+    rec.stop = pvt->stop_time.sec;
+    rec.stop_ms = pvt->stop_time.ms;
+
+    record_write(face->key, RECORD_TAG_STOPWATCH, STOPWATCH_VERSION,
+                 &rec, sizeof(rec));
+}
+
+
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
+* Create the watch face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *****************************************************************************/
 Face *stopwatch_create(const char *name, uint32_t key)
 {
-    Face *face = malloc(sizeof(Face) + sizeof(Private));
+    Face *face = (Face *)storage;
+    Private *pvt = (Private *)face->data;
 
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    if (face)
-    {
-        memset(face, 0, sizeof(Face) + sizeof(Private));
+    memset(storage, 0, sizeof(storage));
 
-        face->load_handler = load_handler;
-        face->unload_handler = unload_handler;
-        face->update_handler = update_handler;
-        face->click_sel = click_sel;
-        face->click_long_sel = click_long_sel;
-        face->click_up = click_up;
+    face->load_handler = load_handler;
+    face->unload_handler = unload_handler;
+    face->update_handler = update_handler;
+    face->click_sel = click_sel;
+    face->click_long_sel = click_long_sel;
+    face->click_up = click_up;
 
-        strncpy(face->name, name, sizeof(face->name));
-        face->name[sizeof(face->name) - 1] = 0;
-        face->key = key;
+    /* Display refresh runs off the timer wheel, no ticks needed.
+    */
+    face->tick_units = 0;
+    face->tick_hidden = false;
 
-        if (persist_get_size(face->key) == sizeof(Private))
-        {
-            persist_read_data(face->key, face->data, sizeof(Private));
-        }
-    }
+    strncpy(face->name, name, sizeof(face->name));
+    face->name[sizeof(face->name) - 1] = 0;
+    face->key = key;
+
+    restore(face);
+    wheel_timer_init(&pvt->refresh);
 
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
     return face;
@@ -370,13 +519,35 @@ Face *stopwatch_create(const char *name, uint32_t key)
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Check for a stopwatch that is running.
+*****************************************************************************/
+bool stopwatch_busy(uint32_t key)
+{
+    StopwatchRecord rec;
+
+    memset(&rec, 0, sizeof(rec));
+    if (record_read(key, RECORD_TAG_STOPWATCH, STOPWATCH_VERSION,
+                    &rec, sizeof(rec)) < 0)
+    {
+        return false;
+    }
+
+    return rec.state == STATE_RUN
+        || rec.state == STATE_SPLIT
+        || rec.state == STATE_LAP;
+}
+
+
+/**
+* Destroy the watch face. Save its state and release resources.
 *****************************************************************************/
 void stopwatch_destroy(Face *face)
 {
+    Private *pvt = (Private *)face->data;
+
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    persist_write_data(face->key, face->data, sizeof(Private));
-    free(face);
+    wheel_cancel(&pvt->refresh);
+    save(face);
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
 }
 
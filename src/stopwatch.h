@@ -53,22 +53,34 @@
 
 
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
+* Create the watch face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *
 * @param  name  Name of the face.
 * @param  key   Storage key to use.
 *
 *
-* @return  Pointer to the face, or NULL on error.
+* @return  Pointer to the face.
 *****************************************************************************/
 Face *stopwatch_create(const char *name, uint32_t key);
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Destroy the watch face. Save its state and release resources.
 *****************************************************************************/
 void stopwatch_destroy(Face *face);
 
 
+/**
+* Check the saved state for a stopwatch that is running. The face is then
+* created at startup, so its refresh is already going when DOWN reaches
+* it.
+*
+* @param  key   Storage key the face uses.
+*
+* @return  true if the face must be created at startup.
+*****************************************************************************/
+bool stopwatch_busy(uint32_t key);
+
+
 #endif  /* include guard */
@@ -0,0 +1,99 @@
+/****************************************************************************/
+/**
+* Millisecond timebase for faces that count toward a deadline. Time left is
+* always derived from one stored absolute deadline and a fresh clock read,
+* never from counting ticks, so late or missed ticks can't make it drift.
+*
+* @file   timebase.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "timebase.h"
+
+
+/* Clamp so a deadline that is days away (or a clock that jumped) can't
+* overflow the result. About 24 days either way.
+*/
+#define MAX_MS_LEFT     (0x7fffffffL)
+#define MAX_SEC_LEFT    (MAX_MS_LEFT / 1000 - 1)
+
+
+/**
+* Read the current time to the millisecond.
+*****************************************************************************/
+void timebase_now(TimeMS *now)
+{
+    time_ms(&now->sec, &now->ms);
+}
+
+
+/**
+* Set a deadline some number of milliseconds from now.
+*****************************************************************************/
+void timebase_set(TimeMS *deadline, uint32_t ms)
+{
+    TimeMS now;
+    uint32_t total;
+
+    timebase_now(&now);
+    total = now.ms + (ms % 1000);
+
+    deadline->sec = now.sec + (ms / 1000) + (total / 1000);
+    deadline->ms = total % 1000;
+}
+
+
+/**
+* How long until a deadline, read against the current time.
+*****************************************************************************/
+int32_t timebase_ms_left(const TimeMS *deadline)
+{
+    TimeMS now;
+    long sec;
+
+    timebase_now(&now);
+    sec = (long)(deadline->sec - now.sec);
+
+    if (sec > MAX_SEC_LEFT)
+    {
+        return MAX_MS_LEFT;
+    }
+    else if (sec < -MAX_SEC_LEFT)
+    {
+        return -MAX_MS_LEFT;
+    }
+
+    return sec * 1000 + ((int32_t)deadline->ms - (int32_t)now.ms);
+}
+
+
+/**
+* How many whole seconds to show for a countdown to a deadline.
+*****************************************************************************/
+time_t timebase_sec_left(const TimeMS *deadline)
+{
+    int32_t ms = timebase_ms_left(deadline);
+
+    return ms > 0 ? (ms + 999) / 1000 : 0;
+}
@@ -0,0 +1,78 @@
+/****************************************************************************/
+/**
+* Millisecond timebase for faces that count toward a deadline. Time left is
+* always derived from one stored absolute deadline and a fresh clock read,
+* never from counting ticks, so late or missed ticks can't make it drift.
+*
+* @file   timebase.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+
+#include <pebble.h>
+#include "utils.h"
+
+
+/**
+* Read the current time to the millisecond.
+*
+* @param now    Pointer to where to put the time.
+*****************************************************************************/
+void timebase_now(TimeMS *now);
+
+
+/**
+* Set a deadline some number of milliseconds from now.
+*
+* @param deadline       Pointer to the deadline to set.
+* @param ms             Milliseconds from now until the deadline.
+*****************************************************************************/
+void timebase_set(TimeMS *deadline, uint32_t ms);
+
+
+/**
+* How long until a deadline, read against the current time.
+*
+* @param deadline       Pointer to the deadline.
+*
+* @return  Milliseconds until the deadline, negative if it has passed.
+*****************************************************************************/
+int32_t timebase_ms_left(const TimeMS *deadline);
+
+
+/**
+* How many whole seconds to show for a countdown to a deadline. Rounds up,
+* so the display reaches zero at the moment the deadline passes.
+*
+* @param deadline       Pointer to the deadline.
+*
+* @return  Seconds left, never negative.
+*****************************************************************************/
+time_t timebase_sec_left(const TimeMS *deadline);
+
+
+#endif  /* include guard */
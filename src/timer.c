@@ -1,20 +1,24 @@
 /****************************************************************************/
 /**
-* Definitions for a countdown timer. To the user it has two main modes,
-* timer and setting. In timer mode, timers can be started, stopped, or
-* cancelled. Setting mode is for configuring the countdown time. The
-* maximum time is 23:59:59.
+* Definitions for a pool of countdown timers shown on one face. To the user
+* each timer has two main modes, timer and setting. In timer mode, timers
+* can be started, stopped, or cancelled. Setting mode is for configuring
+* the countdown time. The maximum time is 23:59:59. Any number of timers
+* can run at once.
+*
+* Running timers are kept in a min-heap by deadline, so only the soonest
+* one has a wakeup armed and nothing is polled.
 *
 * Titles:
-*       TMR     Static label.
+*       TMRn    Which timer is on screen.
 *
 * Buttons:
-*       UP      In setting mode, increase the highlighted value. When
-*               the timer is running, cancel it.
+*       UP      In setting mode, increase the highlighted value. Otherwise
+*               show the next timer.
 *       SEL     In timer mode, start and stop the countdown. In setting mode,
 *               move the highlight to the next field.
-*       L-SEL   Switch between timer and setting mode. Disabled when the
-*               timer is running.
+*       L-SEL   Switch between timer and setting mode. When the timer is
+*               running or stopped, cancel it.
 *       DN      In setting mode, decrease the highlighted value.
 *
 * @file   timer.c
@@ -43,11 +47,22 @@
 *
 *****************************************************************************/
 #include "display.h"
+#include "fmt.h"
+#include "record.h"
+#include "resources.h"
+#include "timebase.h"
 #include "utils.h"
-#include "watch.h"
+#include "vibe.h"
+#include "timer.h"
+#include "wheel.h"
 
 
 #define MAX_TIME        ((23 * 3600) + (59 * 60) + 59)
+#define TIMER_POOL_SIZE (8)     /* number of timers, see RECORD_TIMERS_SIZE */
+#define TIMER_VIBE_BASE (16)    /* vibe sources 16-31 are the timers */
+#define TIMER_VIBE_SOURCES (((1UL << TIMER_POOL_SIZE) - 1) << TIMER_VIBE_BASE)
+#define HEAP_NONE       (0xff)  /* timer isn't in the heap */
+#define TIMER_VERSION   (1)     /* persisted record layout */
 
 
 typedef enum
@@ -63,87 +78,406 @@ typedef enum
 }
 State;
 
+/* One countdown. This is what gets persisted, RECORD_TAG_TIMERS, so it has
+* fixed size fields and only things that mean something after a restart.
+* Unused timers at the end of the pool are left out of the record.
+*/
+typedef struct _Timer
+{
+    int32_t interval;           /* how long it is to run */
+    int32_t when;               /* running: when it expires, stopped: left */
+    uint16_t ms;                /* ms part of when */
+    uint8_t state;
+    uint8_t spare;
+}
+Timer;
+
 typedef struct _Private
+{
+    Timer timers[TIMER_POOL_SIZE];
+
+    /* Running timers, soonest deadline first, and where each timer is in
+    * the heap.
+    */
+    uint8_t heap[TIMER_POOL_SIZE];
+    uint8_t heap_pos[TIMER_POOL_SIZE];
+    uint8_t heap_len;
+
+    uint8_t current;            /* timer on screen */
+    bool visible;
+    WheelTimer expiry;          /* fires when the soonest timer runs out */
+} Private;
+
+FACE_STORAGE(storage, Private);
+
+_Static_assert(sizeof(Timer) * TIMER_POOL_SIZE <= RECORD_TIMERS_SIZE,
+               "timers don't fit their record");
+
+
+/* The per-timer state as it was persisted when there were two separate
+* timer faces, byte for byte. Only used to migrate it. It had whole
+* seconds only, so migrated timers start with no ms part.
+*/
+typedef struct _OldPrivate
 {
     union
     {
         struct
         {
-            State state;                /* state machine state */
-            AppTimer *timer_handle;     /* timer for background tasks */
-
-            time_t time_start;          /* when the timer was started */
-            time_t time_interval;       /* how long it is to run */
-            time_t time_left;           /* how much is left (for pausing) */
-            time_t time_end;            /* when the timer expires */
+            State state;
+            AppTimer *timer_handle;
+            time_t time_start;
+            time_t time_interval;
+            time_t time_left;
+            time_t time_end;
             time_t time_now;
-
             bool visible;
-
-            /* Always add more at the end */
         };
-
-        /* Force this thing to always be the same size so upgrades don't
-        * screw up the persistence.
-        */
         uint8_t reserved[128];
     };
-} Private;
+} OldPrivate;
+
+
+static void get_deadline(Timer *t, TimeMS *deadline)
+{
+    deadline->sec = t->when;
+    deadline->ms = t->ms;
+}
+
+
+static void set_deadline(Timer *t, time_t sec, uint16_t ms)
+{
+    TimeMS deadline;
+
+    timebase_set(&deadline, sec * 1000 + ms);
+    t->when = deadline.sec;
+    t->ms = deadline.ms;
+}
+
+
+static int32_t ms_left(Timer *t)
+{
+    TimeMS deadline;
+
+    get_deadline(t, &deadline);
+    return timebase_ms_left(&deadline);
+}
+
+
+static time_t sec_left(Timer *t)
+{
+    TimeMS deadline;
+
+    get_deadline(t, &deadline);
+    return timebase_sec_left(&deadline);
+}
+
+
+static bool due_before(Timer *a, Timer *b)
+{
+    return a->when < b->when || (a->when == b->when && a->ms < b->ms);
+}
+
+
+static void heap_swap(Private *pvt, int i, int j)
+{
+    uint8_t t = pvt->heap[i];
+
+    pvt->heap[i] = pvt->heap[j];
+    pvt->heap[j] = t;
+    pvt->heap_pos[pvt->heap[i]] = i;
+    pvt->heap_pos[pvt->heap[j]] = j;
+}
+
+
+static void heap_up(Private *pvt, int i)
+{
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+
+        if (!due_before(&pvt->timers[pvt->heap[i]],
+                        &pvt->timers[pvt->heap[parent]]))
+        {
+            break;
+        }
+        heap_swap(pvt, i, parent);
+        i = parent;
+    }
+}
+
+
+static void heap_down(Private *pvt, int i)
+{
+    for (;;)
+    {
+        int soonest = i;
+        int child = 2 * i + 1;
+
+        if (child < pvt->heap_len
+            && due_before(&pvt->timers[pvt->heap[child]],
+                          &pvt->timers[pvt->heap[soonest]]))
+        {
+            soonest = child;
+        }
+        child++;
+        if (child < pvt->heap_len
+            && due_before(&pvt->timers[pvt->heap[child]],
+                          &pvt->timers[pvt->heap[soonest]]))
+        {
+            soonest = child;
+        }
+
+        if (soonest == i)
+        {
+            break;
+        }
+        heap_swap(pvt, i, soonest);
+        i = soonest;
+    }
+}
+
+
+/* Add a timer that just started running.
+*/
+static void heap_add(Private *pvt, int timer)
+{
+    int i = pvt->heap_len++;
+
+    pvt->heap[i] = timer;
+    pvt->heap_pos[timer] = i;
+    heap_up(pvt, i);
+}
+
+
+/* Take out a timer that stopped running, if it is in there.
+*/
+static void heap_del(Private *pvt, int timer)
+{
+    int i = pvt->heap_pos[timer];
+
+    if (i == HEAP_NONE)
+    {
+        return;
+    }
+
+    pvt->heap_pos[timer] = HEAP_NONE;
+    if (i != --pvt->heap_len)
+    {
+        /* Fill the hole with the last one and move that where it goes.
+        */
+        int moved = pvt->heap[pvt->heap_len];
+
+        pvt->heap[i] = moved;
+        pvt->heap_pos[moved] = i;
+        heap_up(pvt, i);
+        heap_down(pvt, pvt->heap_pos[moved]);
+    }
+}
 
 
 static void update_interval_display(time_t time_interval)
 {
-    struct tm *time_now = gmtime(&time_interval);
+    struct tm count;
+
+    fmt_split(time_interval, &count);
+    display_set_time(&count, HOUR_UNIT | MINUTE_UNIT | SECOND_UNIT, true);
+}
+
+
+/* Show the current timer.
+*/
+static void show(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    Timer *t = &pvt->timers[pvt->current];
+    char title[sizeof(face->name) + 3];
+    time_t time_remaining;
+    struct tm time_count;
+
+    switch (t->state)
+    {
+    case STATE_RUN:
+        time_remaining = sec_left(t);
+        break;
+
+    case STATE_STOP:
+        /* Round up the same way a running countdown does.
+        */
+        time_remaining = t->when + (t->ms ? 1 : 0);
+        break;
+
+    case STATE_ALERT:
+        time_remaining = 0;
+        break;
+
+    default:
+        time_remaining = t->interval;
+        break;
+    }
+
+    strcpy(title, face->name);
+    fmt_int(title + strlen(title), pvt->current + 1);
+
+    fmt_split(time_remaining, &time_count);
+    display_set_time(&time_count, 0xff, 1);
+    display_set_title(title);
+    display_set_highlight(t->state == STATE_ALERT ? HL_DATE : HL_NONE);
+}
+
+
+/* The current timer only needs ticks to refresh the display while it runs
+* on screen. Expiry is caught by the wheel timer armed in arm_expiry().
+* Ringing is done by the alert engine, but a timer that was just silenced
+* needs one more tick to reset, whether or not it is on screen.
+*/
+static void update_ticks(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    bool clearing = false;
+    int i;
+
+    for (i = 0; i < TIMER_POOL_SIZE; i++)
+    {
+        clearing |= pvt->timers[i].state == STATE_CLEAR;
+    }
+
+    face->tick_units = (clearing || pvt->timers[pvt->current].state == STATE_RUN)
+                       ? SECOND_UNIT
+                       : 0;
+    face->tick_hidden = clearing;
+}
+
+
+static void alert(Face *face, int timer)
+{
+    Private *pvt = (Private *)face->data;
+
+    heap_del(pvt, timer);
+    pvt->timers[timer].state = STATE_ALERT;
+    if (pvt->visible)
+    {
+        /* Bring the one that is ringing on screen.
+        */
+        pvt->current = timer;
+        show(face);
+    }
+    vibe_ring_start(TIMER_VIBE_BASE + timer);
+    update_ticks(face);
+}
+
+
+static void arm_expiry(Face *face);
+static void save(Face *face);
+
+
+static void expire_handler(void *data)
+{
+    Face *face = data;
+    Private *pvt = (Private *)face->data;
+
+    /* If it woke up early, probably because the clock was changed, this
+    * just goes back to sleep for whatever is left.
+    */
+    while (pvt->heap_len && ms_left(&pvt->timers[pvt->heap[0]]) <= 0)
+    {
+        alert(face, pvt->heap[0]);
+    }
+
+    arm_expiry(face);
+    save(face);
+}
+
+
+/* Schedule the expiry of the running timer that is due soonest, or cancel
+* it if none are running. Timers sleep until then instead of checking
+* every second.
+*/
+static void arm_expiry(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->heap_len)
+    {
+        int32_t left = ms_left(&pvt->timers[pvt->heap[0]]);
 
-    display_set_time(time_now, HOUR_UNIT | MINUTE_UNIT | SECOND_UNIT, true);
+        wheel_schedule(&pvt->expiry, left > 0 ? left : 0, expire_handler, face);
+    }
+    else
+    {
+        wheel_cancel(&pvt->expiry);
+    }
 }
 
 
 static bool click_sel(Face *face)
 {
     Private *pvt = (Private *)face->data;
+    Timer *t = &pvt->timers[pvt->current];
+    bool checkpoint = true;
 
-    switch(pvt->state)
+    switch(t->state)
     {
     case STATE_START:
-        pvt->state = STATE_RUN;
-        pvt->time_now = time(NULL);
-        pvt->time_start = pvt->time_now;
-        pvt->time_end = pvt->time_start + pvt->time_interval;
-        pvt->time_left = pvt->time_interval;
+        t->state = STATE_RUN;
+        set_deadline(t, t->interval, 0);
+        heap_add(pvt, pvt->current);
         break;
 
     case STATE_RUN:
-        pvt->state = STATE_STOP;
-        pvt->time_left = pvt->time_left - (pvt->time_now - pvt->time_start);
+        {
+            int32_t left = ms_left(t);
+
+            if (left < 0)
+            {
+                left = 0;
+            }
+
+            t->state = STATE_STOP;
+            t->when = left / 1000;
+            t->ms = left % 1000;
+            heap_del(pvt, pvt->current);
+        }
         break;
 
     case STATE_STOP:
-        pvt->state = STATE_RUN;
-        pvt->time_start = pvt->time_now;
-        pvt->time_end = pvt->time_start + pvt->time_left;
+        t->state = STATE_RUN;
+        set_deadline(t, t->when, t->ms);
+        heap_add(pvt, pvt->current);
         break;
 
     case STATE_SET_HRS:
-        pvt->state = STATE_SET_SEC;
+        t->state = STATE_SET_SEC;
         display_set_highlight(HL_SECONDS);
+        checkpoint = false;
         break;
 
     case STATE_SET_MIN:
-        pvt->state = STATE_SET_HRS;
+        t->state = STATE_SET_HRS;
         display_set_highlight(HL_HOURS);
+        checkpoint = false;
         break;
 
     case STATE_SET_SEC:
-        pvt->state = STATE_SET_MIN;
+        t->state = STATE_SET_MIN;
         display_set_highlight(HL_MINUTES);
+        checkpoint = false;
         break;
 
     default:
         /* ignore */
+        checkpoint = false;
         break;
     }
 
+    arm_expiry(face);
+    update_ticks(face);
+    if (checkpoint)
+    {
+        /* Started or stopped, save the deadline in case the app dies.
+        */
+        save(face);
+    }
     return true;
 }
 
@@ -151,12 +485,13 @@ static bool click_sel(Face *face)
 static bool click_long_sel(Face *face)
 {
     Private *pvt = (Private *)face->data;
+    Timer *t = &pvt->timers[pvt->current];
 
-    switch(pvt->state)
+    switch(t->state)
     {
     case STATE_START:
-        pvt->state = STATE_SET_MIN;
-        update_interval_display(pvt->time_interval);
+        t->state = STATE_SET_MIN;
+        update_interval_display(t->interval);
         display_set_highlight(HL_MINUTES);
         break;
 
@@ -165,8 +500,19 @@ static bool click_long_sel(Face *face)
     case STATE_SET_MIN:
         /* fall thru */
     case STATE_SET_SEC:
-        pvt->state = STATE_START;
+        t->state = STATE_START;
         display_set_highlight(HL_NONE);
+        save(face);
+        break;
+
+    case STATE_RUN:
+    case STATE_STOP:
+        t->state = STATE_START;
+        heap_del(pvt, pvt->current);
+        update_interval_display(t->interval);
+        arm_expiry(face);
+        update_ticks(face);
+        save(face);
         break;
 
     default:
@@ -181,6 +527,7 @@ static bool click_long_sel(Face *face)
 static bool click_up(Face *face, uint8_t count)
 {
     Private *pvt = (Private *)face->data;
+    Timer *t = &pvt->timers[pvt->current];
     int n = 1;
 
     if (count > 10)
@@ -192,52 +539,52 @@ static bool click_up(Face *face, uint8_t count)
         n = 5;
     }
 
-    switch(pvt->state)
+    switch(t->state)
     {
     case STATE_SET_HRS:
-        while (n > 0 && pvt->time_interval > MAX_TIME - (3600 * n))
+        while (n > 0 && t->interval > MAX_TIME - (3600 * n))
         {
             n--;
         }
         if (n)
         {
-            pvt->time_interval += 3600 * n;
+            t->interval += 3600 * n;
         }
-        update_interval_display(pvt->time_interval);
+        update_interval_display(t->interval);
         break;
 
     case STATE_SET_MIN:
-        while (n > 0 && pvt->time_interval > MAX_TIME - (60 * n))
+        while (n > 0 && t->interval > MAX_TIME - (60 * n))
         {
             n--;
         }
         if (n)
         {
-            pvt->time_interval += 60 * n;
+            t->interval += 60 * n;
         }
-        update_interval_display(pvt->time_interval);
+        update_interval_display(t->interval);
         break;
 
     case STATE_SET_SEC:
-        while (n > 0 && pvt->time_interval > MAX_TIME - n)
+        while (n > 0 && t->interval > MAX_TIME - n)
         {
             n--;
         }
         if (n)
         {
-            pvt->time_interval += n;
+            t->interval += n;
         }
-        update_interval_display(pvt->time_interval);
-        break;
-
-    case STATE_RUN:
-    case STATE_STOP:
-        pvt->state = STATE_START;
-        update_interval_display(pvt->time_interval);
+        update_interval_display(t->interval);
         break;
 
     default:
-        return false;
+        if (++pvt->current >= TIMER_POOL_SIZE)
+        {
+            pvt->current = 0;
+        }
+        show(face);
+        update_ticks(face);
+        break;
     }
 
     return true;
@@ -247,6 +594,7 @@ static bool click_up(Face *face, uint8_t count)
 static bool click_dn(Face *face, uint8_t count)
 {
     Private *pvt = (Private *)face->data;
+    Timer *t = &pvt->timers[pvt->current];
     int n = 1;
 
     if (count > 10)
@@ -258,41 +606,41 @@ static bool click_dn(Face *face, uint8_t count)
         n = 5;
     }
 
-    switch(pvt->state)
+    switch(t->state)
     {
     case STATE_SET_HRS:
-        while (n > 0 && pvt->time_interval < (3600 * n))
+        while (n > 0 && t->interval < (3600 * n))
         {
             n--;
         }
         if (n)
         {
-            pvt->time_interval -= 3600 * n;
-            update_interval_display(pvt->time_interval);
+            t->interval -= 3600 * n;
+            update_interval_display(t->interval);
         }
         break;
 
     case STATE_SET_MIN:
-        while (n > 0 && pvt->time_interval < (60 * n))
+        while (n > 0 && t->interval < (60 * n))
         {
             n--;
         }
         if (n)
         {
-            pvt->time_interval -= 60 * n;
-            update_interval_display(pvt->time_interval);
+            t->interval -= 60 * n;
+            update_interval_display(t->interval);
         }
         break;
 
     case STATE_SET_SEC:
-        while (n > 0 && pvt->time_interval < n)
+        while (n > 0 && t->interval < n)
         {
             n--;
         }
         if (n)
         {
-            pvt->time_interval -= n;
-            update_interval_display(pvt->time_interval);
+            t->interval -= n;
+            update_interval_display(t->interval);
         }
         break;
 
@@ -307,91 +655,92 @@ static bool click_dn(Face *face, uint8_t count)
 static void update_handler(Face *face, struct tm *tt, TimeUnits uc)
 {
     Private *pvt = (Private *)face->data;
-    time_t time_remaining = pvt->time_end - pvt->time_now++;
-    struct tm *time_count = NULL;
+    int i;
 
-    switch(pvt->state)
+    for (i = 0; i < TIMER_POOL_SIZE; i++)
     {
-    case STATE_RUN:
-        if (time_remaining <= 0)
-        {
-            pvt->state = STATE_ALERT;
-            time_remaining = 0;
-            display_set_highlight(HL_DATE);
-            vibes_short_pulse();
-        }
-        time_count = gmtime(&time_remaining);
-        if (pvt->visible)
-        {
-            display_set_time(time_count,
-                             HOUR_UNIT | MINUTE_UNIT | SECOND_UNIT,
-                             true);
-        }
-        break;
-
-    case STATE_ALERT:
-        vibes_short_pulse();
-        break;
+        Timer *t = &pvt->timers[i];
 
-    case STATE_CLEAR:
-        pvt->state = STATE_START;
-        time_count = gmtime(&pvt->time_interval);
-        if (pvt->visible)
+        if (t->state == STATE_CLEAR)
         {
-            display_set_time(time_count,
-                             HOUR_UNIT | MINUTE_UNIT | SECOND_UNIT,
-                             true);
+            t->state = STATE_START;
+            if (pvt->visible && i == pvt->current)
+            {
+                update_interval_display(t->interval);
+            }
         }
-        break;
+    }
 
-    default:
-        /* ignore */
-        break;
+    if (pvt->visible && pvt->timers[pvt->current].state == STATE_RUN)
+    {
+        update_interval_display(sec_left(&pvt->timers[pvt->current]));
     }
+
+    update_ticks(face);
 }
 
 
-static void shut_up(Face *face)
+/* Silence the timers that are ringing with a vibe source in the mask. They
+* reset on the next tick, and are saved so they don't ring again on the
+* next launch.
+*/
+static void silence(Face *face, uint32_t sources)
 {
     Private *pvt = (Private *)face->data;
+    int i;
 
-    if (pvt->state == STATE_ALERT)
+    for (i = 0; i < TIMER_POOL_SIZE; i++)
     {
-        pvt->state = STATE_CLEAR;
-        display_set_highlight(HL_NONE);
+        if (pvt->timers[i].state == STATE_ALERT
+            && (sources & (1UL << (TIMER_VIBE_BASE + i))))
+        {
+            vibe_ring_stop(TIMER_VIBE_BASE + i);
+            pvt->timers[i].state = STATE_CLEAR;
+            if (pvt->visible && i == pvt->current)
+            {
+                display_set_highlight(HL_NONE);
+            }
+        }
     }
+
+    update_ticks(face);
+    save(face);
 }
 
 
-static void load_handler(Face *face)
+static void shut_up(Face *face)
 {
-    Private *pvt = (Private *)face->data;
-    time_t time_remaining = 0;
-    struct tm *time_count;
+    silence(face, TIMER_VIBE_SOURCES);
+}
 
-    switch (pvt->state)
-    {
-    case STATE_RUN:
-        time_remaining = pvt->time_end - pvt->time_now;
-        time_count = gmtime(&time_remaining);
-        break;
 
-    case STATE_STOP:
-        time_count = gmtime(&pvt->time_left);
-        break;
+/* The ringing gave up with nobody there to stop it.
+*/
+static void give_up_handler(uint32_t sources, void *data)
+{
+    silence((Face *)data, sources);
+}
 
-    case STATE_ALERT:
-        time_count = gmtime(&time_remaining);
-        break;
 
-    default:
-        time_count = gmtime(&pvt->time_interval);
-        break;
+static void load_handler(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    int i;
+
+    /* Start on a timer that is ringing, if there is one.
+    */
+    for (i = 0; i < TIMER_POOL_SIZE; i++)
+    {
+        if (pvt->timers[i].state == STATE_ALERT)
+        {
+            pvt->current = i;
+            break;
+        }
     }
 
     pvt->visible = true;
-    display_set_time(time_count, 0xff, 1);
-    display_set_title(face->name);
+    show(face);
+    update_ticks(face);
 }
 
 
@@ -404,57 +753,160 @@ static void unload_handler(Face *face)
 }
 
 
+/* Pick up the state of the two timers from back when each had its own
+* face and persist key. The old keys are deleted by the record module once
+* the timers are in the snapshot.
+*/
+static void migrate(Private *pvt)
+{
+    static const uint32_t old_keys[] =
+    {
+        PERSIST_KEY_TMR1_STATE,
+        PERSIST_KEY_TMR2_STATE,
+    };
+    OldPrivate old;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(old_keys) / sizeof(old_keys[0]); i++)
+    {
+        if (persist_get_size(old_keys[i]) == sizeof(OldPrivate))
+        {
+            Timer *t = &pvt->timers[i];
+
+            persist_read_data(old_keys[i], &old, sizeof(OldPrivate));
+            t->state = old.state;
+            t->interval = old.time_interval;
+            if (old.state == STATE_RUN)
+            {
+                t->when = old.time_end;
+            }
+            else if (old.state == STATE_STOP)
+            {
+                t->when = old.time_left;
+            }
+        }
+    }
+}
+
+
+/* Read back the persisted timers, from the record or, the first time after
+* an upgrade, from the old per-face keys.
+*/
+static void restore(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    if (record_read(face->key, RECORD_TAG_TIMERS, TIMER_VERSION,
+                    pvt->timers, sizeof(pvt->timers)) < 0
+        && record_legacy())
+    {
+        migrate(pvt);
+        save(face);
+    }
+}
+
+
+static void save(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+    static const Timer unused;
+    int n = TIMER_POOL_SIZE;
+
+    while (n > 0 && memcmp(&pvt->timers[n - 1], &unused, sizeof(Timer)) == 0)
+    {
+        n--;
+    }
+
+    record_write(face->key, RECORD_TAG_TIMERS, TIMER_VERSION,
+                 pvt->timers, n * sizeof(Timer));
+}
+
+
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
+* Create the timer face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *
-* @return  Pointer to the face, or NULL on error.
+* @return  Pointer to the face.
 *****************************************************************************/
 Face *timer_create(const char *name, uint32_t key)
 {
-    Face *face = malloc(sizeof(Face) + sizeof(Private));
+    Face *face = (Face *)storage;
+    Private *pvt = (Private *)face->data;
+    int i;
 
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    if (face)
+    memset(storage, 0, sizeof(storage));
+
+    face->load_handler = load_handler;
+    face->unload_handler = unload_handler;
+    face->update_handler = update_handler;
+
+    face->click_sel = click_sel;
+    face->click_long_sel = click_long_sel;
+    face->click_up = click_up;
+    face->click_dn = click_dn;
+    face->shut_up = shut_up;
+
+    strncpy(face->name, name, sizeof(face->name));
+    face->name[sizeof(face->name) - 1] = 0;
+    face->key = key;
+
+    restore(face);
+    wheel_timer_init(&pvt->expiry);
+    vibe_give_up_subscribe(TIMER_VIBE_SOURCES, give_up_handler, face);
+    memset(pvt->heap_pos, HEAP_NONE, sizeof(pvt->heap_pos));
+    for (i = 0; i < TIMER_POOL_SIZE; i++)
     {
-        memset(face, 0, sizeof(Face) + sizeof(Private));
+        if (pvt->timers[i].state == STATE_RUN)
+        {
+            heap_add(pvt, i);
+        }
+        else if (pvt->timers[i].state == STATE_ALERT)
+        {
+            vibe_ring_start(TIMER_VIBE_BASE + i);
+        }
+    }
 
-        face->load_handler = load_handler;
-        face->unload_handler = unload_handler;
-        face->update_handler = update_handler;
+    arm_expiry(face);
+    update_ticks(face);
 
-        face->click_sel = click_sel;
-        face->click_long_sel = click_long_sel;
-        face->click_up = click_up;
-        face->click_dn = click_dn;
-        face->shut_up = shut_up;
+    LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
+    return face;
+}
 
-        strncpy(face->name, name, sizeof(face->name));
-        face->name[sizeof(face->name) - 1] = 0;
-        face->key = key;
 
-        if (persist_get_size(face->key) == sizeof(Private))
-        {
-            Private *pvt = (Private *)face->data;
+/**
+* Check for a timer that is running or ringing.
+*****************************************************************************/
+bool timer_busy(uint32_t key)
+{
+    Timer timers[TIMER_POOL_SIZE];
+    int n = record_read(key, RECORD_TAG_TIMERS, TIMER_VERSION,
+                        timers, sizeof(timers));
+    int i;
 
-            persist_read_data(face->key, face->data, sizeof(Private));
-            pvt->time_now = time(NULL);
+    for (i = 0; i < n / (int)sizeof(Timer); i++)
+    {
+        if (timers[i].state == STATE_RUN || timers[i].state == STATE_ALERT)
+        {
+            return true;
         }
     }
 
-    LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
-    return face;
+    return false;
 }
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Destroy the timer face. Save its state and release resources.
 *****************************************************************************/
 void timer_destroy(Face *face)
 {
+    Private *pvt = (Private *)face->data;
+
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    persist_write_data(face->key, face->data, sizeof(Private));
-    free(face);
+    wheel_cancel(&pvt->expiry);
+    vibe_give_up_subscribe(TIMER_VIBE_SOURCES, NULL, NULL);
+    save(face);
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
 }
-
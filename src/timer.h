@@ -50,21 +50,33 @@
 
 
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
+* Create the timer face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *
 * @param  name  Name of the face.
 * @param  key   Storage key to use.
 *
-* @return  Pointer to the face, or NULL on error.
+* @return  Pointer to the face.
 *****************************************************************************/
 Face *timer_create(const char *name, uint32_t key);
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Destroy the timer face. Save its state and release resources.
 *****************************************************************************/
 void timer_destroy(Face *face);
 
 
+/**
+* Check the saved timers for one that is running or ringing. Its expiry is
+* on the timer wheel, so the face is created at startup for it to go off
+* while another face is showing.
+*
+* @param  key   Storage key the face uses.
+*
+* @return  true if the face must be created at startup.
+*****************************************************************************/
+bool timer_busy(uint32_t key);
+
+
 #endif  /* include guard */
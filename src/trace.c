@@ -0,0 +1,157 @@
+/****************************************************************************/
+/**
+* Event trace. Records compact binary events in a fixed ring in RAM.
+*
+* @file   trace.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "trace.h"
+#include "utils.h"
+
+#if TRACE
+
+
+#define TRACE_LINE_RECORDS      8       /* records per line of the dump */
+
+
+/* One event. Stored and dumped little endian, which is what the watch is,
+* so the decoder can unpack the dump as "<IBBh".
+*/
+typedef struct _TraceRecord
+{
+    uint32_t ms;                /* since trace_start() */
+    uint8_t event;
+    uint8_t a;
+    int16_t b;
+}
+TraceRecord;
+
+
+static TraceRecord trace_ring[TRACE_SIZE];
+static uint16_t trace_next;     /* where the next record goes */
+static bool trace_wrapped;      /* ring has been filled at least once */
+static TimeMS trace_zero;
+static int32_t trace_startup;   /* ms to the first frame drawn, -1 = none */
+
+
+/**
+* Empty the ring and set the time zero for the timestamps.
+*****************************************************************************/
+void trace_start(void)
+{
+    memset(trace_ring, 0, sizeof(trace_ring));
+    trace_next = 0;
+    trace_wrapped = false;
+    trace_startup = -1;
+    time_ms(&trace_zero.sec, &trace_zero.ms);
+}
+
+
+/**
+* Record one event, overwriting the oldest one if the ring is full.
+*****************************************************************************/
+void trace_event(TraceEvent event, uint8_t a, int16_t b)
+{
+    TraceRecord *r = &trace_ring[trace_next];
+    TimeMS now;
+
+    time_ms(&now.sec, &now.ms);
+    time_diff(&now, &now, &trace_zero);
+
+    r->ms = now.sec * 1000 + now.ms;
+    r->event = event;
+    r->a = a;
+    r->b = b;
+
+    /* Kept apart from the ring so it is still there after the ring wraps.
+    */
+    if (event == TRACE_FRAME && trace_startup < 0)
+    {
+        trace_startup = r->ms;
+    }
+
+    if (++trace_next >= TRACE_SIZE)
+    {
+        trace_next = 0;
+        trace_wrapped = true;
+    }
+}
+
+
+/**
+* Write the ring to the log, oldest first. The first line gives the wall
+* clock time of the zero timestamp and the ms from there to the first frame
+* drawn, the rest carry up to TRACE_LINE_RECORDS records each as hex bytes.
+*****************************************************************************/
+void trace_dump(void)
+{
+    static const char hex[] = "0123456789abcdef";
+    char line[8 + TRACE_LINE_RECORDS * sizeof(TraceRecord) * 2];
+    uint16_t count = trace_wrapped ? TRACE_SIZE : trace_next;
+    uint16_t i = trace_wrapped ? trace_next : 0;
+    char *s = NULL;
+    int n = 0;
+
+    app_log(APP_LOG_LEVEL_INFO,
+            __FILE__,
+            __LINE__,
+            "trace start=%lu.%03u startup=%ld count=%u",
+            (unsigned long)trace_zero.sec,
+            trace_zero.ms,
+            (long)trace_startup,
+            count);
+
+    while (count--)
+    {
+        const uint8_t *p = (const uint8_t *)&trace_ring[i];
+        size_t j;
+
+        if (n == 0)
+        {
+            strcpy(line, "trace ");
+            s = line + 6;
+        }
+
+        for (j = 0; j < sizeof(TraceRecord); j++)
+        {
+            *s++ = hex[p[j] >> 4];
+            *s++ = hex[p[j] & 0x0f];
+        }
+        *s = '\0';
+
+        if (++n == TRACE_LINE_RECORDS || count == 0)
+        {
+            app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "%s", line);
+            n = 0;
+        }
+
+        if (++i >= TRACE_SIZE)
+        {
+            i = 0;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+/****************************************************************************/
+/**
+* Event trace. Records compact binary events in a fixed ring in RAM so the
+* hot paths can be traced without the cost of formatting log messages. The
+* ring is dumped to the log as hex on exit, or when BACK is clicked three
+* times, and decoded on the host with tools/trace.py.
+*
+* @file   trace.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+
+#include <pebble.h>
+
+
+#ifndef TRACE
+#define TRACE   (false) /* true compiles in the trace, ~1K of RAM */
+#endif
+
+#define TRACE_SIZE      128     /* records in the ring, 8 bytes each */
+
+
+/* Event types. The arguments each one records are noted, and have to be
+* kept in sync with the decoder in tools/trace.py.
+*/
+typedef enum
+{
+    TRACE_NONE,
+    TRACE_TICK,                 /* a = units changed, b = ms late */
+    TRACE_CLICK,                /* a = button, b = click count */
+    TRACE_FACE_LOAD,            /* a = face index */
+    TRACE_FACE_UNLOAD,          /* a = face index */
+    TRACE_FIELD,                /* a = display field, b = new value */
+    TRACE_TIMER,                /* a = callbacks run, b = ms late, first */
+    TRACE_VIBE,                 /* a = sources, 0 = notify, b = ms on */
+    TRACE_PERSIST,              /* a = persist key, b = bytes written */
+    TRACE_FRAME,                /* b = ms to draw it */
+    TRACE_FACE_CREATE,          /* a = face index */
+    TRACE_NUM_EVENTS,
+}
+TraceEvent;
+
+
+#if !TRACE
+
+#define TRACE_EVENT(event, a, b)
+
+#define trace_start()
+#define trace_dump()
+
+#else
+
+/** Record one event.
+*/
+#define TRACE_EVENT(event, a, b)        trace_event((event), (a), (b))
+
+
+/**
+* Empty the ring and set the time zero for the timestamps.
+*****************************************************************************/
+void trace_start(void);
+
+
+/**
+* Record one event, overwriting the oldest one if the ring is full. Use the
+* TRACE_EVENT() macro rather than calling this directly.
+*
+* @param event  What happened.
+* @param a      First argument, meaning depends on the event.
+* @param b      Second argument, meaning depends on the event.
+*****************************************************************************/
+void trace_event(TraceEvent event, uint8_t a, int16_t b);
+
+
+/**
+* Write the ring to the log, oldest first, as "trace" lines of hex.
+*****************************************************************************/
+void trace_dump(void);
+
+#endif
+
+
+#endif  /* include guard */
@@ -0,0 +1,248 @@
+/****************************************************************************/
+/**
+* Alert engine. Merges all ringing sources into one vibration per period,
+* with escalation and an automatic silence.
+*
+* @file   vibe.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "perf.h"
+#include "trace.h"
+#include "utils.h"
+#include "vibe.h"
+#include "wheel.h"
+
+
+#define VIBE_MAX_PULSES     (3)     /* sources shown as separate pulses */
+
+#define PATTERN(segments)   { segments, sizeof(segments) / sizeof(uint32_t) }
+
+
+typedef struct _VibeOwner
+{
+    uint32_t sources;           /* 0 if the slot is free */
+    VibeGiveUpHandler handler;
+    void *data;
+}
+VibeOwner;
+
+typedef struct _Vibe
+{
+    uint32_t sources;           /* bit per source that is ringing */
+    uint8_t periods;            /* patterns played since the ring started */
+    WheelTimer timer;
+    VibeOwner owners[VIBE_MAX_OWNERS];
+}
+Vibe;
+
+
+/* On and off times in ms. One pulse per ringing source up to
+* VIBE_MAX_PULSES, short and light at first, then long.
+*/
+static const uint32_t gentle_1[] = { 60 };
+static const uint32_t gentle_2[] = { 60, 120, 60 };
+static const uint32_t gentle_3[] = { 60, 120, 60, 120, 60 };
+static const uint32_t strong_1[] = { 250 };
+static const uint32_t strong_2[] = { 250, 150, 250 };
+static const uint32_t strong_3[] = { 250, 150, 250, 150, 250 };
+static const uint32_t notify[] = { 100, 100, 100 };
+
+static const VibePattern ring_patterns[2][VIBE_MAX_PULSES] =
+{
+    { PATTERN(gentle_1), PATTERN(gentle_2), PATTERN(gentle_3) },
+    { PATTERN(strong_1), PATTERN(strong_2), PATTERN(strong_3) },
+};
+
+static const VibePattern notify_pattern = PATTERN(notify);
+
+static Vibe vibe;
+
+
+/* Start a pattern, and count the time the motor will be running.
+*/
+static void play(const VibePattern *pattern, uint8_t sources)
+{
+#if PERF || TRACE
+    uint32_t on_ms = 0;
+    uint32_t i;
+
+    for (i = 0; i < pattern->num_segments; i += 2)
+    {
+        on_ms += pattern->durations[i];
+    }
+
+    PERF_ADD(PERF_VIBE_MS, on_ms);
+    TRACE_EVENT(TRACE_VIBE, sources, on_ms);
+#endif
+
+    PERF_INC(PERF_VIBE);
+    vibes_enqueue_custom_pattern(*pattern);
+}
+
+
+static void ring(void *data)
+{
+    uint32_t bits = vibe.sources;
+    uint8_t count = 0;
+
+    while (bits)
+    {
+        count += bits & 1;
+        bits >>= 1;
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    /* Given up. Forget the sources, so a face that rings again later is
+    * heard and a notify isn't taken for ringing, then tell the owners so
+    * they stop showing an alert nobody answered.
+    */
+    if (vibe.periods >= VIBE_MAX_PERIODS)
+    {
+        uint32_t gone = vibe.sources;
+        int i;
+
+        vibe.sources = 0;
+        for (i = 0; i < VIBE_MAX_OWNERS; i++)
+        {
+            VibeOwner *o = &vibe.owners[i];
+
+            if (o->handler && (o->sources & gone))
+            {
+                o->handler(o->sources & gone, o->data);
+            }
+        }
+        return;
+    }
+
+    if (count > VIBE_MAX_PULSES)
+    {
+        count = VIBE_MAX_PULSES;
+    }
+
+    play(&ring_patterns[vibe.periods >= VIBE_GENTLE_PERIODS][count - 1], count);
+    vibe.periods++;
+
+    wheel_schedule(&vibe.timer, VIBE_PERIOD_MS, ring, NULL);
+}
+
+
+/**
+* Start ringing for a source.
+*****************************************************************************/
+void vibe_ring_start(uint8_t source)
+{
+    uint32_t bit = 1UL << (source & 31);
+
+    if (!(vibe.sources & bit))
+    {
+        /* Count from the first source only, so late joiners don't keep
+        * the ringing going past VIBE_MAX_PERIODS.
+        */
+        if (vibe.sources == 0)
+        {
+            vibe.periods = 0;
+        }
+        vibe.sources |= bit;
+
+        /* Start right away, unless a period is in progress. Then the new
+        * source joins in at the next one.
+        */
+        if (!wheel_pending(&vibe.timer))
+        {
+            ring(NULL);
+        }
+    }
+}
+
+
+/**
+* Stop ringing for a source.
+*****************************************************************************/
+void vibe_ring_stop(uint8_t source)
+{
+    uint32_t bit = 1UL << (source & 31);
+
+    if (vibe.sources & bit)
+    {
+        vibe.sources &= ~bit;
+        if (vibe.sources == 0)
+        {
+            wheel_cancel(&vibe.timer);
+            vibes_cancel();
+        }
+    }
+}
+
+
+/**
+* Ask to be told when the ringing gives up on any of a set of sources.
+*****************************************************************************/
+void vibe_give_up_subscribe(uint32_t sources, VibeGiveUpHandler handler,
+                            void *data)
+{
+    VibeOwner *slot = NULL;
+    int i;
+
+    for (i = 0; i < VIBE_MAX_OWNERS; i++)
+    {
+        VibeOwner *o = &vibe.owners[i];
+
+        if (o->sources == sources)
+        {
+            slot = o;
+            break;
+        }
+        if (o->sources == 0 && slot == NULL)
+        {
+            slot = o;
+        }
+    }
+
+    if (slot == NULL)
+    {
+        LOG_MSG_ERROR("No room for vibe owner %08lx", (unsigned long)sources);
+        return;
+    }
+
+    slot->sources = handler ? sources : 0;
+    slot->handler = handler;
+    slot->data = data;
+}
+
+
+/**
+* Buzz once to get attention, unless something is ringing.
+*****************************************************************************/
+void vibe_notify(void)
+{
+    if (vibe.sources == 0)
+    {
+        play(&notify_pattern, 0);
+    }
+}
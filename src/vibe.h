@@ -0,0 +1,99 @@
+/****************************************************************************/
+/**
+* Alert engine. Everything that wants to buzz goes through here so that
+* several alerts ringing at once come out as one vibration per period
+* instead of a pile of pulses queued on top of each other.
+*
+* @file   vibe.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef VIBE_H
+#define VIBE_H
+
+
+#include <pebble.h>
+
+
+#define VIBE_PERIOD_MS      (2000)  /* one pattern per period while ringing */
+#define VIBE_GENTLE_PERIODS (5)     /* periods before it gets insistent */
+#define VIBE_MAX_PERIODS    (30)    /* periods before it gives up */
+#define VIBE_MAX_OWNERS     (2)     /* handlers told when it gives up */
+
+
+/**
+* Called when the ringing gives up.
+*
+* @param sources Bit per source that was ringing, only those in the mask
+*                the handler was subscribed for.
+* @param data    The pointer given to vibe_give_up_subscribe().
+*****************************************************************************/
+typedef void (*VibeGiveUpHandler)(uint32_t sources, void *data);
+
+
+/**
+* Start ringing for a source. All sources that are ringing share one
+* pattern per period, with more pulses for more sources. The ringing starts
+* gentle, gets stronger after VIBE_GENTLE_PERIODS, and goes quiet after
+* VIBE_MAX_PERIODS, when every source is dropped so the next start rings
+* again. The periods count from when the ringing started, a source that
+* joins in later doesn't restart them. Starting a source that is already
+* ringing does nothing.
+*
+* @param source Any number 0-31 unique to the caller. Sources 8-15 are the
+*               alarms and 16-31 the timers.
+*****************************************************************************/
+void vibe_ring_start(uint8_t source);
+
+
+/**
+* Stop ringing for a source. When the last one stops so does the motor.
+*
+* @param source The number given to vibe_ring_start().
+*****************************************************************************/
+void vibe_ring_stop(uint8_t source);
+
+
+/**
+* Ask to be told when the ringing gives up on any of a set of sources, so
+* the owner can stop showing them as ringing and not start them again. Up
+* to VIBE_MAX_OWNERS masks can be subscribed, subscribing a mask again
+* replaces its handler and a NULL handler drops it.
+*
+* @param sources Bit per source the caller owns.
+* @param handler Function to call, or NULL.
+* @param data    Passed to the handler.
+*****************************************************************************/
+void vibe_give_up_subscribe(uint32_t sources, VibeGiveUpHandler handler,
+                            void *data);
+
+
+/**
+* Buzz once to get attention, like for a lost bluetooth connection. This
+* is dropped if something is ringing, the user is getting buzzed anyway.
+*****************************************************************************/
+void vibe_notify(void);
+
+
+#endif  /* include guard */
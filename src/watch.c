@@ -35,31 +35,26 @@
 * THE SOFTWARE.
 *
 *****************************************************************************/
+#include "caltime.h"
 #include "display.h"
+#include "fmt.h"
+#include "record.h"
 #include "utils.h"
 #include "watch.h"
 
 
+#define WATCH_VERSION   (1)     /* persisted record layout */
+
+
 typedef struct _Private
 {
-    union
-    {
-        struct
-        {
-            bool day_flag;              /* TRUE displays day instead of date */
-            bool visible;
-            int force_day_update;       /* Forces day/date update n seconds */
-
-            /* Always add more at the end */
-        };
-
-        /* Force this thing to always be the same size so upgrades don't
-        * screw up the persistence.
-        */
-        uint8_t reserved[128];
-    };
+    bool day_flag;              /* TRUE displays day instead of date */
+    bool visible;
+    int force_day_update;       /* Forces day/date update n seconds */
 } Private;
 
+FACE_STORAGE(storage, Private);
+
 
 static bool click_sel(Face *face)
 {
@@ -76,8 +71,7 @@ static bool click_sel(Face *face)
 static void load_handler(Face *face)
 {
     Private *pvt = (Private *)face->data;
-    time_t t = time(NULL);
-    struct tm *tick_time = localtime(&t);
+    struct tm *tick_time = caltime_now();
     TimeUnits units_changed = SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT | DAY_UNIT;
 
     /* Display the title for a moment before the next tick update
@@ -111,14 +105,14 @@ static void update_handler(Face *face, struct tm *tt, TimeUnits uc)
 
             if (pvt->day_flag)
             {
-                strftime(date_string, sizeof(date_string), "%a", tt);
+                fmt_day(date_string, tt);
             }
             else
             {
-                strftime(date_string, sizeof(date_string), "%b %d", tt);
+                fmt_date(date_string, tt);
             }
 
-            display_set_title(upcase(date_string));
+            display_set_title(date_string);
             pvt->force_day_update = -1;
         }
 
@@ -133,31 +127,40 @@ static void update_handler(Face *face, struct tm *tt, TimeUnits uc)
 
 
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
+* Create the watch face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *****************************************************************************/
 Face *watch_create(const char *name, uint32_t key)
 {
-    Face *face = malloc(sizeof(Face) + sizeof(Private));
+    Face *face = (Face *)storage;
+    Private *pvt = (Private *)face->data;
+    uint8_t day_flag = false;
 
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    if (face)
-    {
-        Private *pvt = (Private *)face->data;
+    memset(storage, 0, sizeof(storage));
 
-        memset(face, 0, sizeof(Face) + sizeof(Private));
+    face->load_handler = load_handler;
+    face->unload_handler = unload_handler;
+    face->update_handler = update_handler;
+    face->click_sel = click_sel;
 
-        face->load_handler = load_handler;
-        face->unload_handler = unload_handler;
-        face->update_handler = update_handler;
-        face->click_sel = click_sel;
+    face->tick_units = SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT | DAY_UNIT;
+    face->tick_hidden = false;
 
-        strncpy(face->name, name, sizeof(face->name));
-        face->name[sizeof(face->name) - 1] = 0;
-        face->key = key;
+    strncpy(face->name, name, sizeof(face->name));
+    face->name[sizeof(face->name) - 1] = 0;
+    face->key = key;
 
-        pvt->day_flag = persist_read_bool(face->key);
+    if (record_read(face->key, RECORD_TAG_WATCH, WATCH_VERSION,
+                    &day_flag, sizeof(day_flag)) < 0
+        && record_legacy()
+        && persist_exists(face->key))
+    {
+        day_flag = persist_read_bool(face->key);
+        record_write(face->key, RECORD_TAG_WATCH, WATCH_VERSION,
+                     &day_flag, sizeof(day_flag));
     }
+    pvt->day_flag = day_flag;
 
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
     return face;
@@ -165,15 +168,16 @@ Face *watch_create(const char *name, uint32_t key)
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Destroy the watch face. Save its state and release resources.
 *****************************************************************************/
 void watch_destroy(Face *face)
 {
     Private *pvt = (Private *)face->data;
+    uint8_t day_flag = pvt->day_flag;
 
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    persist_write_bool(face->key, pvt->day_flag);
-    free(face);
+    record_write(face->key, RECORD_TAG_WATCH, WATCH_VERSION,
+                 &day_flag, sizeof(day_flag));
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
 }
 
@@ -43,20 +43,20 @@
 
 
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
+* Create the watch face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *
 * @param  name  Name of the face.
 * @param  key   Storage key to use.
 *
 *
-* @return  Pointer to the face, or NULL on error.
+* @return  Pointer to the face.
 *****************************************************************************/
 Face *watch_create(const char *name, uint32_t key);
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Destroy the watch face. Save its state and release resources.
 *****************************************************************************/
 void watch_destroy(Face *face);
 
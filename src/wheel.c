@@ -0,0 +1,230 @@
+/****************************************************************************/
+/**
+* Software timers multiplexed onto a single AppTimer.
+*
+* The app only ever has a handful of timers pending, so they are kept in a
+* list sorted by deadline rather than in a real hashed or hierarchical
+* wheel. The AppTimer is armed for the soonest deadline, stretched to
+* cover any others within WHEEL_SLACK_MS of it.
+*
+* @file   wheel.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "perf.h"
+#include "trace.h"
+#include "wheel.h"
+
+
+static WheelTimer *wheel_head;  /* pending timers, soonest first */
+static AppTimer *wheel_timer;   /* the one AppTimer, NULL if not armed */
+static bool wheel_firing;       /* running callbacks, hold off re-arming */
+
+
+/* Milliseconds from a to b, negative if b is before a.
+*/
+static int32_t ms_between(const TimeMS *a, const TimeMS *b)
+{
+    return (b->sec - a->sec) * 1000 + (b->ms - a->ms);
+}
+
+
+static void wheel_fire(void *data);
+
+
+/* Arm the AppTimer for the soonest deadline, or cancel it if nothing is
+* pending. Deadlines within WHEEL_SLACK_MS after the soonest are served by
+* the same wakeup, which means waking a little later for the first one.
+*/
+static void wheel_arm(void)
+{
+    WheelTimer *t;
+    TimeMS now;
+    int32_t delay;
+
+    if (wheel_firing)
+    {
+        return;
+    }
+
+    if (wheel_head == NULL)
+    {
+        if (wheel_timer)
+        {
+            app_timer_cancel(wheel_timer);
+            wheel_timer = NULL;
+        }
+        return;
+    }
+
+    t = wheel_head;
+    while (t->next && ms_between(&wheel_head->due, &t->next->due) <= WHEEL_SLACK_MS)
+    {
+        t = t->next;
+    }
+
+    time_ms(&now.sec, &now.ms);
+    delay = ms_between(&now, &t->due);
+    if (delay < 0)
+    {
+        delay = 0;
+    }
+
+    if (wheel_timer == NULL || !app_timer_reschedule(wheel_timer, delay))
+    {
+        wheel_timer = app_timer_register(delay, wheel_fire, NULL);
+    }
+}
+
+
+/* Take a timer off the pending list.
+*/
+static void wheel_unlink(WheelTimer *timer)
+{
+    WheelTimer **p = &wheel_head;
+
+    while (*p && *p != timer)
+    {
+        p = &(*p)->next;
+    }
+
+    if (*p)
+    {
+        *p = timer->next;
+    }
+
+    timer->next = NULL;
+    timer->pending = false;
+}
+
+
+/* The AppTimer went off. Run everything that is due, then re-arm for
+* whatever is left.
+*/
+static void wheel_fire(void *data)
+{
+#if TRACE
+    int fired = 0;
+    int32_t first_late = 0;
+#endif
+    TimeMS now;
+
+    PERF_INC(PERF_WAKE_TIMER);
+    wheel_timer = NULL;
+    wheel_firing = true;
+
+    time_ms(&now.sec, &now.ms);
+    while (wheel_head && ms_between(&wheel_head->due, &now) >= 0)
+    {
+        WheelTimer *t = wheel_head;
+
+        PERF_LATE(PERF_LATE_TIMER, ms_between(&t->due, &now));
+#if TRACE
+        if (fired++ == 0)
+        {
+            first_late = ms_between(&t->due, &now);
+        }
+#endif
+
+        wheel_unlink(t);
+        t->callback(t->data);
+    }
+
+    TRACE_EVENT(TRACE_TIMER, fired, first_late);
+
+    wheel_firing = false;
+    wheel_arm();
+}
+
+
+/**
+* Initialize a timer so it can be used.
+*****************************************************************************/
+void wheel_timer_init(WheelTimer *timer)
+{
+    memset(timer, 0, sizeof(*timer));
+}
+
+
+/**
+* Schedule a callback, moving it if it is already pending.
+*****************************************************************************/
+void wheel_schedule(WheelTimer *timer,
+                    uint32_t ms,
+                    WheelCallback callback,
+                    void *data)
+{
+    WheelTimer **p = &wheel_head;
+
+    if (timer->pending)
+    {
+        wheel_unlink(timer);
+    }
+
+    time_ms(&timer->due.sec, &timer->due.ms);
+    timer->due.sec += ms / 1000;
+    timer->due.ms += ms % 1000;
+    if (timer->due.ms >= 1000)
+    {
+        timer->due.sec++;
+        timer->due.ms -= 1000;
+    }
+    timer->callback = callback;
+    timer->data = data;
+
+    /* After any with the same deadline, so they run in the order they
+    * were scheduled.
+    */
+    while (*p && ms_between(&(*p)->due, &timer->due) >= 0)
+    {
+        p = &(*p)->next;
+    }
+    timer->next = *p;
+    *p = timer;
+    timer->pending = true;
+
+    wheel_arm();
+}
+
+
+/**
+* Cancel a timer.
+*****************************************************************************/
+void wheel_cancel(WheelTimer *timer)
+{
+    if (timer->pending)
+    {
+        wheel_unlink(timer);
+        wheel_arm();
+    }
+}
+
+
+/**
+* Check if a timer is waiting to run.
+*****************************************************************************/
+bool wheel_pending(const WheelTimer *timer)
+{
+    return timer->pending;
+}
@@ -0,0 +1,105 @@
+/****************************************************************************/
+/**
+* Software timers multiplexed onto a single AppTimer. Faces schedule their
+* callbacks here instead of registering their own AppTimers, so deadlines
+* that fall close together are served by one wakeup.
+*
+* The caller owns the WheelTimer storage, nothing is allocated. A timer
+* can be cancelled or scheduled again at any time, including from inside
+* its own callback.
+*
+* @file   wheel.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef WHEEL_H
+#define WHEEL_H
+
+
+#include <pebble.h>
+#include "utils.h"
+
+
+#define WHEEL_SLACK_MS  (10)    /* deadlines this close share a wakeup */
+
+
+typedef void (*WheelCallback)(void *data);
+
+typedef struct _WheelTimer WheelTimer;
+
+struct _WheelTimer
+{
+    WheelTimer *next;           /* list of pending timers, soonest first */
+    TimeMS due;
+    WheelCallback callback;
+    void *data;
+    bool pending;
+};
+
+
+/**
+* Initialize a timer so it can be used. Must be done before the first
+* wheel_schedule() and whenever the storage may hold garbage, such as
+* after it was read back from persistent storage.
+*
+* @param timer  The timer.
+*****************************************************************************/
+void wheel_timer_init(WheelTimer *timer);
+
+
+/**
+* Schedule a callback. If the timer is already pending it is moved to the
+* new time. The callback never runs early, but may run up to
+* WHEEL_SLACK_MS late so it can share a wakeup with a later deadline.
+*
+* @param timer      The timer.
+* @param ms         How long from now to run the callback.
+* @param callback   What to call.
+* @param data       Passed to the callback.
+*****************************************************************************/
+void wheel_schedule(WheelTimer *timer,
+                    uint32_t ms,
+                    WheelCallback callback,
+                    void *data);
+
+
+/**
+* Cancel a timer. Does nothing if it is not pending.
+*
+* @param timer  The timer.
+*****************************************************************************/
+void wheel_cancel(WheelTimer *timer);
+
+
+/**
+* Check if a timer is waiting to run.
+*
+* @param timer  The timer.
+*
+* @return  true if the callback has yet to run.
+*****************************************************************************/
+bool wheel_pending(const WheelTimer *timer);
+
+
+#endif  /* include guard */
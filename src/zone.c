@@ -2,6 +2,27 @@
 /**
 * Definitions for a watch face that shows another time zone.
 *
+* The zones come from a rule table built by tools/mkzones.py and shipped as
+* a resource. Only the records for the zone on screen and the home zone are
+* loaded, 16 bytes each, and their UTC offsets are worked out once per DST
+* change rather than on every tick. The whole table is 4 bytes plus 16 per
+* zone, 388 bytes for the 24 zones it has now, where the full tz database
+* would not fit in the heap.
+*
+* The watch only knows local time. time() gives the phone's wall clock with
+* no zone attached, so UTC is worked out from the home zone, the one the
+* watch is in, which the user picks with L-SEL. Until then it is UTC, which
+* is only right for a watch that is set to UTC.
+*
+* Titles:
+*       NYC     Code of the zone on screen, then the day of the week there.
+*
+* Buttons:
+*       UP      Show the next zone.
+*       SEL     Show the previous zone.
+*       L-SEL   Make the zone on screen the home zone. Buzzes once.
+*       DN      Default action
+*
 * @file   zone.c
 *
 * @author Bob Hauck <bobh@haucks.org>
@@ -28,57 +49,398 @@
 *
 *****************************************************************************/
 #include "display.h"
+#include "fmt.h"
+#include "perf.h"
+#include "record.h"
+#include "trace.h"
 #include "utils.h"
+#include "vibe.h"
 #include "zone.h"
 
 
+#define ZONE_VERSION        (1)
+#define ZONE_STATE_VERSION  (1)     /* persisted record layout */
+#define ZONE_FOREVER        ((time_t)0x7fffffff)
+
+
+/* Layout of the table resource, see tools/mkzones.py.
+*/
+typedef struct _ZoneHeader
+{
+    char magic[2];              /* "TZ" */
+    uint8_t version;
+    uint8_t count;
+}
+ZoneHeader;
+
+typedef struct _ZoneRule
+{
+    uint8_t month;              /* 1-12, 0 = no DST */
+    uint8_t week_day;           /* week 1-5 (5 = last) << 4 | day of week */
+    int16_t at;                 /* minutes past local midnight */
+}
+ZoneRule;
+
+typedef struct _ZoneRecord
+{
+    char name[4];
+    int16_t std_offset;         /* minutes east of UTC */
+    int16_t dst_offset;
+    ZoneRule start;             /* change to dst_offset */
+    ZoneRule end;               /* change back to std_offset */
+}
+ZoneRecord;
+
+/* A zone loaded from the table, and its offset right now.
+*/
+typedef struct _Zone
+{
+    ZoneRecord rec;
+    int16_t offset;             /* minutes east of UTC right now */
+    time_t until;               /* when offset is next due to change */
+}
+Zone;
+
+/* Everything that is persisted, RECORD_TAG_ZONE.
+*/
+typedef struct _ZoneState
+{
+    uint8_t index;              /* zone on screen */
+    uint8_t home;               /* zone the watch is in */
+}
+ZoneState;
+
 typedef struct _Private
 {
-    int day_flag;               /* TRUE displays day instead of date */
-    int force_day_update;       /* Forces day/date update after seconds */
+    ResHandle table;
+    uint8_t count;              /* zones in the table */
+    ZoneState state;
+    Zone there;
+    Zone home;
+
+    int mday;                   /* day of the month in the title */
+    bool visible;
 } Private;
 
+FACE_STORAGE(storage, Private);
+
+_Static_assert(sizeof(ZoneState) <= RECORD_ZONE_SIZE,
+               "zone state doesn't fit its record");
+
+
+/* Days from 1970-01-01 to a date in the proleptic Gregorian calendar.
+*/
+static int32_t days_from_civil(int y, int m, int d)
+{
+    int32_t era;
+    int32_t yoe;
+    int32_t doy;
+
+    y -= m <= 2;
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+
+    return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+
+
+/* When a rule takes effect in a given year, in UTC. The offset is the one
+* in effect before the change, since that is what the rule's time is in.
+*/
+static time_t rule_time(const ZoneRule *r, int year, int16_t offset)
+{
+    int week = r->week_day >> 4;
+    int wday = r->week_day & 0x0f;
+    int32_t first = days_from_civil(year, r->month, 1);
+    int32_t next_month = r->month == 12 ? days_from_civil(year + 1, 1, 1)
+                                        : days_from_civil(year, r->month + 1, 1);
+    int32_t day;
+
+    /* 1970-01-01 was a Thursday.
+    */
+    day = first + (wday - (first + 4) % 7 + 7) % 7 + (week - 1) * 7;
+    while (day >= next_month)
+    {
+        day -= 7;
+    }
+
+    return (time_t)day * 86400 + (r->at - offset) * 60;
+}
+
+
+/* Work out the offset in effect at a time, and when it changes next. Looks
+* at the changes for the year before and after too so that the answer is
+* right near new year and for zones where DST spans it.
+*/
+static void offset_update(Zone *zone, time_t now)
+{
+    ZoneRecord *z = &zone->rec;
+    time_t local = now + z->std_offset * 60;
+    time_t last = 0;
+    int year;
+    int y;
+
+    zone->offset = z->std_offset;
+    zone->until = ZONE_FOREVER;
+    if (z->start.month == 0)
+    {
+        return;
+    }
+
+    year = gmtime(&local)->tm_year + 1900;
+    for (y = year - 1; y <= year + 1; y++)
+    {
+        time_t start = rule_time(&z->start, y, z->std_offset);
+        time_t end = rule_time(&z->end, y, z->dst_offset);
+
+        if (start <= now && start > last)
+        {
+            last = start;
+            zone->offset = z->dst_offset;
+        }
+        if (end <= now && end > last)
+        {
+            last = end;
+            zone->offset = z->std_offset;
+        }
+        if (start > now && start < zone->until)
+        {
+            zone->until = start;
+        }
+        if (end > now && end < zone->until)
+        {
+            zone->until = end;
+        }
+    }
+}
+
+
+/* Load the record for one zone out of the table.
+*/
+static void zone_load(Private *pvt, Zone *zone, int index)
+{
+    uint32_t offset;
+    size_t len;
+#if PERF
+    time_t s0, s1;
+    uint16_t ms0, ms1;
+
+    time_ms(&s0, &ms0);
+#endif
+
+    offset = sizeof(ZoneHeader) + index * sizeof(ZoneRecord);
+    len = resource_load_byte_range(pvt->table, offset,
+                                   (uint8_t *)&zone->rec, sizeof(ZoneRecord));
+    if (len != sizeof(ZoneRecord))
+    {
+        LOG_MSG_ERROR("Can't load zone %d", index);
+        memset(&zone->rec, 0, sizeof(ZoneRecord));
+        strcpy(zone->rec.name, "UTC");
+    }
+    zone->rec.name[sizeof(zone->rec.name) - 1] = 0;
+    zone->until = 0;
+
+#if PERF
+    time_ms(&s1, &ms1);
+    LOG_MSG_DEBUG("zone %s loaded in %d ms", zone->rec.name,
+                  (int)((s1 - s0) * 1000 + ms1 - ms0));
+#endif
+}
+
+
+/* Save the zone on screen and the home zone.
+*/
+static void save(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    record_write(face->key, RECORD_TAG_ZONE, ZONE_STATE_VERSION,
+                 &pvt->state, sizeof(ZoneState));
+}
+
+
+/* UTC now, from the watch's local time and the home zone's offset. Near a
+* DST change of the home zone the first guess, made with its standard
+* offset, can be on the wrong side, so it is worked out again from that.
+*/
+static time_t utc_now(Private *pvt)
+{
+    time_t local = time(NULL);
+    time_t now = local - pvt->home.offset * 60;
+
+    if (now >= pvt->home.until)
+    {
+        offset_update(&pvt->home, local - pvt->home.rec.std_offset * 60);
+        offset_update(&pvt->home, local - pvt->home.offset * 60);
+        now = local - pvt->home.offset * 60;
+    }
+
+    return now;
+}
+
+
+static void show(Face *face, TimeUnits units)
+{
+    Private *pvt = (Private *)face->data;
+    time_t now = utc_now(pvt);
+    time_t there;
+    struct tm *tt;
+
+    if (now >= pvt->there.until)
+    {
+        offset_update(&pvt->there, now);
+    }
+
+    there = now + pvt->there.offset * 60;
+    tt = gmtime(&there);
+
+    if (tt->tm_mday != pvt->mday)
+    {
+        char title[10];
+        char *s = title;
+
+        pvt->mday = tt->tm_mday;
+        strcpy(s, pvt->there.rec.name);
+        s += strlen(s);
+        *s++ = ' ';
+        fmt_day(s, tt);
+        display_set_title(title);
+    }
+
+    display_set_time(tt, units, 0);
+}
+
+
+static bool click_up(Face *face, uint8_t count)
+{
+    Private *pvt = (Private *)face->data;
+
+    pvt->state.index = pvt->state.index + 1 < pvt->count
+                       ? pvt->state.index + 1 : 0;
+    zone_load(pvt, &pvt->there, pvt->state.index);
+    pvt->mday = -1;
+    show(face, SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT);
+    return true;
+}
+
+
+static bool click_sel(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    pvt->state.index = pvt->state.index > 0
+                       ? pvt->state.index - 1 : pvt->count - 1;
+    zone_load(pvt, &pvt->there, pvt->state.index);
+    pvt->mday = -1;
+    show(face, SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT);
+    return true;
+}
+
+
+/* The watch is in the zone on screen, so its own clock is that zone's time.
+*/
+static bool click_long_sel(Face *face)
+{
+    Private *pvt = (Private *)face->data;
+
+    pvt->state.home = pvt->state.index;
+    pvt->home = pvt->there;
+    pvt->home.until = 0;
+    save(face);
+    vibe_notify();
+
+    pvt->mday = -1;
+    show(face, SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT);
+    return true;
+}
+
 
 static void load_handler(Face *face)
 {
-    time_t t = 0;
-    struct tm *zero = gmtime(&t);
+    Private *pvt = (Private *)face->data;
 
-    display_set_time(zero, 0xff, 0);
-    display_set_title("GMT");
+    pvt->visible = true;
+    pvt->mday = -1;
+    show(face, SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT);
 }
 
 
 static void unload_handler(Face *face)
 {
+    Private *pvt = (Private *)face->data;
+
+    pvt->visible = false;
     display_clear();
 }
 
 
 static void update_handler(Face *face, struct tm *tt, TimeUnits uc)
 {
+    Private *pvt = (Private *)face->data;
+
+    if (pvt->visible)
+    {
+        /* Zones with half hour offsets change the hour on a local minute.
+        */
+        show(face, (uc & MINUTE_UNIT) ? uc | HOUR_UNIT : uc);
+    }
 }
 
 
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
-*
-* @return  Pointer to the face, or NULL on error.
+* Create the zone face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *****************************************************************************/
-Face *zone_create(void)
+Face *zone_create(const char *name, uint32_t key)
 {
-    Face *face = malloc(sizeof(Face) + sizeof(Private));
+    Face *face = (Face *)storage;
+    Private *pvt = (Private *)face->data;
+    ZoneHeader header;
+    size_t len;
 
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    if (face)
+    memset(storage, 0, sizeof(storage));
+
+    face->load_handler = load_handler;
+    face->unload_handler = unload_handler;
+    face->update_handler = update_handler;
+    face->click_up = click_up;
+    face->click_sel = click_sel;
+    face->click_long_sel = click_long_sel;
+
+    face->tick_units = SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT | DAY_UNIT;
+    face->tick_hidden = false;
+
+    strncpy(face->name, name, sizeof(face->name));
+    face->name[sizeof(face->name) - 1] = 0;
+    face->key = key;
+
+    pvt->table = resource_get_handle(RESOURCE_ID_ZONE_TABLE);
+    len = resource_load_byte_range(pvt->table, 0, (uint8_t *)&header,
+                                   sizeof(header));
+    if (len == sizeof(header) && memcmp(header.magic, "TZ", 2) == 0
+        && header.version == ZONE_VERSION)
     {
-        memset(face, 0, sizeof(Face) + sizeof(Private));
+        pvt->count = header.count;
+    }
+    else
+    {
+        LOG_MSG_ERROR("Bad zone table");
+    }
 
-        face->load_handler = load_handler;
-        face->unload_handler = unload_handler;
-        face->update_handler = update_handler;
+    record_read(face->key, RECORD_TAG_ZONE, ZONE_STATE_VERSION,
+                &pvt->state, sizeof(ZoneState));
+    if (pvt->state.index >= pvt->count)
+    {
+        pvt->state.index = 0;
     }
+    if (pvt->state.home >= pvt->count)
+    {
+        pvt->state.home = 0;
+    }
+    zone_load(pvt, &pvt->there, pvt->state.index);
+    zone_load(pvt, &pvt->home, pvt->state.home);
 
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
     return face;
@@ -86,12 +448,11 @@ Face *zone_create(void)
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Destroy the zone face. Save its state and release resources.
 *****************************************************************************/
 void zone_destroy(Face *face)
 {
     LOG_MSG_DEBUG("Entering %s", __FUNCTION__);
-    free(face);
+    save(face);
     LOG_MSG_DEBUG("Exiting %s", __FUNCTION__);
 }
-
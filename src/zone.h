@@ -35,16 +35,19 @@
 
 
 /**
-* Create the watch face. Allocate memory and set up the data structures. Do
-* not draw anything until the load_handler() is called.
+* Create the zone face. Set up the data structures in static storage.
+* Do not draw anything until the load_handler() is called.
 *
-* @return  Pointer to the face, or NULL on error.
+* @param  name  Name of the face.
+* @param  key   Storage key to use.
+*
+* @return  Pointer to the face.
 *****************************************************************************/
-Face *zone_create(void);
+Face *zone_create(const char *name, uint32_t key);
 
 
 /**
-* Destroy the watch face. De-allocate memory and release resources.
+* Destroy the zone face. Save its state and release resources.
 *****************************************************************************/
 void zone_destroy(Face *face);
 
@@ -0,0 +1,266 @@
+/****************************************************************************/
+/**
+* What each face costs over a day. Runs the app on the virtual clock in a
+* few standard states and prints one line per state, with each count
+* scaled to 24 hours:
+*
+*       faces <state> hours=<n> wakeups=<n> updates=<n> set_text=<n>
+*             dirty=<n> frames=<n> pixels=<n> vibes=<n> frame_us=<n>
+*             draw_us=<n>
+*
+* all on one line. updates is the face update_handler() calls, and draw_us
+* the app's own PERF_DRAW_MS per watch layer redraw; both are left out when
+* PERF is off since only the app counts those. frame_us is the modelled
+* cost of each whole frame, see host_model_time(), which is on here so that
+* draw_us sees it too.
+*
+* Then one line for each face, in the order DOWN steps through them:
+*
+*       faces heap face=<name> bytes=<n> allocs=<n> layers=<n>
+*
+* bytes is the app heap in use while the face is on screen, allocs and
+* layers the heap blocks and layers taken to show it: at startup for the
+* first, on the DOWN that reaches it for the rest.
+*
+* Then, with PERF on, the app's PERF_STARTUP_MS for a start with nothing
+* running, the modelled flash time for persist calls and resources in it,
+* and whether faces were left to be created when first shown:
+*
+*       faces startup_ms=<n> flash_us=<n> resource_us=<n> lazy=<0|1>
+*
+* make bench LAZY_FACES=0 gives the same with every face created at startup.
+*
+* @file   bench_faces.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "test.h"
+#include "hud.h"
+#include "perf.h"
+
+
+#define HOUR_MS     (60 * 60 * 1000)
+
+
+static void clicks(ButtonId button, int n)
+{
+    while (n-- > 0)
+    {
+        host_click(button);
+    }
+}
+
+
+/* Run for some hours and print the counts for them, scaled to a day.
+*/
+static void measure(const char *state, int hours)
+{
+    static const HostCounter counted[] =
+    {
+        HOST_WAKE, HOST_SET_TEXT, HOST_MARK_DIRTY, HOST_FRAME, HOST_PIXELS,
+        HOST_VIBE,
+    };
+    static const char *names[] =
+    {
+        "wakeups", "set_text", "dirty", "frames", "pixels", "vibes",
+    };
+    uint32_t before[sizeof(counted) / sizeof(counted[0])];
+    uint32_t updates = perf_get(PERF_UPDATE);
+    uint32_t draw_ms = perf_get(PERF_DRAW_MS);
+    uint32_t draws = perf_get(PERF_FRAME);
+    uint32_t draw_us = host_count(HOST_DRAW_US);
+    uint32_t frames = host_count(HOST_FRAME);
+    unsigned int i;
+
+    for (i = 0; i < sizeof(counted) / sizeof(counted[0]); i++)
+    {
+        before[i] = host_count(counted[i]);
+    }
+
+    host_run(hours * HOUR_MS);
+
+    printf("faces %s hours=%d", state, hours);
+    for (i = 0; i < sizeof(counted) / sizeof(counted[0]); i++)
+    {
+        printf(" %s=%lu",
+               names[i],
+               (unsigned long)((uint64_t)(host_count(counted[i]) - before[i])
+                               * 24 / hours));
+        if (PERF && i == 0)
+        {
+            printf(" updates=%lu",
+                   (unsigned long)((uint64_t)(perf_get(PERF_UPDATE) - updates)
+                                   * 24 / hours));
+        }
+    }
+
+    frames = host_count(HOST_FRAME) - frames;
+    printf(" frame_us=%lu",
+           (unsigned long)(frames
+                           ? (host_count(HOST_DRAW_US) - draw_us) / frames
+                           : 0));
+    draws = perf_get(PERF_FRAME) - draws;
+    if (PERF)
+    {
+        printf(" draw_us=%lu",
+               (unsigned long)(draws
+                               ? (uint64_t)(perf_get(PERF_DRAW_MS) - draw_ms)
+                                 * 1000 / draws
+                               : 0));
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+
+/* Set the timer on screen to h:m:s.
+*/
+static void set_timer(int hours, int mins, int secs)
+{
+    host_hold(BUTTON_ID_SELECT);        /* minutes */
+    clicks(BUTTON_ID_UP, mins);
+    host_click(BUTTON_ID_SELECT);       /* hours */
+    clicks(BUTTON_ID_UP, hours);
+    host_click(BUTTON_ID_SELECT);       /* seconds */
+    clicks(BUTTON_ID_UP, secs);
+    host_hold(BUTTON_ID_SELECT);
+}
+
+
+static void idle_main(void *ctx)
+{
+    measure("idle_main", 24);
+}
+
+
+/* The longest a timer runs is just short of a day, so this one is measured
+* for 23 hours.
+*/
+static void hidden_timer(void *ctx)
+{
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    set_timer(23, 59, 59);
+    host_click(BUTTON_ID_SELECT);
+    clicks(BUTTON_ID_DOWN, HUD ? 5 : 4);        /* round to MAIN */
+    measure("hidden_timer", 23);
+}
+
+
+static void visible_stopwatch(void *ctx)
+{
+    clicks(BUTTON_ID_DOWN, 2);          /* STW */
+    host_click(BUTTON_ID_SELECT);
+    measure("visible_stopwatch", 24);
+}
+
+
+/* A timer goes off on screen and nobody stops it.
+*/
+static void alert_ringing(void *ctx)
+{
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    set_timer(0, 0, 10);
+    host_click(BUTTON_ID_SELECT);
+    measure("alert_ringing", 24);
+}
+
+
+/* Step through the faces and say what each holds on the heap.
+*/
+static void heap(void *ctx)
+{
+    static const char *names[] =
+    {
+        "main", "timer", "stopwatch", "alarm", "zone", "hud",
+    };
+    uint32_t allocs = 0;
+    uint32_t layers = 0;
+    int i;
+
+    for (i = 0; i < (HUD ? 6 : 5); i++)
+    {
+        if (i > 0)
+        {
+            allocs = host_count(HOST_HEAP_ALLOC);
+            layers = host_count(HOST_LAYER_CREATE);
+            host_click(BUTTON_ID_DOWN);
+        }
+        printf("faces heap face=%s bytes=%lu allocs=%lu layers=%lu\n",
+               names[i],
+               (unsigned long)heap_bytes_used(),
+               (unsigned long)(host_count(HOST_HEAP_ALLOC) - allocs),
+               (unsigned long)(host_count(HOST_LAYER_CREATE) - layers));
+    }
+    fflush(stdout);
+}
+
+
+static void startup(void *ctx)
+{
+#if PERF
+    printf("faces startup_ms=%lu flash_us=%lu resource_us=%lu lazy=%d\n",
+           (unsigned long)perf_get(PERF_STARTUP_MS),
+           (unsigned long)host_count(HOST_FLASH_US),
+           (unsigned long)host_count(HOST_RESOURCE_US),
+           LAZY_FACES ? 1 : 0);
+    fflush(stdout);
+#endif
+}
+
+
+int main(void)
+{
+    static const HostScript states[] =
+    {
+        idle_main, hidden_timer, visible_stopwatch, alert_ringing, heap,
+    };
+    unsigned int i;
+
+    for (i = 0; i < sizeof(states) / sizeof(states[0]); i++)
+    {
+        host_reset(TEST_EPOCH);
+        host_model_time(true);
+        if (host_launch(APP_LAUNCH_USER, states[i], NULL) != HOST_EXIT)
+        {
+            return 1;
+        }
+    }
+
+    /* The first start has no snapshot yet and creates every face to move
+    * the old keys into it, so it is the second start that is timed.
+    */
+    host_reset(TEST_EPOCH);
+    host_model_time(true);
+    if (host_launch(APP_LAUNCH_USER, NULL, NULL) != HOST_EXIT)
+    {
+        return 1;
+    }
+    host_count_clear();
+    if (host_launch(APP_LAUNCH_USER, startup, NULL) != HOST_EXIT)
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+/****************************************************************************/
+/**
+* Formatting microbenchmark. Times each fmt routine against the libc path
+* it replaced, on the host, and prints one line per routine:
+*
+*       fmt <routine> libc_ns=<n> fmt_ns=<n>
+*
+* The numbers are ns per call on the build machine, not the watch, so only
+* the ratio between them means much.
+*
+* @file   bench_fmt.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <ctype.h>
+#include <string.h>
+#include "test.h"
+#include "fmt.h"
+
+
+#define CALLS       (2000000)
+
+
+typedef enum
+{
+    FIELD,
+    DATE,
+    DAY_NAME,
+    SPLIT,
+    UINT,
+    NUM_ROUTINES
+}
+Routine;
+
+static const char *routine_names[NUM_ROUTINES] =
+{
+    "2d", "date", "day", "split", "uint",
+};
+
+static volatile char sink;
+
+
+static void upcase(char *s)
+{
+    for (; *s; s++)
+    {
+        *s = toupper((unsigned char)*s);
+    }
+}
+
+
+/* Numbers of every length for the uint case.
+*/
+static uint32_t scramble(uint32_t i)
+{
+    return (uint32_t)(i * 2654435761UL) >> (i % 32);
+}
+
+
+/* The way the app did it before fmt.c.
+*/
+static void old_way(Routine r, uint32_t i, const struct tm *tm)
+{
+    char buf[16];
+    time_t t = i % (24 * 60 * 60);
+
+    switch (r)
+    {
+    case FIELD:
+        snprintf(buf, sizeof(buf), "%02d", (int)(i % 100));
+        break;
+
+    case DATE:
+        strftime(buf, sizeof(buf), "%b %d", tm);
+        upcase(buf);
+        break;
+
+    case DAY_NAME:
+        strftime(buf, sizeof(buf), "%a", tm);
+        upcase(buf);
+        break;
+
+    case SPLIT:
+        buf[0] = gmtime(&t)->tm_sec;
+        break;
+
+    default:
+        snprintf(buf, sizeof(buf), "%lu", (unsigned long)scramble(i));
+        break;
+    }
+
+    sink = buf[0];
+}
+
+
+static void new_way(Routine r, uint32_t i, const struct tm *tm)
+{
+    char buf[16];
+    struct tm split;
+
+    switch (r)
+    {
+    case FIELD:
+        fmt_2d(buf, i % 100);
+        break;
+
+    case DATE:
+        fmt_date(buf, tm);
+        break;
+
+    case DAY_NAME:
+        fmt_day(buf, tm);
+        break;
+
+    case SPLIT:
+        fmt_split(i % (24 * 60 * 60), &split);
+        buf[0] = split.tm_sec;
+        break;
+
+    default:
+        fmt_uint(buf, scramble(i));
+        break;
+    }
+
+    sink = buf[0];
+}
+
+
+static double ns_per_call(void (*way)(Routine, uint32_t, const struct tm *),
+                          Routine r)
+{
+    struct tm tm;
+    clock_t start;
+    uint32_t i;
+
+    memset(&tm, 0, sizeof(tm));
+    start = clock();
+    for (i = 0; i < CALLS; i++)
+    {
+        tm.tm_mon = i % 12;
+        tm.tm_mday = 1 + i % 28;
+        tm.tm_wday = i % 7;
+        way(r, i, &tm);
+    }
+
+    return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / CALLS;
+}
+
+
+int main(void)
+{
+    int r;
+
+    for (r = 0; r < NUM_ROUTINES; r++)
+    {
+        printf("fmt %s libc_ns=%.1f fmt_ns=%.1f\n",
+               routine_names[r],
+               ns_per_call(old_way, r),
+               ns_per_call(new_way, r));
+    }
+
+    return 0;
+}
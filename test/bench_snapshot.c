@@ -0,0 +1,284 @@
+/****************************************************************************/
+/**
+* Persistent storage benchmark. Compares the snapshot the app keeps now with
+* the one blob per face it wrote before, and prints one line for each:
+*
+*       snapshot <scheme> startup_reads=<n> exit_writes=<n> exit_bytes=<n>
+*                startup_ms=<n> exit_ms=<n>
+*
+* all on one line, then what the snapshot saves:
+*
+*       snapshot saved startup_ms=<n> exit_ms=<n>
+*
+* The counts are flash calls for one start and one exit with a timer and
+* the stopwatch running. The times are the stand-in's modelled flash cost
+* of those calls on the watch, see host_model_time().
+*
+* @file   bench_snapshot.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <string.h>
+#include "test.h"
+#include "resources.h"
+#include "utils.h"
+
+
+/* Flash calls for one start and one exit, and their modelled time.
+*/
+typedef struct _Counts
+{
+    uint32_t startup_reads;
+    uint32_t exit_writes;
+    uint32_t exit_bytes;
+    uint32_t startup_us;
+    uint32_t exit_us;
+}
+Counts;
+
+/* The state the baseline persisted, as it laid it out. The faces' Private
+* was padded to 128 bytes, then written whole.
+*/
+typedef struct _OldActive
+{
+    int face;
+    int invert_mode;
+}
+OldActive;
+
+typedef struct _OldTimer
+{
+    union
+    {
+        struct
+        {
+            int state;
+            void *timer_handle;
+            time_t time_start;
+            time_t time_interval;
+            time_t time_left;
+            time_t time_end;
+            time_t time_now;
+            bool visible;
+        };
+        uint8_t reserved[128];
+    };
+}
+OldTimer;
+
+typedef struct _OldStopwatch
+{
+    union
+    {
+        struct
+        {
+            int state;
+            void *timer;
+            TimeMS start_time;
+            TimeMS last_time;
+            TimeMS split_time;
+            TimeMS lap_time;
+            bool visible;
+            TimeMS stop_time;
+        };
+        uint8_t reserved[128];
+    };
+}
+OldStopwatch;
+
+/* What the app kept before records: each face's state under its own key,
+* checked for size and read on every start, and written on every exit
+* whether it had changed or not.
+*/
+static const struct
+{
+    uint32_t key;
+    size_t size;
+}
+old_blobs[] =
+{
+    { PERSIST_KEY_MAIN_STATE, sizeof(OldActive) },
+    { PERSIST_KEY_WATCH_STATE, sizeof(bool) },
+    { PERSIST_KEY_STW_STATE, sizeof(OldStopwatch) },
+    { PERSIST_KEY_TMR1_STATE, sizeof(OldTimer) },
+    { PERSIST_KEY_TMR2_STATE, sizeof(OldTimer) },
+};
+
+#define OLD_BLOBS   (sizeof(old_blobs) / sizeof(old_blobs[0]))
+
+static uint8_t old_state[OLD_BLOBS][sizeof(OldStopwatch)];
+
+_Static_assert(sizeof(OldTimer) <= sizeof(OldStopwatch), "old_state too small");
+
+
+static void old_load(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < OLD_BLOBS; i++)
+    {
+        if (persist_get_size(old_blobs[i].key) == (int)old_blobs[i].size)
+        {
+            persist_read_data(old_blobs[i].key, old_state[i], old_blobs[i].size);
+        }
+    }
+}
+
+
+static void old_save(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < OLD_BLOBS; i++)
+    {
+        persist_write_data(old_blobs[i].key, old_state[i], old_blobs[i].size);
+    }
+}
+
+
+static void print(const char *scheme, const Counts *counts)
+{
+    printf("snapshot %s startup_reads=%lu exit_writes=%lu exit_bytes=%lu"
+           " startup_ms=%.1f exit_ms=%.1f\n",
+           scheme,
+           (unsigned long)counts->startup_reads,
+           (unsigned long)counts->exit_writes,
+           (unsigned long)counts->exit_bytes,
+           counts->startup_us / 1000.0,
+           counts->exit_us / 1000.0);
+    fflush(stdout);
+}
+
+
+/* Start TMR1 for an hour and the stopwatch.
+*/
+static void busy(void *ctx)
+{
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    host_hold(BUTTON_ID_SELECT);        /* minutes */
+    host_click(BUTTON_ID_SELECT);       /* hours */
+    host_click(BUTTON_ID_UP);
+    host_hold(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_DOWN);         /* STW */
+    host_click(BUTTON_ID_SELECT);
+}
+
+
+static void crash(void *ctx)
+{
+    host_kill();
+}
+
+
+/* The old scheme done by hand, counted the same way, then compared with
+* the records' counts.
+*/
+static void per_key(void *ctx)
+{
+    const Counts *records = ctx;
+    Counts counts;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t bytes;
+    uint32_t us;
+
+    old_save();
+
+    reads = host_count(HOST_PERSIST_READ);
+    us = host_count(HOST_FLASH_US);
+    old_load();
+    counts.startup_reads = host_count(HOST_PERSIST_READ) - reads;
+    counts.startup_us = host_count(HOST_FLASH_US) - us;
+
+    writes = host_count(HOST_PERSIST_WRITE);
+    bytes = host_count(HOST_PERSIST_BYTES);
+    us = host_count(HOST_FLASH_US);
+    old_save();
+    counts.exit_writes = host_count(HOST_PERSIST_WRITE) - writes;
+    counts.exit_bytes = host_count(HOST_PERSIST_BYTES) - bytes;
+    counts.exit_us = host_count(HOST_FLASH_US) - us;
+
+    print("per_key", &counts);
+    printf("snapshot saved startup_ms=%.1f exit_ms=%.1f\n",
+           ((int32_t)counts.startup_us - (int32_t)records->startup_us) / 1000.0,
+           ((int32_t)counts.exit_us - (int32_t)records->exit_us) / 1000.0);
+    fflush(stdout);
+}
+
+
+int main(void)
+{
+    Counts counts;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t bytes;
+    uint32_t us;
+    uint32_t start_writes;
+    uint32_t start_bytes;
+    uint32_t start_us;
+
+    host_reset(TEST_EPOCH);
+    if (host_launch(APP_LAUNCH_USER, busy, NULL) != HOST_EXIT)
+    {
+        return 1;
+    }
+
+    /* A start on its own is a launch killed as soon as it is up, and the
+    * exit is what a whole launch does on top of that.
+    */
+    reads = host_count(HOST_PERSIST_READ);
+    writes = host_count(HOST_PERSIST_WRITE);
+    bytes = host_count(HOST_PERSIST_BYTES);
+    us = host_count(HOST_FLASH_US);
+    if (host_launch(APP_LAUNCH_USER, crash, NULL) != HOST_KILLED)
+    {
+        return 1;
+    }
+    counts.startup_reads = host_count(HOST_PERSIST_READ) - reads;
+    counts.startup_us = host_count(HOST_FLASH_US) - us;
+    start_writes = host_count(HOST_PERSIST_WRITE) - writes;
+    start_bytes = host_count(HOST_PERSIST_BYTES) - bytes;
+    start_us = counts.startup_us;
+
+    writes = host_count(HOST_PERSIST_WRITE);
+    bytes = host_count(HOST_PERSIST_BYTES);
+    us = host_count(HOST_FLASH_US);
+    if (host_launch(APP_LAUNCH_USER, NULL, NULL) != HOST_EXIT)
+    {
+        return 1;
+    }
+    counts.exit_writes = host_count(HOST_PERSIST_WRITE) - writes - start_writes;
+    counts.exit_bytes = host_count(HOST_PERSIST_BYTES) - bytes - start_bytes;
+    counts.exit_us = host_count(HOST_FLASH_US) - us - start_us;
+    print("records", &counts);
+
+    host_reset(TEST_EPOCH);
+    if (host_launch(APP_LAUNCH_USER, per_key, &counts) != HOST_EXIT)
+    {
+        return 1;
+    }
+
+    return 0;
+}
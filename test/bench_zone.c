@@ -0,0 +1,103 @@
+/****************************************************************************/
+/**
+* Zone face benchmark. Steps the zone face through every zone in the table
+* with UP, which loads each zone's record from the resource and works out
+* its offset with offset_update(), and prints one line:
+*
+*       zone table_bytes=<n> zones=<n> load_us=<n> click_us=<n> host_ns=<n>
+*
+* all on one line. load_us is the modelled flash time to load one zone's
+* record, and click_us all the modelled time for one click, the redraw
+* included, see host_model_time(). host_ns is the host CPU time for one
+* click, which is the only place offset_update() shows, since the model
+* charges nothing for plain code; it includes the stand-in's redraw, so
+* it is for comparing one build with another.
+*
+* @file   bench_zone.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "test.h"
+
+
+#define ROUNDS      (100)       /* times round the whole table */
+
+
+static void step(void *ctx)
+{
+    ResHandle table = resource_get_handle(RESOURCE_ID_ZONE_TABLE);
+    uint8_t header[4];
+    uint32_t resource_us;
+    uint32_t modelled_us;
+    uint32_t clicks;
+    clock_t start;
+    int zones;
+    int i;
+
+    /* The table starts "TZ", version, zone count.
+    */
+    resource_load_byte_range(table, 0, header, sizeof(header));
+    zones = header[3];
+    clicks = ROUNDS * zones;
+
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    host_click(BUTTON_ID_DOWN);         /* STW */
+    host_click(BUTTON_ID_DOWN);         /* ALM */
+    host_click(BUTTON_ID_DOWN);         /* ZONE */
+
+    resource_us = host_count(HOST_RESOURCE_US);
+    modelled_us = host_count(HOST_DRAW_US) + host_count(HOST_FLASH_US)
+                  + host_count(HOST_RESOURCE_US);
+    start = clock();
+    for (i = 0; i < (int)clicks; i++)
+    {
+        host_click(BUTTON_ID_UP);
+    }
+
+    printf("zone table_bytes=%lu zones=%d load_us=%lu click_us=%lu"
+           " host_ns=%.0f\n",
+           (unsigned long)resource_size(table),
+           zones,
+           (unsigned long)((host_count(HOST_RESOURCE_US) - resource_us)
+                           / clicks),
+           (unsigned long)((host_count(HOST_DRAW_US)
+                            + host_count(HOST_FLASH_US)
+                            + host_count(HOST_RESOURCE_US) - modelled_us)
+                           / clicks),
+           (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / clicks);
+    fflush(stdout);
+}
+
+
+int main(void)
+{
+    host_reset(TEST_EPOCH);
+    host_model_time(true);
+    if (host_launch(APP_LAUNCH_USER, step, NULL) != HOST_EXIT)
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/****************************************************************************/
+/**
+* Checks for the host tests. A failed check inside a launch ends that launch
+* with HOST_FAILED; outside one it is counted and the test carries on. Each
+* test's main() ends with TEST_DONE().
+*
+* @file   test.h
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#ifndef TEST_H
+#define TEST_H
+
+
+#include "host.h"
+
+
+#define CHECK(cond)                                                         \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            host_fail(__FILE__, __LINE__, #cond);                           \
+        }                                                                   \
+    } while (0)
+
+/* Integer comparison that shows both sides when it fails.
+*/
+#define CHECK_EQ(a, b)                                                      \
+    do                                                                      \
+    {                                                                       \
+        long long a_ = (a);                                                 \
+        long long b_ = (b);                                                 \
+                                                                            \
+        if (a_ != b_)                                                       \
+        {                                                                   \
+            char m_[160];                                                   \
+                                                                            \
+            snprintf(m_, sizeof(m_), "%s == %s (%lld != %lld)",             \
+                     #a, #b, a_, b_);                                       \
+            host_fail(__FILE__, __LINE__, m_);                              \
+        }                                                                   \
+    } while (0)
+
+#define TEST_DONE()                                                         \
+    do                                                                      \
+    {                                                                       \
+        printf("%s: %s\n", __FILE__, host_failures() ? "FAIL" : "ok");      \
+        return host_failures() ? 1 : 0;                                     \
+    } while (0)
+
+/* 2014-06-02 08:00:00, a Monday.
+*/
+#define TEST_EPOCH  ((time_t)1401696000)
+
+
+#endif  /* include guard */
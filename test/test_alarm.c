@@ -0,0 +1,248 @@
+/****************************************************************************/
+/**
+* Alarm face tests. Two alarms set for the same minute both ring and both
+* get a new wakeup, a daylight saving change in either direction rings the
+* alarm once at the right wall clock time, and a wakeup missed with the
+* watch off is rescheduled without ringing late.
+*
+* @file   test_alarm.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "test.h"
+#include "vibe.h"
+
+
+#define DAY         (24 * 60 * 60)
+#define HOUR        (60 * 60)
+#define MINUTE      (60)
+
+/* 07:30 on the day after TEST_EPOCH, and every day after that.
+*/
+#define ALARM_AT(day)   (TEST_EPOCH + (day) * DAY - 30 * MINUTE)
+
+
+/* The one wakeup the app should have, or 0 if it has none or several.
+*/
+static time_t wakeup(void)
+{
+    time_t times[8];
+
+    return host_wakeups(times, 8) == 1 ? times[0] : 0;
+}
+
+
+/* Set the alarm on screen to hour:min, every day.
+*/
+static void set_daily(int hour, int min)
+{
+    int i;
+
+    host_hold(BUTTON_ID_SELECT);
+    for (i = 0; i < hour; i++)
+    {
+        host_click(BUTTON_ID_UP);
+    }
+    host_click(BUTTON_ID_SELECT);
+    for (i = 0; i < min; i++)
+    {
+        host_click(BUTTON_ID_UP);
+    }
+    host_hold(BUTTON_ID_SELECT);        /* ONCE */
+    host_click(BUTTON_ID_SELECT);       /* DAILY */
+}
+
+
+/* From the main face, set alarms 1 and 2 for the same minute.
+*/
+static void set_two(void *ctx)
+{
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    host_click(BUTTON_ID_DOWN);         /* STW */
+    host_click(BUTTON_ID_DOWN);         /* ALM */
+
+    set_daily(7, 30);
+    CHECK_EQ(wakeup(), ALARM_AT(1));
+
+    host_click(BUTTON_ID_UP);
+    set_daily(7, 30);
+    CHECK_EQ(wakeup(), ALARM_AT(1));
+}
+
+
+/* Both alarms ring. Snoozing snoozes both, and each then has its next day
+* scheduled, rather than one being left behind in the past.
+*/
+static void ring_and_snooze(void *ctx)
+{
+    time_t *next = (time_t *)ctx;
+
+    CHECK(host_vibing());
+    CHECK_EQ(wakeup(), *next);
+
+    host_click(BUTTON_ID_SELECT);
+    CHECK(!host_vibing());
+    CHECK_EQ(wakeup(), host_now_ms() / 1000 + 5 * MINUTE);
+}
+
+
+/* The same with the app open when they go off.
+*/
+static void ring_open(void *ctx)
+{
+    time_t next = ALARM_AT(2);
+
+    host_run(ALARM_AT(1) * 1000 - host_now_ms());
+    ring_and_snooze(&next);
+
+    host_run(5 * MINUTE * 1000);
+    CHECK(host_vibing());
+    CHECK_EQ(wakeup(), ALARM_AT(2));
+    host_click(BUTTON_ID_BACK);
+}
+
+
+static void ring_and_stop(void *ctx)
+{
+    time_t *next = (time_t *)ctx;
+
+    CHECK(host_vibing());
+    CHECK_EQ(wakeup(), *next);
+
+    host_click(BUTTON_ID_BACK);
+    CHECK(!host_vibing());
+}
+
+
+static void quiet(void *ctx)
+{
+    time_t *next = (time_t *)ctx;
+
+    CHECK(!host_vibing());
+    CHECK_EQ(wakeup(), *next);
+}
+
+
+/* Both alarms ring with the app open and nobody stops them. Once the
+* ringing gives up they aren't ringing any more, so SELECT doesn't snooze
+* them, and the next day is still scheduled.
+*/
+static void ring_ignored(void *ctx)
+{
+    uint32_t vibes;
+
+    host_run(ALARM_AT(1) * 1000 - host_now_ms());
+    CHECK(host_vibing());
+
+    host_run(VIBE_MAX_PERIODS * VIBE_PERIOD_MS);
+    CHECK(!host_vibing());
+    vibes = host_count(HOST_VIBE);
+    host_run(MINUTE * 1000);
+    CHECK_EQ(host_count(HOST_VIBE), vibes);
+    CHECK_EQ(wakeup(), ALARM_AT(2));
+
+    host_click(BUTTON_ID_SELECT);
+    CHECK(wakeup() != host_now_ms() / 1000 + 5 * MINUTE);
+}
+
+
+/* Start setting alarm 3 and leave the app part way through. What was set
+* is taken as it stands.
+*/
+static void leave_setting(void *ctx)
+{
+    host_click(BUTTON_ID_UP);
+    host_click(BUTTON_ID_UP);
+    host_hold(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_UP);
+    host_click(BUTTON_ID_UP);
+}
+
+
+int main(void)
+{
+    time_t next;
+    time_t now;
+    uint32_t vibes;
+
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, set_two, NULL), HOST_EXIT);
+
+    /* Both due at once, with the app open, then from one wakeup.
+    */
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, ring_open, NULL), HOST_EXIT);
+
+    CHECK(host_sleep(DAY * 1000));
+    CHECK_EQ(host_now_ms(), (int64_t)ALARM_AT(2) * 1000);
+    next = ALARM_AT(3);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, ring_and_snooze, &next), HOST_EXIT);
+
+    CHECK(host_sleep(DAY * 1000));
+    CHECK_EQ(host_now_ms(), (int64_t)(ALARM_AT(2) + 5 * MINUTE) * 1000);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, ring_and_stop, &next), HOST_EXIT);
+
+    /* Clocks go forward an hour overnight. The alarm is for wall clock
+    * time, so it rings at 07:30 on the new time.
+    */
+    host_set_time(ALARM_AT(3) - 5 * HOUR - 30 * MINUTE, 0);     /* 02:00 */
+    host_set_time(ALARM_AT(3) - 4 * HOUR - 30 * MINUTE, 0);     /* 03:00 */
+    CHECK(host_sleep(DAY * 1000));
+    CHECK_EQ(host_now_ms(), (int64_t)ALARM_AT(3) * 1000);
+    next = ALARM_AT(4);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, ring_and_stop, &next), HOST_EXIT);
+
+    /* Clocks go back an hour just after it rang, so 07:30 comes round
+    * again. It must not ring twice.
+    */
+    host_set_time(ALARM_AT(3) - 15 * MINUTE, 0);                 /* 07:15 */
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, quiet, &next), HOST_EXIT);
+    CHECK(host_sleep(2 * DAY * 1000));
+    CHECK_EQ(host_now_ms(), (int64_t)ALARM_AT(4) * 1000);
+    next = ALARM_AT(5);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, ring_and_stop, &next), HOST_EXIT);
+
+    /* The watch is off through the next alarm. It is missed, and the app
+    * schedules the one after without ringing late.
+    */
+    now = ALARM_AT(5) + 90 * MINUTE;
+    host_set_time(now, 0);
+    CHECK_EQ(wakeup(), 0);
+    vibes = host_count(HOST_VIBE);
+    next = ALARM_AT(6);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, quiet, &next), HOST_EXIT);
+    CHECK_EQ(host_count(HOST_VIBE), vibes);
+
+    /* Leaving in setting mode arms what was set, 02:00 tomorrow, which is
+    * now sooner than the other two.
+    */
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, leave_setting, NULL), HOST_EXIT);
+    next = ALARM_AT(6) - 5 * HOUR - 30 * MINUTE;
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, quiet, &next), HOST_EXIT);
+
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, set_two, NULL), HOST_EXIT);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, ring_ignored, NULL), HOST_EXIT);
+
+    TEST_DONE();
+}
@@ -0,0 +1,145 @@
+/****************************************************************************/
+/**
+* Calendar cache tests. caltime_get() has to agree with localtime() on
+* every field, a second or a few at a time through a whole year and
+* with the clock now and then set back, in UTC as on the watch. In zones
+* with daylight saving, one of them with a half hour shift, the same is
+* done for the day around each change, and the rest of the year is walked
+* more coarsely. A coarse walk also covers every year the watch's clock can
+* reach.
+*
+* @file   test_caltime.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#define _POSIX_C_SOURCE 200112L   /* setenv(), tzset() */
+#include <stdlib.h>
+#include "test.h"
+#include "caltime.h"
+
+
+#define DAY         (24 * 60 * 60)
+#define YEAR        (365 * DAY)
+#define LAST_TIME   (0x7fffffffL - DAY)     /* the watch has 32 bit time_t */
+
+/* POSIX rules, so no zone files are needed. The last moves by half an hour.
+*/
+static const char *zones[] =
+{
+    "UTC0",
+    "EST5EDT,M3.2.0,M11.1.0",
+    "LHST-10:30LHDT-11,M10.1.0,M4.1.0",
+};
+
+
+static bool same(time_t t)
+{
+    struct tm cached = *caltime_get(t);
+    struct tm *tm = localtime(&t);
+
+    return cached.tm_sec == tm->tm_sec
+        && cached.tm_min == tm->tm_min
+        && cached.tm_hour == tm->tm_hour
+        && cached.tm_mday == tm->tm_mday
+        && cached.tm_mon == tm->tm_mon
+        && cached.tm_year == tm->tm_year
+        && cached.tm_wday == tm->tm_wday
+        && cached.tm_yday == tm->tm_yday
+        && cached.tm_isdst == tm->tm_isdst;
+}
+
+
+/* Walk from start to end a second or a few at a time, as the ticks come,
+* now and then jumping back an hour and a bit as if the clock were set.
+* Returns the first time that comes out wrong, or end if none do.
+*/
+static time_t walk(time_t start, time_t end, int max_step)
+{
+    time_t t = start;
+    uint32_t n;
+
+    for (n = 0; t < end; n++)
+    {
+        if (!same(t))
+        {
+            return t;
+        }
+
+        t += 1 + n % max_step;
+        if (n % 99991 == 99990)
+        {
+            t -= 5000;
+        }
+    }
+
+    return end;
+}
+
+
+int main(void)
+{
+    time_t start;
+    time_t t;
+    unsigned int i;
+    bool dst;
+
+    host_reset(TEST_EPOCH);
+
+    for (i = 0; i < sizeof(zones) / sizeof(zones[0]); i++)
+    {
+        setenv("TZ", zones[i], 1);
+        tzset();
+
+        /* Starting before the last call makes the cache start over in the
+        * new zone.
+        */
+        start = TEST_EPOCH - YEAR / 2 - i;
+        if (i == 0)
+        {
+            CHECK_EQ(walk(start, start + YEAR, 5), start + YEAR);
+        }
+        else
+        {
+            CHECK_EQ(walk(start, start + YEAR, 61), start + YEAR);
+
+            dst = localtime(&start)->tm_isdst;
+            for (t = start; t < start + YEAR; t += 3600)
+            {
+                if (localtime(&t)->tm_isdst != dst)
+                {
+                    dst = !dst;
+                    CHECK_EQ(walk(t - DAY / 2 - 3600, t + DAY / 2, 3),
+                             t + DAY / 2);
+                }
+            }
+        }
+
+        /* Leap days, centuries, and the end of 32 bit time, a few hours at
+        * a time.
+        */
+        CHECK_EQ(walk(0, LAST_TIME, 3 * 3600), LAST_TIME);
+    }
+
+    TEST_DONE();
+}
@@ -0,0 +1,192 @@
+/****************************************************************************/
+/**
+* Crash tests. The app is killed, with no deinit, after each change of
+* state and just before each of its flash writes in turn. Every start after
+* that has to find a snapshot that checks out and the changes up to the
+* last one that was written, in order, with a running timer still due at
+* the moment it was started for.
+*
+* @file   test_crash.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "test.h"
+#include "alarm.h"
+#include "resources.h"
+#include "stopwatch.h"
+#include "timer.h"
+
+
+#define STEPS       (3)         /* changes of state in the sequence */
+
+/* TMR1 is started one second in, for a minute.
+*/
+#define TIMER_DUE_MS    ((TEST_EPOCH + 1 + 60) * 1000LL)
+
+
+/* Do one step of the sequence: start TMR1, start the stopwatch, set an
+* alarm. Each starts on the face before it.
+*/
+static void step(int n)
+{
+    host_run(1000);
+    switch (n)
+    {
+    case 0:
+        host_click(BUTTON_ID_DOWN);     /* TMR */
+        host_hold(BUTTON_ID_SELECT);    /* minutes */
+        host_click(BUTTON_ID_UP);
+        host_hold(BUTTON_ID_SELECT);
+        host_click(BUTTON_ID_SELECT);
+        break;
+
+    case 1:
+        host_click(BUTTON_ID_DOWN);     /* STW */
+        host_click(BUTTON_ID_SELECT);
+        break;
+
+    default:
+        host_click(BUTTON_ID_DOWN);     /* ALM */
+        host_hold(BUTTON_ID_SELECT);    /* 00:00 */
+        host_click(BUTTON_ID_SELECT);
+        host_hold(BUTTON_ID_SELECT);    /* ONCE */
+        host_click(BUTTON_ID_SELECT);   /* DAILY */
+        break;
+    }
+}
+
+
+/* The whole sequence, or as much as ctx says, then a crash.
+*/
+static void sequence(void *ctx)
+{
+    int steps = ctx ? *(int *)ctx : STEPS;
+    int n;
+
+    for (n = 0; n < steps; n++)
+    {
+        step(n);
+    }
+
+    host_kill();
+}
+
+
+/* How many steps of the sequence survived, with no gaps.
+*/
+static int survived(void)
+{
+    bool done[STEPS];
+    int steps = 0;
+    int n;
+
+    done[0] = timer_busy(PERSIST_KEY_TIMERS);
+    done[1] = stopwatch_busy(PERSIST_KEY_STW_STATE);
+    done[2] = alarm_busy(PERSIST_KEY_ALARMS);
+
+    while (steps < STEPS && done[steps])
+    {
+        steps++;
+    }
+    for (n = steps; n < STEPS; n++)
+    {
+        if (done[n])
+        {
+            return -1;
+        }
+    }
+
+    return steps;
+}
+
+
+/* Check the state after a crash. At least ctx steps must have survived,
+* and TMR1, if it was started, must still go off when it should.
+*/
+static void check(void *ctx)
+{
+    int steps = survived();
+
+    CHECK(steps >= 0);
+    CHECK(steps >= *(int *)ctx);
+
+    if (steps > 0)
+    {
+        CHECK(host_now_ms() < TIMER_DUE_MS);
+        host_run(TIMER_DUE_MS - 1 - host_now_ms());
+        CHECK(!host_vibing());
+        host_run(1);
+        CHECK(host_vibing());
+        host_click(BUTTON_ID_BACK);
+    }
+}
+
+
+/* A clean start with a snapshot already written, as the watch would be
+* after the first run.
+*/
+static void fresh(void)
+{
+    host_reset(TEST_EPOCH - 10);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, NULL, NULL), HOST_EXIT);
+    host_set_time(TEST_EPOCH, 0);
+}
+
+
+int main(void)
+{
+    uint32_t writes;
+    int steps;
+    int n;
+
+    /* Killed right after each step, every step up to it must be there.
+    */
+    for (steps = 0; steps <= STEPS; steps++)
+    {
+        fresh();
+        CHECK_EQ(host_launch(APP_LAUNCH_USER, sequence, &steps), HOST_KILLED);
+        CHECK_EQ(host_launch(APP_LAUNCH_USER, check, &steps), HOST_EXIT);
+    }
+
+    /* Killed just before each write in turn. Whatever was written is
+    * there, and in order. Each step is a change of state that has to be
+    * saved, so there are at least as many writes as steps.
+    */
+    fresh();
+    writes = host_count(HOST_PERSIST_WRITE);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, sequence, NULL), HOST_KILLED);
+    writes = host_count(HOST_PERSIST_WRITE) - writes;
+    CHECK(writes >= STEPS);
+
+    steps = 0;
+    for (n = 1; n <= (int)writes; n++)
+    {
+        fresh();
+        host_kill_on_write(n);
+        CHECK_EQ(host_launch(APP_LAUNCH_USER, sequence, NULL), HOST_KILLED);
+        CHECK_EQ(host_launch(APP_LAUNCH_USER, check, &steps), HOST_EXIT);
+    }
+
+    TEST_DONE();
+}
@@ -0,0 +1,232 @@
+/****************************************************************************/
+/**
+* Formatting tests. Each fmt routine has to give exactly what the libc call
+* it replaced gave, checked over every value it can be handed: 0-99 for the
+* fields, every day of a 400 year cycle for the dates, every second of two
+* days for the splitter. fmt_uint() is checked up to a million, either
+* side of each power of ten, and at a stride across its whole range.
+*
+* @file   test_fmt.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <ctype.h>
+#include <string.h>
+#include "test.h"
+#include "fmt.h"
+
+
+#define DAY         (24 * 60 * 60)
+#define CYCLE_DAYS  (146097)    /* the Gregorian calendar repeats */
+
+
+/* What the old code did to dates and day names after strftime().
+*/
+static void upcase(char *s)
+{
+    for (; *s; s++)
+    {
+        *s = toupper((unsigned char)*s);
+    }
+}
+
+
+/* Each loop stops at the first value that comes out wrong, and the check
+* after it shows which one that was.
+*/
+static void fields(void)
+{
+    char got[16];
+    char want[16];
+    char *end;
+    int n;
+
+    for (n = 0; n < 100; n++)
+    {
+        end = fmt_2d(got, n);
+        snprintf(want, sizeof(want), "%02d", n);
+        if (strcmp(got, want) != 0 || end != got + strlen(want))
+        {
+            break;
+        }
+
+        end = fmt_2d_space(got, n);
+        snprintf(want, sizeof(want), "%2d", n);
+        if (strcmp(got, want) != 0 || end != got + strlen(want))
+        {
+            break;
+        }
+
+        end = fmt_int(got, n);
+        snprintf(want, sizeof(want), "%d", n);
+        if (strcmp(got, want) != 0 || end != got + strlen(want))
+        {
+            break;
+        }
+    }
+    CHECK_EQ(n, 100);
+
+    /* Out of range is clamped, not garbage.
+    */
+    fmt_2d(got, -1);
+    CHECK(strcmp(got, "00") == 0);
+    fmt_2d(got, 100);
+    CHECK(strcmp(got, "99") == 0);
+    fmt_int(got, 1000);
+    CHECK(strcmp(got, "99") == 0);
+}
+
+
+static void uints(void)
+{
+    char got[16];
+    char want[16];
+    char *end;
+    uint32_t p;
+    uint32_t n;
+    int i;
+
+    for (n = 0; n < 1000000; n++)
+    {
+        end = fmt_uint(got, n);
+        snprintf(want, sizeof(want), "%lu", (unsigned long)n);
+        if (strcmp(got, want) != 0 || end != got + strlen(want))
+        {
+            break;
+        }
+    }
+    CHECK_EQ(n, 1000000);
+
+    for (n = 12345; n < UINT32_MAX - 65537; n += 65537)
+    {
+        fmt_uint(got, n);
+        snprintf(want, sizeof(want), "%lu", (unsigned long)n);
+        if (strcmp(got, want) != 0)
+        {
+            break;
+        }
+    }
+    CHECK(n >= UINT32_MAX - 65537);
+
+    /* Either side of every change in length, and the largest.
+    */
+    for (i = 0, p = 10; i < 9; i++, p *= 10)
+    {
+        for (n = p - 2; n != p + 2; n++)
+        {
+            fmt_uint(got, n);
+            snprintf(want, sizeof(want), "%lu", (unsigned long)n);
+            CHECK(strcmp(got, want) == 0);
+        }
+    }
+    end = fmt_uint(got, UINT32_MAX);
+    CHECK(strcmp(got, "4294967295") == 0);
+    CHECK_EQ(end - got, 10);
+}
+
+
+static void dates(void)
+{
+    char got[16];
+    char want[16];
+    struct tm *tm;
+    time_t t;
+    int day;
+
+    for (day = 0; day < CYCLE_DAYS; day++)
+    {
+        t = (time_t)day * DAY;
+        tm = gmtime(&t);
+
+        fmt_date(got, tm);
+        strftime(want, sizeof(want), "%b %d", tm);
+        upcase(want);
+        if (strcmp(got, want) != 0)
+        {
+            break;
+        }
+
+        fmt_day(got, tm);
+        strftime(want, sizeof(want), "%a", tm);
+        upcase(want);
+        if (strcmp(got, want) != 0)
+        {
+            break;
+        }
+    }
+    CHECK_EQ(day, CYCLE_DAYS);
+}
+
+
+/* The timer faces used gmtime() on the seconds left, and only ever showed
+* the time of day from it. Past a day fmt_split() keeps counting hours.
+*/
+static void splits(void)
+{
+    struct tm split;
+    struct tm *tm;
+    time_t t;
+
+    for (t = 0; t < DAY; t++)
+    {
+        tm = gmtime(&t);
+        fmt_split(t, &split);
+        if (split.tm_hour != tm->tm_hour
+            || split.tm_min != tm->tm_min
+            || split.tm_sec != tm->tm_sec
+            || split.tm_mday != tm->tm_mday
+            || split.tm_mon != tm->tm_mon
+            || split.tm_year != tm->tm_year
+            || split.tm_wday != tm->tm_wday)
+        {
+            break;
+        }
+    }
+    CHECK_EQ(t, DAY);
+
+    for (; t < 2 * DAY; t++)
+    {
+        fmt_split(t, &split);
+        if (split.tm_hour != t / 3600
+            || split.tm_min != t / 60 % 60
+            || split.tm_sec != t % 60)
+        {
+            break;
+        }
+    }
+    CHECK_EQ(t, 2 * DAY);
+}
+
+
+int main(void)
+{
+    host_reset(TEST_EPOCH);
+
+    fields();
+    uints();
+    dates();
+    splits();
+
+    TEST_DONE();
+}
@@ -0,0 +1,96 @@
+/****************************************************************************/
+/**
+* Golden frames. Draws the main face in both invert modes and compares each
+* with a saved frame under test/golden, then checks that the pixel count the
+* stand-in keeps for each redraw is the real number that changed.
+*
+* To make new golden frames after a deliberate change to the look, run
+* "make golden" and check the images in before committing.
+*
+* @file   test_frames.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <stdlib.h>
+#include "test.h"
+
+
+#define GOLDEN_MAIN     "test/golden/main.pbm"
+#define GOLDEN_INVERTED "test/golden/main_inverted.pbm"
+#define SCRATCH         "/tmp/test_frames.pbm"
+
+
+/* Compare the frame on screen with a golden one, or save it as the new
+* golden frame if GOLDEN_UPDATE is set.
+*/
+static void golden(const char *path)
+{
+    if (getenv("GOLDEN_UPDATE"))
+    {
+        CHECK(host_frame_write(path));
+        printf("wrote %s\n", path);
+    }
+    else
+    {
+        CHECK_EQ(host_frame_diff(path), 0);
+    }
+}
+
+
+static void frames(void *ctx)
+{
+    uint32_t pixels;
+
+    /* One second in, so the seconds field isn't blank.
+    */
+    host_run(1000);
+    golden(GOLDEN_MAIN);
+
+    /* The inverter covers the whole screen, so every pixel flips.
+    */
+    host_multi_click(BUTTON_ID_BACK, 2);
+    golden(GOLDEN_INVERTED);
+    CHECK_EQ(host_frame_diff(GOLDEN_MAIN), HOST_SCREEN_W * HOST_SCREEN_H);
+    host_multi_click(BUTTON_ID_BACK, 2);
+    CHECK_EQ(host_frame_diff(GOLDEN_MAIN), 0);
+
+    /* The count for a tick is the difference between the frames before
+    * and after it, and only the seconds change.
+    */
+    CHECK(host_frame_write(SCRATCH));
+    pixels = host_count(HOST_PIXELS);
+    host_run(1000);
+    CHECK_EQ(host_count(HOST_PIXELS) - pixels, host_frame_diff(SCRATCH));
+    CHECK(host_frame_diff(SCRATCH) > 0);
+    CHECK(host_frame_diff(SCRATCH) < HOST_SCREEN_W * HOST_SCREEN_H / 20);
+}
+
+
+int main(void)
+{
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, frames, NULL), HOST_EXIT);
+
+    TEST_DONE();
+}
@@ -0,0 +1,83 @@
+/****************************************************************************/
+/**
+* Host stand-in smoke test. Runs the app through a day on the main face,
+* steps through every face, and checks that state saved on exit is there on
+* the next launch.
+*
+* @file   test_host.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "test.h"
+#include "resources.h"
+
+
+static void run_day(void *ctx)
+{
+    host_run(24 * 60 * 60 * 1000);
+}
+
+
+static void every_face(void *ctx)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        host_click(BUTTON_ID_DOWN);
+        host_run(5000);
+    }
+
+    /* Leave it on the next face over, to see it come back there.
+    */
+    host_click(BUTTON_ID_DOWN);
+    host_click(BUTTON_ID_SELECT);
+    host_hold(BUTTON_ID_SELECT);
+    host_multi_click(BUTTON_ID_BACK, 2);
+}
+
+
+int main(void)
+{
+    uint32_t ticks;
+
+    host_reset(TEST_EPOCH);
+
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, run_day, NULL), HOST_EXIT);
+    ticks = host_count(HOST_WAKE_TICK);
+    CHECK(ticks >= 24 * 60 * 60);
+    CHECK(ticks <= 24 * 60 * 60 + 1);
+    CHECK(host_count(HOST_FRAME) >= 24 * 60 * 60);
+    CHECK_EQ(host_now_ms(), (int64_t)(TEST_EPOCH + 24 * 60 * 60) * 1000);
+
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, every_face, NULL), HOST_EXIT);
+    CHECK_EQ(host_count(HOST_LAUNCH), 2);
+    CHECK(host_persist_read(PERSIST_KEY_SNAPSHOT, &ticks, sizeof(ticks)) > 0);
+
+    host_kill_on_write(1);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, every_face, NULL), HOST_KILLED);
+    host_kill_on_write(0);
+
+    TEST_DONE();
+}
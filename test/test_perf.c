@@ -0,0 +1,157 @@
+/****************************************************************************/
+/**
+* Lateness histogram tests. Percentiles read back the top of the bucket they
+* fall in, capped at the latest sample, and early samples count by how early
+* they were. Ticks delivered on time record nothing late; jittered ticks
+* land within the jitter. Clicks are logged per button and per face they
+* were made on.
+*
+* @file   test_perf.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <string.h>
+#include "test.h"
+#include "perf.h"
+
+
+#define JITTER_MS   200
+#define LOG_FILE    "/tmp/test_perf.log"
+
+
+#if PERF
+
+static void histogram(void)
+{
+    int i;
+
+    perf_start();
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TIMER, 50), 0);
+
+    for (i = 0; i < 90; i++)
+    {
+        perf_late(PERF_LATE_TIMER, 0);
+    }
+    for (i = 0; i < 10; i++)
+    {
+        perf_late(PERF_LATE_TIMER, 40);
+    }
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TIMER, 50), 0);
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TIMER, 95), 40);
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TIMER, 100), 40);
+
+    /* 5 ms early lands in the 4-7 bucket, below the 40.
+    */
+    for (i = 0; i < 100; i++)
+    {
+        perf_late(PERF_LATE_TIMER, -5);
+    }
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TIMER, 50), 7);
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TIMER, 100), 40);
+
+    /* Past the last bucket only the max is known.
+    */
+    perf_late(PERF_LATE_TIMER, 5000);
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TIMER, 100), 5000);
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TICK, 100), 0);
+}
+
+
+static void on_time(void *ctx)
+{
+    perf_start();
+    host_run(120000);
+    CHECK_EQ(perf_late_percentile(PERF_LATE_TICK, 100), 0);
+}
+
+
+static void jittered(void *ctx)
+{
+    perf_start();
+    host_tick_jitter(JITTER_MS, 0);
+    host_run(600000);
+    CHECK(perf_late_percentile(PERF_LATE_TICK, 50) > 0);
+    CHECK(perf_late_percentile(PERF_LATE_TICK, 100) <= JITTER_MS);
+    host_tick_jitter(0, 0);
+}
+
+
+/* Whether the log has a line containing text.
+*/
+static bool logged(const char *text)
+{
+    char line[256];
+    FILE *f = fopen(LOG_FILE, "r");
+    bool found = false;
+
+    if (f == NULL)
+    {
+        return false;
+    }
+
+    while (!found && fgets(line, sizeof(line), f))
+    {
+        found = strstr(line, text) != NULL;
+    }
+
+    fclose(f);
+    return found;
+}
+
+
+static void clicks(void *ctx)
+{
+    perf_start();
+    host_click(BUTTON_ID_DOWN);
+    host_click(BUTTON_ID_DOWN);
+    host_click(BUTTON_ID_UP);
+    host_run(1000);
+
+    freopen(LOG_FILE, "w", stderr);
+    host_log_level(APP_LOG_LEVEL_INFO);
+    perf_log();
+    fflush(stderr);
+    host_log_level(APP_LOG_LEVEL_ERROR);
+
+    CHECK(logged("perf click=down/0 n=1 "));
+    CHECK(logged("perf click=down/1 n=1 "));
+    CHECK(logged("perf click=up/2 n=1 "));
+    CHECK(!logged("perf click=sel/"));
+}
+
+#endif
+
+
+int main(void)
+{
+    host_reset(TEST_EPOCH);
+#if PERF
+    histogram();
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, on_time, NULL), HOST_EXIT);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, jittered, NULL), HOST_EXIT);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, clicks, NULL), HOST_EXIT);
+#endif
+
+    TEST_DONE();
+}
@@ -0,0 +1,355 @@
+/****************************************************************************/
+/**
+* Persistent record tests. Records read back exactly as written, in the
+* same launch and the next. The wrong tag or version, or a record too big
+* for the reader, reads as no record, an unchanged record costs no write,
+* and one with no room for it leaves the old one in place. State saved by
+* the app before there were records, under the old per-face keys, is
+* carried over on the first start and the old keys are deleted once it is
+* in the snapshot.
+*
+* @file   test_record.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <string.h>
+#include "test.h"
+#include "display.h"
+#include "record.h"
+#include "resources.h"
+#include "utils.h"
+
+
+#define TEST_KEY    (200)       /* no face uses it */
+
+/* Timer and stopwatch states, as the old blobs and the records have them.
+*/
+#define TIMER_RUN   (4)
+#define TIMER_STOP  (5)
+#define STW_RUN     (1)
+
+/* The state the app saved before records, each face's Private padded out
+* to 128 bytes and written whole under its own key.
+*/
+typedef struct _OldTimer
+{
+    union
+    {
+        struct
+        {
+            int state;
+            void *timer_handle;
+            time_t time_start;
+            time_t time_interval;
+            time_t time_left;
+            time_t time_end;
+            time_t time_now;
+            bool visible;
+        };
+        uint8_t reserved[128];
+    };
+}
+OldTimer;
+
+typedef struct _OldStopwatch
+{
+    union
+    {
+        struct
+        {
+            int state;
+            void *timer;
+            TimeMS start_time;
+            TimeMS last_time;
+            TimeMS split_time;
+            TimeMS lap_time;
+            bool visible;
+            TimeMS stop_time;
+        };
+        uint8_t reserved[128];
+    };
+}
+OldStopwatch;
+
+typedef struct _OldActive
+{
+    int face;                   /* 0 MAIN, 1 TMR1, 2 TMR2, 3 STW */
+    int invert_mode;
+}
+OldActive;
+
+/* The stopwatch record, version 1. It is what is on the watch's flash, so
+* it can't change without a new version.
+*/
+typedef struct _StopwatchRecord
+{
+    int32_t start;
+    int32_t last;
+    int32_t split;
+    int32_t lap;
+    int32_t stop;
+    uint16_t start_ms;
+    uint16_t last_ms;
+    uint16_t split_ms;
+    uint16_t lap_ms;
+    uint16_t stop_ms;
+    uint8_t state;
+    uint8_t spare;
+}
+StopwatchRecord;
+
+/* The timer record, version 1. It is what is on the watch's flash, so it
+* can't change without a new version.
+*/
+typedef struct _TimerRecord
+{
+    int32_t interval;
+    int32_t when;
+    uint16_t ms;
+    uint8_t state;
+    uint8_t spare;
+}
+TimerRecord;
+
+
+/* Write, read back, and the ways a read can miss.
+*/
+static void round_trip(void *ctx)
+{
+    uint8_t data[RECORD_MAX_SIZE] = { 0 };
+    uint8_t back[RECORD_MAX_SIZE];
+    uint32_t writes;
+    int i;
+
+    for (i = 0; i < 16; i++)
+    {
+        data[i] = i * 37 + 1;
+    }
+
+    record_write(TEST_KEY, RECORD_TAG_HUD, 3, data, 16);
+    memset(back, 0xee, sizeof(back));
+    CHECK_EQ(record_read(TEST_KEY, RECORD_TAG_HUD, 3, back, sizeof(back)), 16);
+    CHECK(memcmp(back, data, 16) == 0);
+    CHECK_EQ(back[16], 0xee);
+
+    /* A record too big for the buffer must be a layout the reader doesn't
+    * know, so it is no record at all, and the buffer is left alone.
+    */
+    memset(back, 0, sizeof(back));
+    CHECK_EQ(record_read(TEST_KEY, RECORD_TAG_HUD, 3, back, 8), -1);
+    CHECK_EQ(back[0], 0);
+
+    CHECK_EQ(record_read(TEST_KEY, RECORD_TAG_ZONE, 3, back, 16), -1);
+    CHECK_EQ(record_read(TEST_KEY, RECORD_TAG_HUD, 4, back, 16), -1);
+    CHECK_EQ(record_read(TEST_KEY + 1, RECORD_TAG_HUD, 3, back, 16), -1);
+
+    /* The same again is not written, a change is, and a batch is written
+    * once.
+    */
+    writes = host_count(HOST_PERSIST_WRITE);
+    record_write(TEST_KEY, RECORD_TAG_HUD, 3, data, 16);
+    CHECK_EQ(host_count(HOST_PERSIST_WRITE), writes);
+
+    data[0]++;
+    record_write(TEST_KEY, RECORD_TAG_HUD, 3, data, 16);
+    CHECK_EQ(host_count(HOST_PERSIST_WRITE), writes + 1);
+
+    record_begin();
+    data[1]++;
+    record_write(TEST_KEY, RECORD_TAG_HUD, 3, data, 16);
+    data[2]++;
+    record_write(TEST_KEY, RECORD_TAG_HUD, 3, data, 12);
+    CHECK_EQ(host_count(HOST_PERSIST_WRITE), writes + 1);
+    record_end();
+    CHECK_EQ(host_count(HOST_PERSIST_WRITE), writes + 2);
+    CHECK_EQ(record_read(TEST_KEY, RECORD_TAG_HUD, 3, back, sizeof(back)), 12);
+    CHECK(memcmp(back, data, 12) == 0);
+
+    /* One that can't fit alongside the faces' records is not written, and
+    * the one it would have replaced is still there.
+    */
+    host_log_level(0);          /* the error is expected */
+    record_write(TEST_KEY, RECORD_TAG_HUD, 3, data, RECORD_MAX_SIZE);
+    host_log_level(APP_LOG_LEVEL_ERROR);
+    CHECK_EQ(host_count(HOST_PERSIST_WRITE), writes + 2);
+    CHECK_EQ(record_read(TEST_KEY, RECORD_TAG_HUD, 3, back, sizeof(back)), 12);
+    CHECK(memcmp(back, data, 12) == 0);
+}
+
+
+/* In the next launch, from flash.
+*/
+static void read_back(void *ctx)
+{
+    uint8_t *data = ctx;
+    uint8_t back[16];
+
+    CHECK_EQ(record_read(TEST_KEY, RECORD_TAG_HUD, 3, back, sizeof(back)), 12);
+    CHECK(memcmp(back, data, 12) == 0);
+}
+
+
+/* What the old blobs said: TMR2 on screen, inverted, the date shown, a
+* stopwatch that has been running 100 s, TMR1 running with a minute left,
+* and TMR2 stopped with 30 s left.
+*/
+static void upgraded(void *ctx)
+{
+    StopwatchRecord stopwatch;
+    TimerRecord timers[2];
+    OldActive active;
+    uint8_t day_flag = 0;
+
+    CHECK(display_get_invert());
+    CHECK_EQ(record_read(PERSIST_KEY_MAIN_STATE, RECORD_TAG_MAIN, 1,
+                         &active, sizeof(active)), sizeof(active));
+    CHECK_EQ(active.face, 1);   /* both old timers are the one TMR face */
+    CHECK_EQ(record_read(PERSIST_KEY_WATCH_STATE, RECORD_TAG_WATCH, 1,
+                         &day_flag, sizeof(day_flag)), 1);
+    CHECK_EQ(day_flag, 1);
+
+    CHECK_EQ(record_read(PERSIST_KEY_STW_STATE, RECORD_TAG_STOPWATCH, 1,
+                         &stopwatch, sizeof(stopwatch)), sizeof(stopwatch));
+    CHECK_EQ(stopwatch.state, STW_RUN);
+    CHECK_EQ(stopwatch.start, TEST_EPOCH - 100);
+
+    CHECK_EQ(record_read(PERSIST_KEY_TIMERS, RECORD_TAG_TIMERS, 1,
+                         timers, sizeof(timers)), sizeof(timers));
+    CHECK_EQ(timers[0].state, TIMER_RUN);
+    CHECK_EQ(timers[0].interval, 120);
+    CHECK_EQ(timers[0].when, TEST_EPOCH + 60);
+    CHECK_EQ(timers[0].ms, 0);
+    CHECK_EQ(timers[1].state, TIMER_STOP);
+    CHECK_EQ(timers[1].interval, 600);
+    CHECK_EQ(timers[1].when, 30);
+    CHECK_EQ(timers[1].ms, 0);
+
+    host_run(59 * 1000);
+    CHECK(!host_vibing());
+    host_run(1000);
+    CHECK(host_vibing());
+    host_click(BUTTON_ID_BACK);
+}
+
+
+/* TMR1 has rung and been stopped, the rest is as it was.
+*/
+static void stays_upgraded(void *ctx)
+{
+    StopwatchRecord stopwatch;
+    TimerRecord timers[2];
+
+    CHECK(display_get_invert());
+
+    CHECK_EQ(record_read(PERSIST_KEY_STW_STATE, RECORD_TAG_STOPWATCH, 1,
+                         &stopwatch, sizeof(stopwatch)), sizeof(stopwatch));
+    CHECK_EQ(stopwatch.state, STW_RUN);
+
+    CHECK_EQ(record_read(PERSIST_KEY_TIMERS, RECORD_TAG_TIMERS, 1,
+                         timers, sizeof(timers)), sizeof(timers));
+    CHECK_EQ(timers[0].interval, 120);
+    CHECK_EQ(timers[1].state, TIMER_STOP);
+    CHECK_EQ(timers[1].when, 30);
+}
+
+
+int main(void)
+{
+    static const uint32_t old_keys[] =
+    {
+        PERSIST_KEY_MAIN_STATE, PERSIST_KEY_WATCH_STATE, PERSIST_KEY_STW_STATE,
+        PERSIST_KEY_TMR1_STATE, PERSIST_KEY_TMR2_STATE,
+    };
+    uint8_t data[16] = { 0 };
+    OldActive active;
+    OldTimer timer;
+    OldStopwatch stopwatch;
+    bool day_flag = true;
+    uint8_t buf[PERSIST_DATA_MAX_LENGTH];
+    unsigned int i;
+
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, round_trip, NULL), HOST_EXIT);
+    for (i = 0; i < 16; i++)
+    {
+        data[i] = i * 37 + 1;
+    }
+    data[0]++;
+    data[1]++;
+    data[2]++;
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, read_back, data), HOST_EXIT);
+
+    /* Upgrade from the old blobs.
+    */
+    host_reset(TEST_EPOCH);
+
+    active.face = 2;
+    active.invert_mode = 1;
+    host_persist_write(PERSIST_KEY_MAIN_STATE, &active, sizeof(active));
+    host_persist_write(PERSIST_KEY_WATCH_STATE, &day_flag, sizeof(day_flag));
+
+    memset(&stopwatch, 0, sizeof(stopwatch));
+    stopwatch.state = STW_RUN;
+    stopwatch.start_time.sec = TEST_EPOCH - 100;
+    stopwatch.visible = true;
+    host_persist_write(PERSIST_KEY_STW_STATE, &stopwatch, sizeof(stopwatch));
+
+    /* Nothing past visible was ever written by the baseline, so it can
+    * hold anything.
+    */
+    memset(&timer, 0xa5, sizeof(timer));
+    timer.state = TIMER_RUN;
+    timer.timer_handle = NULL;
+    timer.time_start = TEST_EPOCH - 60;
+    timer.time_interval = 120;
+    timer.time_left = 0;
+    timer.time_end = TEST_EPOCH + 60;
+    timer.time_now = TEST_EPOCH;
+    timer.visible = false;
+    host_persist_write(PERSIST_KEY_TMR1_STATE, &timer, sizeof(timer));
+
+    memset(&timer, 0xa5, sizeof(timer));
+    timer.state = TIMER_STOP;
+    timer.timer_handle = NULL;
+    timer.time_start = 0;
+    timer.time_interval = 600;
+    timer.time_left = 30;
+    timer.time_end = 0;
+    timer.time_now = TEST_EPOCH;
+    timer.visible = false;
+    host_persist_write(PERSIST_KEY_TMR2_STATE, &timer, sizeof(timer));
+
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, upgraded, NULL), HOST_EXIT);
+    for (i = 0; i < sizeof(old_keys) / sizeof(old_keys[0]); i++)
+    {
+        CHECK(host_persist_read(old_keys[i], buf, sizeof(buf)) < 0);
+    }
+    CHECK(host_persist_read(PERSIST_KEY_SNAPSHOT, buf, sizeof(buf)) > 0);
+
+    /* With the old keys gone it all comes from the snapshot.
+    */
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, stays_upgraded, NULL), HOST_EXIT);
+
+    TEST_DONE();
+}
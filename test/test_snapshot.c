@@ -0,0 +1,221 @@
+/****************************************************************************/
+/**
+* Snapshot tests. A snapshot with the wrong magic, version, size, or CRC, one
+* cut short, or one whose records don't add up, is thrown away whole: the
+* app starts with every face at its defaults, doesn't go looking for the old
+* per-face keys, and writes a good snapshot again.
+*
+* @file   test_snapshot.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <string.h>
+#include "test.h"
+#include "display.h"
+#include "record.h"
+#include "resources.h"
+#include "stopwatch.h"
+#include "timer.h"
+
+
+/* Ways to spoil a good snapshot.
+*/
+typedef enum
+{
+    BAD_MAGIC,
+    BAD_VERSION,
+    BAD_SIZE_LONG,
+    BAD_SIZE_SHORT,
+    BAD_CRC,
+    BAD_TRUNCATED,
+    BAD_HEADER_ONLY,
+    BAD_RECORD_CUT,
+    BAD_COUNT
+}
+Bad;
+
+/* The main state as the app saved it before records.
+*/
+typedef struct _OldActive
+{
+    int face;
+    int invert_mode;
+}
+OldActive;
+
+
+/* The snapshot's CRC-16/CCITT, so a broken snapshot can be made to pass
+* the CRC check and fail only the one after it.
+*/
+static uint16_t crc16(const uint8_t *data, size_t size)
+{
+    uint16_t crc = 0xffff;
+    int bit;
+
+    while (size--)
+    {
+        crc ^= *data++ << 8;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+
+/* Check that the snapshot on flash would pass record_load().
+*/
+static void check_good(void)
+{
+    uint8_t buf[PERSIST_DATA_MAX_LENGTH];
+    SnapshotHeader *header = (SnapshotHeader *)buf;
+    int len = host_persist_read(PERSIST_KEY_SNAPSHOT, buf, sizeof(buf));
+
+    CHECK(len >= (int)sizeof(SnapshotHeader));
+    CHECK_EQ(header->magic[0], 'D');
+    CHECK_EQ(header->magic[1], 'C');
+    CHECK_EQ(header->size, len - sizeof(SnapshotHeader));
+    CHECK_EQ(header->crc, crc16(buf + sizeof(SnapshotHeader), header->size));
+}
+
+
+/* Invert the display and start the stopwatch, so there is something to
+* lose.
+*/
+static void busy(void *ctx)
+{
+    host_multi_click(BUTTON_ID_BACK, 2);
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    host_click(BUTTON_ID_DOWN);         /* STW */
+    host_click(BUTTON_ID_SELECT);
+
+    CHECK(display_get_invert());
+    CHECK(stopwatch_busy(PERSIST_KEY_STW_STATE));
+}
+
+
+static void defaults(void *ctx)
+{
+    CHECK(!display_get_invert());
+    CHECK(!stopwatch_busy(PERSIST_KEY_STW_STATE));
+    CHECK(!timer_busy(PERSIST_KEY_TIMERS));
+}
+
+
+/* Spoil the snapshot in buf, len bytes, one way. Returns the new length.
+*/
+static int spoil(uint8_t *buf, int len, Bad bad)
+{
+    SnapshotHeader *header = (SnapshotHeader *)buf;
+    RecordHeader *record = (RecordHeader *)&buf[len];
+
+    switch (bad)
+    {
+    case BAD_MAGIC:
+        header->magic[1] = 'X';
+        break;
+
+    case BAD_VERSION:
+        header->version++;
+        break;
+
+    case BAD_SIZE_LONG:
+        header->size++;
+        break;
+
+    case BAD_SIZE_SHORT:
+        header->size--;
+        break;
+
+    case BAD_CRC:
+        buf[len - 1] ^= 0x01;
+        break;
+
+    case BAD_TRUNCATED:
+        len--;
+        break;
+
+    case BAD_HEADER_ONLY:
+        len = sizeof(SnapshotHeader) - 1;
+        break;
+
+    case BAD_RECORD_CUT:
+        /* One more record on the end with its header but none of its data,
+        * and a size and CRC to match, so the records that are there can
+        * all still be found.
+        */
+        record->tag = RECORD_TAG_HUD;
+        record->version = 1;
+        record->size = 1;
+        record->key = PERSIST_KEY_SNAPSHOT;
+        len += sizeof(RecordHeader);
+        header->size += sizeof(RecordHeader);
+        header->crc = crc16(buf + sizeof(SnapshotHeader), header->size);
+        break;
+
+    default:
+        break;
+    }
+
+    return len;
+}
+
+
+int main(void)
+{
+    uint8_t good[PERSIST_DATA_MAX_LENGTH];
+    uint8_t buf[PERSIST_DATA_MAX_LENGTH];
+    OldActive active = { 0, 1 };
+    int good_len;
+    int len;
+    int bad;
+
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, busy, NULL), HOST_EXIT);
+    good_len = host_persist_read(PERSIST_KEY_SNAPSHOT, good, sizeof(good));
+    check_good();
+    CHECK(good_len + sizeof(RecordHeader) <= sizeof(good));
+
+    for (bad = 0; bad < BAD_COUNT; bad++)
+    {
+        host_reset(TEST_EPOCH);
+
+        /* Old state that would invert the display if a bad snapshot were
+        * taken for a first start.
+        */
+        host_persist_write(PERSIST_KEY_MAIN_STATE, &active, sizeof(active));
+
+        memcpy(buf, good, good_len);
+        len = spoil(buf, good_len, bad);
+        host_persist_write(PERSIST_KEY_SNAPSHOT, buf, len);
+
+        CHECK_EQ(host_launch(APP_LAUNCH_USER, defaults, NULL), HOST_EXIT);
+        check_good();
+        CHECK_EQ(host_launch(APP_LAUNCH_USER, defaults, NULL), HOST_EXIT);
+    }
+
+    TEST_DONE();
+}
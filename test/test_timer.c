@@ -0,0 +1,231 @@
+/****************************************************************************/
+/**
+* Timer face tests. A countdown of almost a day, with ticks that come late
+* and ticks that never come, and a stop and restart part way through, has
+* to go off within 50 ms of when it should. Timers started out of order go
+* off in deadline order. An alert left to ring gives up and no longer holds
+* back other buzzes.
+*
+* @file   test_timer.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include "test.h"
+#include "resources.h"
+#include "timer.h"
+#include "vibe.h"
+
+
+#define HOUR_MS     (60 * 60 * 1000)
+#define LONGEST     ((23 * 3600 + 59 * 60 + 59) * 1000LL)
+#define SLACK_MS    (50)
+
+
+static void clicks(ButtonId button, int n)
+{
+    while (n-- > 0)
+    {
+        host_click(button);
+    }
+}
+
+
+/* Set TMR1 to 23:59:59 and start it. Ticks are then up to 900 ms late and
+* one in five is dropped. It is stopped for an hour after six hours, so it
+* is due an hour later than it would have been.
+*/
+static void jittered(void *ctx)
+{
+    int64_t due;
+    int64_t rang = 0;
+
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    host_hold(BUTTON_ID_SELECT);        /* minutes */
+    clicks(BUTTON_ID_UP, 59);
+    host_click(BUTTON_ID_SELECT);       /* hours */
+    clicks(BUTTON_ID_UP, 23);
+    host_click(BUTTON_ID_SELECT);       /* seconds */
+    clicks(BUTTON_ID_UP, 59);
+    host_hold(BUTTON_ID_SELECT);
+
+    host_tick_jitter(900, 20);
+    host_run(437);                      /* start part way into a second */
+    host_click(BUTTON_ID_SELECT);
+    due = host_now_ms() + LONGEST + HOUR_MS;
+
+    host_run(6 * HOUR_MS);
+    host_click(BUTTON_ID_SELECT);
+    host_run(HOUR_MS);
+    host_click(BUTTON_ID_SELECT);
+
+    host_run(due - SLACK_MS - host_now_ms());
+    CHECK(!host_vibing());
+
+    while (host_now_ms() < due + SLACK_MS && !host_vibing())
+    {
+        host_run(1);
+    }
+    if (host_vibing())
+    {
+        rang = host_now_ms();
+    }
+
+    CHECK(rang != 0);
+    CHECK(rang > due - SLACK_MS);
+    CHECK(rang < due + SLACK_MS);
+    host_click(BUTTON_ID_BACK);
+}
+
+
+/* Set the timer on screen to a number of minutes, start it, and show the
+* next one.
+*/
+static void start_minutes(int minutes)
+{
+    host_hold(BUTTON_ID_SELECT);        /* minutes */
+    clicks(BUTTON_ID_UP, minutes);
+    host_hold(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_UP);
+}
+
+
+/* Three timers, started longest first. Each goes off on its own minute and
+* not before.
+*/
+static void pool(void *ctx)
+{
+    int64_t start;
+    int minute;
+
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    start = host_now_ms();
+    start_minutes(3);
+    start_minutes(1);
+    start_minutes(2);
+
+    for (minute = 1; minute <= 3; minute++)
+    {
+        host_run(start + minute * 60 * 1000 - SLACK_MS - host_now_ms());
+        CHECK(!host_vibing());
+        host_run(2 * SLACK_MS);
+        CHECK(host_vibing());
+        host_click(BUTTON_ID_BACK);
+    }
+
+    host_run(60 * 1000);
+    CHECK(!host_vibing());
+}
+
+
+/* Set TMR1 to a minute and start it. Nobody stops the alert; once the
+* ringing gives up the timer is done, and a notify buzzes again.
+*/
+static void ring_ignored(void *ctx)
+{
+    uint32_t vibes;
+
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    host_hold(BUTTON_ID_SELECT);        /* minutes */
+    host_click(BUTTON_ID_UP);
+    host_hold(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_SELECT);
+
+    host_run(60 * 1000 + SLACK_MS);
+    CHECK(host_vibing());
+
+    host_run(VIBE_MAX_PERIODS * VIBE_PERIOD_MS);
+    CHECK(!host_vibing());
+    CHECK(!timer_busy(PERSIST_KEY_TIMERS));
+    vibes = host_count(HOST_VIBE);
+    host_run(60 * 1000);
+    CHECK_EQ(host_count(HOST_VIBE), vibes);
+
+    vibe_notify();
+    CHECK_EQ(host_count(HOST_VIBE), vibes + 1);
+    host_click(BUTTON_ID_BACK);
+}
+
+
+/* TMR1 goes off at a minute and TMR2 joins in half a minute later. The
+* ringing still gives up VIBE_MAX_PERIODS after TMR1 started it.
+*/
+static void late_joiner(void *ctx)
+{
+    int64_t start;
+    uint32_t vibes;
+
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    start = host_now_ms();
+    start_minutes(1);
+    host_hold(BUTTON_ID_SELECT);        /* minutes */
+    clicks(BUTTON_ID_UP, 1);
+    host_click(BUTTON_ID_SELECT);       /* hours */
+    host_click(BUTTON_ID_SELECT);       /* seconds */
+    clicks(BUTTON_ID_UP, 30);
+    host_hold(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_SELECT);
+
+    host_run(start + 90 * 1000 + SLACK_MS - host_now_ms());
+    CHECK(host_vibing());
+
+    host_run(start + 60 * 1000 + VIBE_MAX_PERIODS * VIBE_PERIOD_MS +
+             SLACK_MS - host_now_ms());
+    CHECK(!host_vibing());
+    vibes = host_count(HOST_VIBE);
+    host_run(60 * 1000);
+    CHECK_EQ(host_count(HOST_VIBE), vibes);
+    host_click(BUTTON_ID_BACK);
+}
+
+
+/* Launched again after the ringing gave up. Nothing rings.
+*/
+static void quiet(void *ctx)
+{
+    uint32_t vibes = host_count(HOST_VIBE);
+
+    host_run(10 * 1000);
+    CHECK(!host_vibing());
+    CHECK_EQ(host_count(HOST_VIBE), vibes);
+}
+
+
+int main(void)
+{
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, jittered, NULL), HOST_EXIT);
+
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, pool, NULL), HOST_EXIT);
+
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, ring_ignored, NULL), HOST_EXIT);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, quiet, NULL), HOST_EXIT);
+
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, late_joiner, NULL), HOST_EXIT);
+
+    TEST_DONE();
+}
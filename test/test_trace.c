@@ -0,0 +1,238 @@
+/****************************************************************************/
+/**
+* Event trace tests. A triple click of BACK dumps the trace without leaving
+* the app, a double click still inverts the display, and each click is
+* followed by a FRAME event when the frame that shows it is drawn. The dump
+* gives the time to the first frame, and only the faces that are needed are
+* created before it.
+*
+* @file   test_trace.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <string.h>
+#include "test.h"
+#include "display.h"
+#include "hud.h"
+#include "perf.h"
+#include "trace.h"
+
+
+#define LOG_FILE    "/tmp/test_trace.log"
+#define ALL_FACES   (HUD ? 6 : 5)
+
+
+#if TRACE
+
+/* Events in the last dump in the log, in order, how many dumps there were,
+* and the time to the first frame from the last one.
+*/
+static int read_dump(uint8_t *events, int max, int *dumps, long *startup)
+{
+    char line[512];
+    FILE *f = fopen(LOG_FILE, "r");
+    int n = 0;
+
+    *dumps = 0;
+    if (f == NULL)
+    {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        char *s = strstr(line, "trace ");
+        size_t i;
+
+        if (s == NULL)
+        {
+            continue;
+        }
+        if (strncmp(s, "trace start=", 12) == 0)
+        {
+            char *p = strstr(s, "startup=");
+
+            *startup = p ? strtol(p + 8, NULL, 10) : -2;
+            (*dumps)++;
+            n = 0;
+            continue;
+        }
+
+        /* Each record is 8 bytes as hex, the event is the fifth byte.
+        */
+        s += 6;
+        for (i = 0; i + 16 <= strcspn(s, "\n"); i += 16)
+        {
+            unsigned int event;
+
+            if (n < max && sscanf(s + i + 8, "%2x", &event) == 1)
+            {
+                events[n++] = event;
+            }
+        }
+    }
+
+    fclose(f);
+    return n;
+}
+
+
+static void dump(void *ctx)
+{
+    uint8_t events[TRACE_SIZE];
+    int dumps;
+    long startup;
+    int n;
+    int i;
+    int clicks = 0;
+    int framed = 0;
+    bool pending = false;
+
+    freopen(LOG_FILE, "w", stderr);
+    host_log_level(APP_LOG_LEVEL_INFO);
+
+    host_run(3000);
+    host_click(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_DOWN);
+    host_run(1000);
+
+    host_multi_click(BUTTON_ID_BACK, 3);
+    CHECK(!display_get_invert());
+    fflush(stderr);
+
+    n = read_dump(events, TRACE_SIZE, &dumps, &startup);
+    CHECK_EQ(dumps, 1);
+    CHECK(startup >= 0);
+
+    /* Every click has a frame drawn after it.
+    */
+    for (i = 0; i < n; i++)
+    {
+        if (events[i] == TRACE_CLICK)
+        {
+            clicks++;
+            pending = true;
+        }
+        else if (events[i] == TRACE_FRAME && pending)
+        {
+            framed++;
+            pending = false;
+        }
+    }
+    CHECK_EQ(clicks, 3);
+    CHECK_EQ(framed, 2);
+    CHECK(pending);             /* the triple click itself, not drawn yet */
+
+    host_multi_click(BUTTON_ID_BACK, 2);
+    CHECK(display_get_invert());
+    host_multi_click(BUTTON_ID_BACK, 2);
+    CHECK(!display_get_invert());
+
+    host_log_level(APP_LOG_LEVEL_ERROR);
+}
+
+
+/* Dump at once and check how many faces were created before the first
+* frame, which has to be there and agree with the perf counter.
+*/
+static void created(void *ctx)
+{
+    uint8_t events[TRACE_SIZE];
+    int dumps;
+    long startup;
+    int faces = 0;
+    int n;
+    int i;
+
+    freopen(LOG_FILE, "w", stderr);
+    host_log_level(APP_LOG_LEVEL_INFO);
+    host_multi_click(BUTTON_ID_BACK, 3);
+    host_log_level(APP_LOG_LEVEL_ERROR);
+    fflush(stderr);
+
+    n = read_dump(events, TRACE_SIZE, &dumps, &startup);
+    CHECK_EQ(dumps, 1);
+    CHECK(startup >= 0);
+#if PERF
+    CHECK_EQ(startup, (long)perf_get(PERF_STARTUP_MS));
+#endif
+
+    for (i = 0; i < n && events[i] != TRACE_FRAME; i++)
+    {
+        if (events[i] == TRACE_FACE_CREATE)
+        {
+            faces++;
+        }
+    }
+    CHECK_EQ(faces, *(int *)ctx);
+}
+
+
+/* Set alarm 1 for midnight, every day.
+*/
+static void set_alarm(void *ctx)
+{
+    host_click(BUTTON_ID_DOWN);         /* TMR */
+    host_click(BUTTON_ID_DOWN);         /* STW */
+    host_click(BUTTON_ID_DOWN);         /* ALM */
+    host_hold(BUTTON_ID_SELECT);
+    host_click(BUTTON_ID_SELECT);
+    host_hold(BUTTON_ID_SELECT);        /* ONCE */
+    host_click(BUTTON_ID_SELECT);       /* DAILY */
+    host_click(BUTTON_ID_DOWN);         /* ZONE */
+#if HUD
+    host_click(BUTTON_ID_DOWN);         /* PERF */
+#endif
+    host_click(BUTTON_ID_DOWN);         /* MAIN */
+}
+
+#endif
+
+
+int main(void)
+{
+#if TRACE
+    int faces;
+#endif
+
+    host_reset(TEST_EPOCH);
+#if TRACE
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, dump, NULL), HOST_EXIT);
+
+    /* The first start, with no snapshot yet, creates every face to take
+    * over their old keys. After that, with nothing running, only the main
+    * face. With an alarm set, the alarm face as well, for its wakeup. A
+    * LAZY_FACES=0 build creates them all every time.
+    */
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, NULL, NULL), HOST_EXIT);
+    faces = LAZY_FACES ? 1 : ALL_FACES;
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, created, &faces), HOST_EXIT);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, set_alarm, NULL), HOST_EXIT);
+    faces = LAZY_FACES ? 2 : ALL_FACES;
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, created, &faces), HOST_EXIT);
+#endif
+
+    TEST_DONE();
+}
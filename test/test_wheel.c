@@ -0,0 +1,207 @@
+/****************************************************************************/
+/**
+* Timer wheel tests. No callback runs before its deadline or more than
+* WHEEL_SLACK_MS after it, deadlines that close together share one wakeup,
+* and cancelling, moving, and re-arming from inside a callback all work.
+*
+* @file   test_wheel.c
+*
+* @author Bob Hauck <bobh@haucks.org>
+*
+* Copyright (c) 2014, Bob Hauck
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*****************************************************************************/
+#include <string.h>
+#include "test.h"
+#include "wheel.h"
+
+
+#define TIMERS      (32)
+#define ROUNDS      (200)
+
+
+typedef struct _Probe
+{
+    WheelTimer timer;
+    int64_t due;                /* when it should run */
+    int64_t ran;                /* when it did, 0 = not yet */
+    int runs;
+    int rearm;                  /* times to schedule itself again */
+}
+Probe;
+
+static Probe probes[TIMERS];
+static uint32_t seed = 12345;
+
+
+static uint32_t random_ms(uint32_t max)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) % (max + 1);
+}
+
+
+static void ran(void *data)
+{
+    Probe *p = data;
+
+    p->ran = host_now_ms();
+    p->runs++;
+
+    CHECK(p->ran >= p->due);
+    CHECK(p->ran <= p->due + WHEEL_SLACK_MS);
+
+    if (p->rearm > 0)
+    {
+        p->rearm--;
+        p->due = host_now_ms() + 250;
+        wheel_schedule(&p->timer, 250, ran, p);
+    }
+}
+
+
+static void schedule(Probe *p, uint32_t ms)
+{
+    p->due = host_now_ms() + ms;
+    p->ran = 0;
+    wheel_schedule(&p->timer, ms, ran, p);
+}
+
+
+static void reset_probes(void)
+{
+    int i;
+
+    memset(probes, 0, sizeof(probes));
+    for (i = 0; i < TIMERS; i++)
+    {
+        wheel_timer_init(&probes[i].timer);
+    }
+}
+
+
+/* Many rounds of timers at random times, some of them moved or cancelled
+* before they are due. None may run early or too late, and a cancelled one
+* never runs.
+*/
+static void never_early(void *ctx)
+{
+    bool cancelled[TIMERS];
+    int round;
+    int i;
+
+    for (round = 0; round < ROUNDS; round++)
+    {
+        reset_probes();
+        host_run(random_ms(999));
+
+        for (i = 0; i < TIMERS; i++)
+        {
+            schedule(&probes[i], random_ms(3000));
+        }
+
+        /* Move some and cancel others, part way through.
+        */
+        host_run(random_ms(500));
+        for (i = 0; i < TIMERS; i++)
+        {
+            cancelled[i] = false;
+            if (probes[i].ran == 0)
+            {
+                switch (random_ms(3))
+                {
+                case 0:
+                    schedule(&probes[i], random_ms(3000));
+                    break;
+
+                case 1:
+                    wheel_cancel(&probes[i].timer);
+                    CHECK(!wheel_pending(&probes[i].timer));
+                    cancelled[i] = true;
+                    break;
+
+                default:
+                    break;
+                }
+            }
+        }
+
+        host_run(4000);
+        for (i = 0; i < TIMERS; i++)
+        {
+            CHECK_EQ(probes[i].runs, cancelled[i] ? 0 : 1);
+            CHECK(!wheel_pending(&probes[i].timer));
+        }
+    }
+}
+
+
+/* Deadlines within WHEEL_SLACK_MS of each other cost one wakeup, ones
+* further apart a wakeup each.
+*/
+static void coalesced(void *ctx)
+{
+    uint32_t wakes;
+    int i;
+
+    reset_probes();
+    wakes = host_count(HOST_WAKE_TIMER);
+    for (i = 0; i < 8; i++)
+    {
+        schedule(&probes[i], 1000 + i * WHEEL_SLACK_MS / 8);
+    }
+    host_run(2000);
+    CHECK_EQ(host_count(HOST_WAKE_TIMER) - wakes, 1);
+    for (i = 0; i < 8; i++)
+    {
+        CHECK_EQ(probes[i].runs, 1);
+    }
+
+    reset_probes();
+    wakes = host_count(HOST_WAKE_TIMER);
+    for (i = 0; i < 8; i++)
+    {
+        schedule(&probes[i], 1000 + i * 100);
+    }
+    host_run(2000);
+    CHECK_EQ(host_count(HOST_WAKE_TIMER) - wakes, 8);
+
+    /* A callback that schedules itself again keeps going, one wakeup per
+    * run.
+    */
+    reset_probes();
+    wakes = host_count(HOST_WAKE_TIMER);
+    probes[0].rearm = 4;
+    schedule(&probes[0], 100);
+    host_run(2000);
+    CHECK_EQ(probes[0].runs, 5);
+    CHECK_EQ(host_count(HOST_WAKE_TIMER) - wakes, 5);
+}
+
+
+int main(void)
+{
+    host_reset(TEST_EPOCH);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, never_early, NULL), HOST_EXIT);
+    CHECK_EQ(host_launch(APP_LAUNCH_USER, coalesced, NULL), HOST_EXIT);
+
+    TEST_DONE();
+}
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+#
+# Pre-rasterize the display glyphs into a single 1-bit atlas image plus the
+# table that says where each glyph is. Run from the top of the tree after
+# changing a font or the character sets, and commit both outputs:
+#
+#       resources/images/glyph_atlas.png
+#       src/glyphs.c
+#
+# Needs Pillow (pip install pillow).
+#
+
+from PIL import Image, ImageDraw, ImageFont
+
+FONTS = [
+    # name, file, size, characters
+    ('LARGE', 'resources/fonts/Roboto-Bold.ttf', 42, '0123456789:'),
+    ('MEDIUM', 'resources/fonts/Roboto-Condensed.ttf', 22,
+     '0123456789:.+-/%ABCDEFGHIJKLMNOPQRSTUVWXYZ'),
+]
+
+ATLAS_W = 160           # multiple of 32 so bitmap rows don't waste padding
+THRESHOLD = 128         # anti-aliased pixels at least this bright are set
+
+PNG_OUT = 'resources/images/glyph_atlas.png'
+C_OUT = 'src/glyphs.c'
+
+
+def render(fonts):
+    strips = []
+
+    for name, path, size, chars in fonts:
+        font = ImageFont.truetype(path, size)
+        top = min(font.getbbox(c)[1] for c in chars)
+        bottom = max(font.getbbox(c)[3] for c in chars)
+        height = bottom - top
+        cells = []
+
+        for c in chars:
+            w = int(round(font.getlength(c)))
+            img = Image.new('L', (w, height), 0)
+            ImageDraw.Draw(img).text((0, -top), c, font=font, fill=255)
+            cells.append((c, img.point(lambda p: 255 if p >= THRESHOLD else 0)))
+
+        space = int(round(font.getlength(' ')))
+        strips.append((name, top, height, space, cells))
+
+    return strips
+
+
+def pack(strips):
+    x = y = 0
+    placed = []
+
+    for name, top, height, space, cells in strips:
+        if x:
+            x = 0
+            y += row_h
+        row_h = height
+        glyphs = []
+
+        for c, img in cells:
+            if x + img.width > ATLAS_W:
+                x = 0
+                y += height
+            glyphs.append((c, x, y, img))
+            x += img.width
+
+        placed.append((name, top, height, space, glyphs))
+
+    atlas = Image.new('1', (ATLAS_W, y + row_h), 0)
+    for name, top, height, space, glyphs in placed:
+        for c, gx, gy, img in glyphs:
+            atlas.paste(img.convert('1'), (gx, gy))
+
+    return atlas, placed
+
+
+def write_c(placed):
+    out = []
+    out.append('/* Generated by tools/mkglyphs.py, do not edit. */')
+    out.append('#include "glyphs.h"')
+    out.append('')
+
+    for name, top, height, space, glyphs in placed:
+        lname = name.lower()
+        index = [-1] * 96
+
+        out.append('')
+        out.append('static const Glyph glyphs_%s[] =' % lname)
+        out.append('{')
+        for i, (c, gx, gy, img) in enumerate(glyphs):
+            index[ord(c) - 32] = i
+            out.append("    {%3d, %3d, %2d},  /* '%s' */" % (gx, gy, img.width, c))
+        out.append('};')
+        out.append('')
+        out.append('static const int8_t index_%s[96] =' % lname)
+        out.append('{')
+        for row in range(0, 96, 16):
+            out.append('    ' + ', '.join('%2d' % v for v in index[row:row + 16]) + ',')
+        out.append('};')
+
+    out.append('')
+    out.append('')
+    out.append('const GlyphFont glyph_fonts[GLYPH_FONT_COUNT] =')
+    out.append('{')
+    for name, top, height, space, glyphs in placed:
+        lname = name.lower()
+        out.append('    {glyphs_%s, index_%s, %d, %d, %d},' % (lname, lname, top, height, space))
+    out.append('};')
+
+    with open(C_OUT, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    atlas, placed = pack(render(FONTS))
+    atlas.save(PNG_OUT)
+    write_c(placed)
+    print('%s: %dx%d' % (PNG_OUT, atlas.width, atlas.height))
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+#
+# Build the time zone rule table for the zone face from the system tz
+# database. Run from the top of the tree after changing the zone list, and
+# commit the output:
+#
+#       resources/data/zones.bin
+#
+# Only the current rule of each zone is kept, taken from the POSIX TZ string
+# at the end of its tzfile, so the table stays good until a government moves
+# its DST dates. Rebuild it when that happens.
+#
+# Layout, little endian, must match src/zone.c:
+#
+#       header  'T' 'Z' version count
+#       record  name[4] std_offset dst_offset start end       16 bytes each
+#       rule    month week<<4|wday at                          4 bytes each
+#
+# Offsets are minutes east of UTC. A rule's 'at' is minutes past local
+# midnight in the offset in effect before the change. Month 0 means no DST.
+#
+
+import re
+import struct
+
+ZONES = [
+    # name, tz database zone
+    ('UTC', 'Etc/UTC'),
+    ('LON', 'Europe/London'),
+    ('PAR', 'Europe/Paris'),
+    ('ATH', 'Europe/Athens'),
+    ('MOW', 'Europe/Moscow'),
+    ('DXB', 'Asia/Dubai'),
+    ('DEL', 'Asia/Kolkata'),
+    ('KTM', 'Asia/Kathmandu'),
+    ('BKK', 'Asia/Bangkok'),
+    ('HKG', 'Asia/Hong_Kong'),
+    ('TYO', 'Asia/Tokyo'),
+    ('ADL', 'Australia/Adelaide'),
+    ('SYD', 'Australia/Sydney'),
+    ('AKL', 'Pacific/Auckland'),
+    ('HNL', 'Pacific/Honolulu'),
+    ('ANC', 'America/Anchorage'),
+    ('LAX', 'America/Los_Angeles'),
+    ('DEN', 'America/Denver'),
+    ('CHI', 'America/Chicago'),
+    ('NYC', 'America/New_York'),
+    ('YHZ', 'America/Halifax'),
+    ('YYT', 'America/St_Johns'),
+    ('SCL', 'America/Santiago'),
+    ('RIO', 'America/Sao_Paulo'),
+]
+
+ZONEINFO = '/usr/share/zoneinfo'
+BIN_OUT = 'resources/data/zones.bin'
+VERSION = 1
+
+HEADER = struct.Struct('<2sBB')
+RULE = struct.Struct('<BBh')
+RECORD = struct.Struct('<4shh4s4s')
+
+TZ_RE = re.compile(r'^(<[^>]*>|[A-Za-z]+)([-+]?[\d:]+)'
+                   r'(?:(<[^>]*>|[A-Za-z]+)([-+]?[\d:]+)?'
+                   r',(M[\d.]+(?:/[-+]?[\d:]+)?),(M[\d.]+(?:/[-+]?[\d:]+)?))?$')
+
+
+def minutes(hms):
+    sign = -1 if hms.startswith('-') else 1
+    parts = [int(p) for p in hms.lstrip('+-').split(':')] + [0, 0]
+    return sign * (parts[0] * 60 + parts[1])
+
+
+def rule(text):
+    date, _, at = text.partition('/')
+    month, week, wday = (int(n) for n in date[1:].split('.'))
+    return RULE.pack(month, week << 4 | wday, minutes(at) if at else 120)
+
+
+def posix_tz(zone):
+    with open('%s/%s' % (ZONEINFO, zone), 'rb') as f:
+        footer = f.read().rstrip(b'\n').rsplit(b'\n', 1)[-1]
+    return footer.decode('ascii')
+
+
+def record(name, zone):
+    tz = posix_tz(zone)
+    m = TZ_RE.match(tz)
+    if not m:
+        raise SystemExit('%s: rule %r not supported' % (zone, tz))
+
+    # POSIX offsets are hours west of UTC, the table wants minutes east.
+    std = -minutes(m.group(2))
+    if m.group(3):
+        dst = -minutes(m.group(4)) if m.group(4) else std + 60
+        start, end = rule(m.group(5)), rule(m.group(6))
+    else:
+        dst = std
+        start = end = RULE.pack(0, 0, 0)
+
+    return RECORD.pack(name.encode('ascii'), std, dst, start, end)
+
+
+if __name__ == '__main__':
+    data = HEADER.pack(b'TZ', VERSION, len(ZONES))
+    for name, zone in ZONES:
+        data += record(name, zone)
+
+    with open(BIN_OUT, 'wb') as f:
+        f.write(data)
+    print('%s: %d zones, %d bytes' % (BIN_OUT, len(ZONES), len(data)))
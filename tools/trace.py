@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+#
+# Decode the event trace the app writes to the log (see src/trace.h) into a
+# timeline and latency histograms. The app dumps the trace on exit, and when
+# BACK is clicked three times. Feed it the app log:
+#
+#       pebble logs > log.txt       (triple-click BACK, then ^C)
+#       tools/trace.py log.txt
+#
+# or pipe the log in on stdin. Only the "trace" lines are looked at, and if
+# the log holds several dumps only the last one is decoded.
+#
+
+import re
+import struct
+import sys
+
+RECORD = struct.Struct('<IBBh')
+
+# Must match TraceEvent in src/trace.h.
+EVENTS = ['NONE', 'TICK', 'CLICK', 'LOAD', 'UNLOAD', 'FIELD', 'TIMER',
+          'VIBE', 'PERSIST', 'FRAME', 'CREATE']
+
+# Must match ButtonId in the SDK, FieldId in src/display.c, and the persist
+# keys in src/resources.h.
+BUTTONS = ['BACK', 'UP', 'SELECT', 'DOWN']
+FIELDS = ['HOUR', 'HM', 'MINS', 'SECS', 'AMPM', 'DATE']
+KEYS = ['MAIN', 'WATCH', 'STW', 'TMR1', 'TMR2', 'HUD', 'TMR', 'ALM', 'ZONE',
+        'SNAP']
+UNITS = ['SEC', 'MIN', 'HOUR', 'DAY', 'MONTH', 'YEAR']
+
+START_RE = re.compile(r'trace start=(\d+)\.(\d+) startup=(-?\d+) count=(\d+)')
+DATA_RE = re.compile(r'trace ([0-9a-f]+)\s*$')
+
+
+def name(table, i):
+    return table[i] if 0 <= i < len(table) else str(i)
+
+
+def read_dump(lines):
+    start = None
+    first_frame = None
+    records = []
+
+    for line in lines:
+        m = START_RE.search(line)
+        if m:
+            start = int(m.group(1)) + int(m.group(2)) / 1000.0
+            first_frame = int(m.group(3))
+            records = []
+            continue
+
+        m = DATA_RE.search(line)
+        if m and start is not None:
+            data = bytes.fromhex(m.group(1))
+            for off in range(0, len(data) - RECORD.size + 1, RECORD.size):
+                records.append(RECORD.unpack_from(data, off))
+
+    return start, first_frame, records
+
+
+def describe(event, a, b):
+    ev = name(EVENTS, event)
+
+    if ev == 'TICK':
+        units = [u for i, u in enumerate(UNITS) if a & (1 << i)]
+        return '%s late %d ms' % ('|'.join(units) or '0', b)
+    if ev == 'CLICK':
+        kind = 'long' if b == 0 else 'x%d' % b
+        return '%s %s' % (name(BUTTONS, a), kind)
+    if ev in ('LOAD', 'UNLOAD', 'CREATE'):
+        return 'face %d' % a
+    if ev == 'FIELD':
+        return '%s=%d' % (name(FIELDS, a), b)
+    if ev == 'TIMER':
+        return '%d due, late %d ms' % (a, b)
+    if ev == 'VIBE':
+        what = '%d ringing' % a if a else 'notify'
+        return '%s, %d ms on' % (what, b)
+    if ev == 'PERSIST':
+        return '%s %d bytes' % (name(KEYS, a), b)
+    if ev == 'FRAME':
+        return 'drawn in %d ms' % b
+    return '%d %d' % (a, b)
+
+
+def timeline(records):
+    last = records[0][0] if records else 0
+
+    for ms, event, a, b in records:
+        print('%10.3f %+8.3f  %-7s %s' % (ms / 1000.0,
+                                          (ms - last) / 1000.0,
+                                          name(EVENTS, event),
+                                          describe(event, a, b)))
+        last = ms
+
+
+def startup(first_frame, records):
+    """Time from the start of the trace, which is at app start, to the first
+    frame drawn. The app keeps it apart from the ring, so it is there even
+    when the ring has wrapped; the faces created before then are counted
+    only if their events are still in it."""
+    print()
+    if first_frame < 0:
+        print('Startup: no frame drawn')
+        return
+
+    created = [ms for ms, event, a, b in records
+               if name(EVENTS, event) == 'CREATE' and ms <= first_frame]
+    if records and records[0][0] <= first_frame:
+        print('Startup: first frame drawn at %d ms, %d faces created'
+              % (first_frame, len(created)))
+    else:
+        print('Startup: first frame drawn at %d ms' % first_frame)
+
+
+def latencies(records, cause):
+    """Time from each `cause` event to the end of the next frame drawn, which
+    is when the change is on the screen. A field being given a new value
+    only marks it to be drawn."""
+    out = []
+    pending = None
+
+    for ms, event, a, b in records:
+        if name(EVENTS, event) == cause:
+            pending = ms
+        elif name(EVENTS, event) == 'FRAME' and pending is not None:
+            out.append(ms - pending)
+            pending = None
+
+    return out
+
+
+def histogram(title, values):
+    print()
+    print('%s: %d samples' % (title, len(values)))
+    if not values:
+        return
+
+    values = sorted(values)
+    print('  min %d  median %d  p95 %d  max %d ms' % (
+        values[0],
+        values[len(values) // 2],
+        values[min(len(values) - 1, len(values) * 95 // 100)],
+        values[-1]))
+
+    # Power of two buckets, with everything under 1 ms in the first one.
+    buckets = {}
+    for v in values:
+        hi = 1
+        while hi <= v:
+            hi *= 2
+        buckets[hi] = buckets.get(hi, 0) + 1
+
+    for hi in sorted(buckets):
+        lo = 0 if hi == 1 else hi // 2
+        count = buckets[hi]
+        print('  %5d-%-5d %5d %s' % (lo, hi - 1, count,
+                                     '#' * min(count, 60)))
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1]) as f:
+            start, first_frame, records = read_dump(f)
+    else:
+        start, first_frame, records = read_dump(sys.stdin)
+
+    if start is None:
+        sys.exit('no trace dump found')
+
+    print('trace of %d events starting at %.3f' % (len(records), start))
+    print()
+    timeline(records)
+    startup(first_frame, records)
+
+    timers = [b for ms, event, a, b in records
+              if name(EVENTS, event) == 'TIMER']
+    ticks = [b for ms, event, a, b in records
+             if name(EVENTS, event) == 'TICK']
+    histogram('AppTimer lateness', [max(t, 0) for t in timers])
+    histogram('Tick lateness', ticks)
+    histogram('Click to frame drawn', latencies(records, 'CLICK'))
+    histogram('Tick to frame drawn', latencies(records, 'TICK'))
+
+
+if __name__ == '__main__':
+    main()